@@ -0,0 +1,255 @@
+/**
+ * @file arduino_core.cpp
+ * @author Dhiraj Deshmukh (deshmukhdhiraj15@gmail.com)
+ * @brief Contains the host build of String, IPAddress, Print and the UARTs
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <Arduino.h>
+
+#include <cstdio>
+#include <mutex>
+#include <string>
+
+#include "simulation.h"
+
+namespace {
+std::mutex s_stdout_mutex;
+}  // namespace
+
+String::String(const char* value) : value_(value ? value : "") {}
+
+String::String(const std::string& value) : value_(value) {}
+
+String::String(char value) : value_(1, value) {}
+
+String::String(int value) : value_(std::to_string(value)) {}
+
+String::String(unsigned int value) : value_(std::to_string(value)) {}
+
+String::String(long value) : value_(std::to_string(value)) {}
+
+String::String(unsigned long value) : value_(std::to_string(value)) {}
+
+String::String(long long value) : value_(std::to_string(value)) {}
+
+String::String(unsigned long long value) : value_(std::to_string(value)) {}
+
+String::String(float value, unsigned int decimals) : String(double(value), decimals) {}
+
+String::String(double value, unsigned int decimals) {
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "%.*f", int(decimals), value);
+    value_ = buffer;
+}
+
+const char* String::c_str() const {
+    return value_.c_str();
+}
+
+unsigned int String::length() const {
+    return value_.size();
+}
+
+bool String::isEmpty() const {
+    return value_.empty();
+}
+
+long String::toInt() const {
+    return strtol(value_.c_str(), nullptr, 10);
+}
+
+float String::toFloat() const {
+    return strtof(value_.c_str(), nullptr);
+}
+
+int String::indexOf(const String& value, unsigned int from) const {
+    size_t index = value_.find(value.value_, from);
+    return index == std::string::npos ? -1 : int(index);
+}
+
+String String::substring(unsigned int begin) const {
+    return begin < value_.size() ? String(value_.substr(begin)) : String();
+}
+
+String String::substring(unsigned int begin, unsigned int end) const {
+    if (begin > end) {
+        std::swap(begin, end);
+    }
+    return begin < value_.size() ? String(value_.substr(begin, end - begin)) : String();
+}
+
+const std::string& String::str() const {
+    return value_;
+}
+
+char String::operator[](unsigned int index) const {
+    return index < value_.size() ? value_[index] : 0;
+}
+
+bool String::operator==(const String& other) const {
+    return value_ == other.value_;
+}
+
+bool String::operator!=(const String& other) const {
+    return value_ != other.value_;
+}
+
+bool String::operator<(const String& other) const {
+    return value_ < other.value_;
+}
+
+String& String::operator+=(const String& other) {
+    value_ += other.value_;
+    return *this;
+}
+
+String operator+(const String& lhs, const String& rhs) {
+    String result(lhs);
+    result += rhs;
+    return result;
+}
+
+String operator+(const String& lhs, const char* rhs) {
+    return lhs + String(rhs);
+}
+
+String operator+(const char* lhs, const String& rhs) {
+    return String(lhs) + rhs;
+}
+
+IPAddress::IPAddress(uint8_t first, uint8_t second, uint8_t third, uint8_t fourth)
+    : octets_{first, second, third, fourth} {}
+
+String IPAddress::toString() const {
+    char buffer[16];
+    snprintf(buffer, sizeof(buffer), "%u.%u.%u.%u", octets_[0], octets_[1], octets_[2], octets_[3]);
+    return String(buffer);
+}
+
+uint8_t IPAddress::operator[](int index) const {
+    return octets_[index & 3];
+}
+
+bool IPAddress::operator==(const IPAddress& other) const {
+    return std::equal(octets_, octets_ + 4, other.octets_);
+}
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+    size_t written = 0;
+    while (size--) {
+        written += write(*buffer++);
+    }
+    return written;
+}
+
+size_t Print::print(const char* value) {
+    return write(reinterpret_cast<const uint8_t*>(value), strlen(value));
+}
+
+size_t Print::print(const String& value) {
+    return print(value.c_str());
+}
+
+size_t Print::print(char value) {
+    return write(uint8_t(value));
+}
+
+size_t Print::print(int value) {
+    return print(String(value));
+}
+
+size_t Print::print(unsigned int value) {
+    return print(String(value));
+}
+
+size_t Print::print(long value) {
+    return print(String(value));
+}
+
+size_t Print::print(unsigned long value) {
+    return print(String(value));
+}
+
+size_t Print::print(double value, int decimals) {
+    return print(String(value, decimals));
+}
+
+size_t Print::print(const IPAddress& value) {
+    return print(value.toString());
+}
+
+size_t Print::println() {
+    return print("\r\n");
+}
+
+HardwareSerial Serial(0);
+HardwareSerial Serial1(1);
+HardwareSerial Serial2(2);
+
+HardwareSerial::HardwareSerial(int uart_nr) : uart_nr_(uart_nr) {}
+
+void HardwareSerial::begin(unsigned long baud, uint32_t config, int8_t rx_pin, int8_t tx_pin) {
+    is_begun_ = true;
+}
+
+void HardwareSerial::end() {
+    flush();
+    is_begun_ = false;
+}
+
+int HardwareSerial::available() {
+    return 0;
+}
+
+int HardwareSerial::read() {
+    return -1;
+}
+
+size_t HardwareSerial::write(uint8_t value) {
+    return write(&value, 1);
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+    // only UART0 is wired to the console, lines go out whole so that they do
+    // not interleave with the reports of the simulation
+    if (uart_nr_ != 0 || !is_begun_) {
+        return size;
+    }
+    std::lock_guard<std::mutex> lock(s_stdout_mutex);
+    for (size_t i = 0; i < size; i++) {
+        if (buffer[i] == '\n') {
+            fprintf(stdout, "%s\n", line_.c_str());
+            line_.clear();
+        } else if (buffer[i] != '\r') {
+            line_ += char(buffer[i]);
+        }
+    }
+    return size;
+}
+
+void HardwareSerial::flush() {
+    if (uart_nr_ != 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(s_stdout_mutex);
+    if (!line_.empty()) {
+        fprintf(stdout, "%s\n", line_.c_str());
+        line_.clear();
+    }
+    fflush(stdout);
+}
+
+HardwareSerial::operator bool() const {
+    return is_begun_;
+}
+
+void HOST_SIM::Report(const String& message) {
+    std::lock_guard<std::mutex> lock(s_stdout_mutex);
+    fprintf(stdout, "[SIM] %10.3f s %s\n", micros() / 1000000.0, message.c_str());
+    fflush(stdout);
+}
@@ -0,0 +1,326 @@
+/**
+ * @file clock.cpp
+ * @author Dhiraj Deshmukh (deshmukhdhiraj15@gmail.com)
+ * @brief Contains the virtual clock of the host build, a discrete event
+ * scheduler: every wait of the backend goes through one kernel lock, and once
+ * no thread is runnable time jumps to the earliest deadline, so hours of
+ * device time pass in milliseconds
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <Arduino.h>
+#include <dlfcn.h>
+#include <pthread.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <thread>
+
+#include "host_backend.h"
+
+namespace {
+// a runnable thread which did not enter the kernel for this long is taken as
+// blocked outside of it, e.g. on a mutex of the sketch, and time moves on
+const std::chrono::milliseconds WATCHDOG_POLL_INTERVAL(2);
+const int WATCHDOG_STALLED_POLLS = 3;
+
+typedef int (*CREATE_FN)(pthread_t*, const pthread_attr_t*, void* (*)(void*), void*);
+typedef int (*JOIN_FN)(pthread_t, void**);
+
+struct THREAD_STATE {
+    std::condition_variable CONDITION;
+    const void* CHANNEL = nullptr;
+    uint64_t DEADLINE_US = HOST_BACKEND::FOREVER;
+    bool IS_WAITING = false;
+    THREAD_STATE* JOINER = nullptr;
+};
+
+struct KERNEL {
+    std::mutex MUTEX;
+    // threads known to the kernel which are not waiting in it
+    int RUNNABLE = 0;
+    uint64_t ACTIVITY = 0;
+    std::map<pthread_t, THREAD_STATE*> THREADS;
+};
+
+struct THREAD_START {
+    void* (*ROUTINE)(void*);
+    void* ARG;
+    THREAD_STATE* STATE;
+};
+
+/**
+ * @brief Unregisters the thread when it exits
+ *
+ */
+struct THREAD_SLOT {
+    THREAD_STATE* STATE = nullptr;
+    ~THREAD_SLOT();
+};
+
+std::atomic<uint64_t> s_now_us{0};
+thread_local THREAD_SLOT s_thread_slot;
+
+KERNEL& s_GetKernel() {
+    static KERNEL kernel;
+    return kernel;
+}
+
+CREATE_FN s_GetCreate() {
+    static CREATE_FN create = reinterpret_cast<CREATE_FN>(dlsym(RTLD_NEXT, "pthread_create"));
+    return create;
+}
+
+JOIN_FN s_GetJoin() {
+    static JOIN_FN join = reinterpret_cast<JOIN_FN>(dlsym(RTLD_NEXT, "pthread_join"));
+    return join;
+}
+
+void s_Wake(KERNEL& kernel, THREAD_STATE* state) {
+    state->IS_WAITING = false;
+    kernel.RUNNABLE++;
+    state->CONDITION.notify_one();
+}
+
+/**
+ * @brief Moves time to the earliest deadline and wakes the threads waiting
+ * for it, call with the kernel lock held
+ *
+ */
+void s_Advance(KERNEL& kernel) {
+    uint64_t next_us = HOST_BACKEND::FOREVER;
+    for (auto& thread : kernel.THREADS) {
+        if (thread.second->IS_WAITING) {
+            next_us = std::min(next_us, thread.second->DEADLINE_US);
+        }
+    }
+    if (next_us == HOST_BACKEND::FOREVER) {
+        // everybody waits for everybody, nothing will happen any more
+        return;
+    }
+    if (next_us > s_now_us) {
+        s_now_us = next_us;
+    }
+    for (auto& thread : kernel.THREADS) {
+        if (thread.second->IS_WAITING && thread.second->DEADLINE_US <= s_now_us) {
+            s_Wake(kernel, thread.second);
+        }
+    }
+}
+
+/**
+ * @brief Stops running, call with the kernel lock held
+ *
+ */
+void s_Block(KERNEL& kernel, THREAD_STATE& state, const void* channel, uint64_t deadline_us) {
+    state.CHANNEL = channel;
+    state.DEADLINE_US = deadline_us;
+    state.IS_WAITING = true;
+    if (--kernel.RUNNABLE == 0) {
+        s_Advance(kernel);
+    }
+}
+
+/**
+ * @brief Returns the record of the calling thread, registers threads which
+ * were not started through pthread_create() as the main thread, call with
+ * the kernel lock held
+ *
+ */
+THREAD_STATE& s_GetSelf(KERNEL& kernel) {
+    if (s_thread_slot.STATE == nullptr) {
+        s_thread_slot.STATE = new THREAD_STATE();
+        kernel.THREADS[pthread_self()] = s_thread_slot.STATE;
+        kernel.RUNNABLE++;
+    }
+    return *s_thread_slot.STATE;
+}
+
+THREAD_SLOT::~THREAD_SLOT() {
+    if (STATE == nullptr) {
+        return;
+    }
+    KERNEL& kernel = s_GetKernel();
+    std::lock_guard<std::mutex> lock(kernel.MUTEX);
+    kernel.ACTIVITY++;
+    if (STATE->JOINER) {
+        // the joiner runs again before this thread is gone, time stays put
+        STATE->JOINER->IS_WAITING = false;
+        kernel.RUNNABLE++;
+    }
+    kernel.THREADS.erase(pthread_self());
+    delete STATE;
+    STATE = nullptr;
+    if (--kernel.RUNNABLE == 0) {
+        s_Advance(kernel);
+    }
+}
+
+void* s_StartThread(void* arg) {
+    THREAD_START start = *static_cast<THREAD_START*>(arg);
+    delete static_cast<THREAD_START*>(arg);
+    s_thread_slot.STATE = start.STATE;
+    return start.ROUTINE(start.ARG);
+}
+
+void s_RunWatchdog() {
+    KERNEL& kernel = s_GetKernel();
+    uint64_t last_activity = 0;
+    uint64_t last_now_us = 0;
+    int stalled_polls = 0;
+    while (true) {
+        std::this_thread::sleep_for(WATCHDOG_POLL_INTERVAL);
+        std::lock_guard<std::mutex> lock(kernel.MUTEX);
+        bool is_stalled = kernel.RUNNABLE > 0 && kernel.ACTIVITY == last_activity && s_now_us == last_now_us;
+        stalled_polls = is_stalled ? stalled_polls + 1 : 0;
+        last_activity = kernel.ACTIVITY;
+        last_now_us = s_now_us;
+        if (stalled_polls >= WATCHDOG_STALLED_POLLS) {
+            s_Advance(kernel);
+            stalled_polls = 0;
+        }
+    }
+}
+
+void* s_StartWatchdog(void*) {
+    s_RunWatchdog();
+    return nullptr;
+}
+
+// the main thread is runnable from the start, the watchdog is not known to the
+// kernel so that it never holds time back
+const bool s_is_kernel_started = []() {
+    KERNEL& kernel = s_GetKernel();
+    {
+        std::lock_guard<std::mutex> lock(kernel.MUTEX);
+        s_GetSelf(kernel);
+    }
+    pthread_t watchdog;
+    s_GetCreate()(&watchdog, nullptr, s_StartWatchdog, nullptr);
+    pthread_detach(watchdog);
+    return true;
+}();
+}  // namespace
+
+extern "C" int pthread_create(pthread_t* thread, const pthread_attr_t* attr, void* (*start_routine)(void*),
+                              void* arg) noexcept {
+    KERNEL& kernel = s_GetKernel();
+    std::lock_guard<std::mutex> lock(kernel.MUTEX);
+    kernel.ACTIVITY++;
+    // runnable from creation, otherwise time could pass before it first runs
+    THREAD_START* start = new THREAD_START{start_routine, arg, new THREAD_STATE()};
+    THREAD_STATE* state = start->STATE;
+    int result = s_GetCreate()(thread, attr, s_StartThread, start);
+    if (result != 0) {
+        delete state;
+        delete start;
+        return result;
+    }
+    kernel.THREADS[*thread] = state;
+    kernel.RUNNABLE++;
+    return 0;
+}
+
+extern "C" int pthread_join(pthread_t thread, void** value) {
+    KERNEL& kernel = s_GetKernel();
+    {
+        std::lock_guard<std::mutex> lock(kernel.MUTEX);
+        kernel.ACTIVITY++;
+        auto joinee = kernel.THREADS.find(thread);
+        if (joinee != kernel.THREADS.end()) {
+            // made runnable again by the joinee on its way out
+            THREAD_STATE& self = s_GetSelf(kernel);
+            joinee->second->JOINER = &self;
+            s_Block(kernel, self, joinee->second, HOST_BACKEND::FOREVER);
+        }
+    }
+    return s_GetJoin()(thread, value);
+}
+
+uint64_t HOST_BACKEND::NowUs() {
+    return s_now_us;
+}
+
+std::unique_lock<std::mutex> HOST_BACKEND::LockKernel() {
+    KERNEL& kernel = s_GetKernel();
+    std::unique_lock<std::mutex> lock(kernel.MUTEX);
+    kernel.ACTIVITY++;
+    s_GetSelf(kernel);
+    return lock;
+}
+
+bool HOST_BACKEND::WaitUntilUs(std::unique_lock<std::mutex>& kernel_lock, const void* channel, uint64_t deadline_us,
+                               const std::function<bool()>& predicate) {
+    KERNEL& kernel = s_GetKernel();
+    THREAD_STATE& self = s_GetSelf(kernel);
+    while (!predicate()) {
+        if (deadline_us <= s_now_us) {
+            return false;
+        }
+        s_Block(kernel, self, channel, deadline_us);
+        while (self.IS_WAITING) {
+            self.CONDITION.wait(kernel_lock);
+        }
+        kernel.ACTIVITY++;
+    }
+    return true;
+}
+
+void HOST_BACKEND::Notify(const void* channel) {
+    KERNEL& kernel = s_GetKernel();
+    for (auto& thread : kernel.THREADS) {
+        if (thread.second->IS_WAITING && thread.second->CHANNEL == channel) {
+            s_Wake(kernel, thread.second);
+        }
+    }
+}
+
+void HOST_BACKEND::SleepUntilUs(uint64_t deadline_us) {
+    std::unique_lock<std::mutex> lock = LockKernel();
+    WaitUntilUs(lock, nullptr, deadline_us, []() { return false; });
+}
+
+uint64_t HOST_BACKEND::DeadlineFromTicks(uint32_t ticks) {
+    if (ticks == portMAX_DELAY) {
+        return FOREVER;
+    }
+    return NowUs() + uint64_t(ticks) * portTICK_PERIOD_MS * 1000;
+}
+
+unsigned long millis() {
+    return (unsigned long)(HOST_BACKEND::NowUs() / 1000);
+}
+
+unsigned long micros() {
+    return (unsigned long)HOST_BACKEND::NowUs();
+}
+
+void delay(uint32_t ms) {
+    HOST_BACKEND::SleepUntilUs(HOST_BACKEND::NowUs() + uint64_t(ms) * 1000);
+}
+
+void delayMicroseconds(uint32_t us) {
+    HOST_BACKEND::SleepUntilUs(HOST_BACKEND::NowUs() + us);
+}
+
+void yield() {
+    std::this_thread::yield();
+}
+
+int64_t esp_timer_get_time() {
+    return int64_t(HOST_BACKEND::NowUs());
+}
+
+TickType_t xTaskGetTickCount() {
+    return TickType_t(HOST_BACKEND::NowUs() / 1000 / portTICK_PERIOD_MS);
+}
+
+void vTaskDelay(TickType_t ticks) {
+    HOST_BACKEND::SleepUntilUs(HOST_BACKEND::DeadlineFromTicks(ticks));
+}
@@ -0,0 +1,122 @@
+/**
+ * @file esp_system.cpp
+ * @author Dhiraj Deshmukh (deshmukhdhiraj15@gmail.com)
+ * @brief Contains the simulated chip: restart, CPU clock, random numbers,
+ * power management and sleep
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <Arduino.h>
+#include <esp_pm.h>
+#include <esp_sleep.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <random>
+
+#include "host_backend.h"
+#include "simulation.h"
+
+namespace {
+const uint32_t DEFAULT_CPU_FREQ_MHZ = 240;
+const uint32_t DEFAULT_RANDOM_SEED = 1;
+
+std::atomic<bool> s_is_restart_requested{false};
+std::atomic<uint32_t> s_cpu_freq_mhz{DEFAULT_CPU_FREQ_MHZ};
+
+std::mutex s_cycle_mutex;
+uint64_t s_cycles_at_change = 0;
+std::chrono::steady_clock::time_point s_time_at_change = std::chrono::steady_clock::now();
+
+std::mutex s_random_mutex;
+std::mt19937 s_random_engine(DEFAULT_RANDOM_SEED);
+uint64_t s_GetCyclesLocked() {
+    std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - s_time_at_change;
+    return s_cycles_at_change + uint64_t(elapsed.count()) * s_cpu_freq_mhz / 1000;
+}
+}  // namespace
+
+EspClass ESP;
+
+void EspClass::restart() {
+    HOST_SIM::Report("Restart requested");
+    s_is_restart_requested = true;
+}
+
+uint32_t EspClass::getCpuFreqMHz() {
+    return s_cpu_freq_mhz;
+}
+
+uint32_t EspClass::getCycleCount() {
+    // counts on the wall clock of the host, virtual time does not pass while
+    // code runs, so timed sections show what they cost on the host
+    std::lock_guard<std::mutex> lock(s_cycle_mutex);
+    return uint32_t(s_GetCyclesLocked());
+}
+
+uint32_t EspClass::getFreeHeap() {
+    return 200 * 1024;
+}
+
+bool setCpuFrequencyMhz(uint32_t cpu_freq_mhz) {
+    if (cpu_freq_mhz != 80 && cpu_freq_mhz != 160 && cpu_freq_mhz != 240) {
+        return false;
+    }
+    // the counter goes on at the new rate from the cycles counted so far
+    std::lock_guard<std::mutex> lock(s_cycle_mutex);
+    s_cycles_at_change = s_GetCyclesLocked();
+    s_time_at_change = std::chrono::steady_clock::now();
+    s_cpu_freq_mhz = cpu_freq_mhz;
+    return true;
+}
+
+uint32_t getCpuFrequencyMhz() {
+    return s_cpu_freq_mhz;
+}
+
+uint32_t esp_random() {
+    std::lock_guard<std::mutex> lock(s_random_mutex);
+    return s_random_engine();
+}
+
+esp_err_t esp_sleep_enable_gpio_wakeup() {
+    return ESP_OK;
+}
+
+esp_err_t esp_pm_configure(const void* config) {
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t esp_pm_lock_create(esp_pm_lock_type_t lock_type, int arg, const char* name, esp_pm_lock_handle_t* handle) {
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t esp_pm_lock_delete(esp_pm_lock_handle_t handle) {
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t esp_pm_lock_acquire(esp_pm_lock_handle_t handle) {
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t esp_pm_lock_release(esp_pm_lock_handle_t handle) {
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void HOST_SIM::SetRandomSeed(uint32_t seed) {
+    std::lock_guard<std::mutex> lock(s_random_mutex);
+    s_random_engine.seed(seed);
+}
+
+bool HOST_SIM::IsRestartRequested() {
+    return s_is_restart_requested;
+}
+
+void HOST_SIM::ClearRestartRequest() {
+    s_is_restart_requested = false;
+}
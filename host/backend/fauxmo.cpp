@@ -0,0 +1,221 @@
+/**
+ * @file fauxmo.cpp
+ * @author Dhiraj Deshmukh (deshmukhdhiraj15@gmail.com)
+ * @brief Contains the simulated fauxmoESP, requests of the simulated Alexa are
+ * delivered to the enabled instances
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <ESPAsyncWebServer.h>
+#include <fauxmoESP.h>
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <set>
+
+#include "host_backend.h"
+#include "simulation.h"
+
+namespace {
+std::set<fauxmoESP*> s_instances;
+}  // namespace
+
+fauxmoESP::fauxmoESP() {
+    std::lock_guard<std::recursive_mutex> lock(HOST_BACKEND::GetNetworkMutex());
+    s_instances.insert(this);
+}
+
+fauxmoESP::~fauxmoESP() {
+    std::lock_guard<std::recursive_mutex> lock(HOST_BACKEND::GetNetworkMutex());
+    s_instances.erase(this);
+    if (is_port_claimed_) {
+        HOST_BACKEND::ReleasePort(tcp_port_, this);
+    }
+}
+
+unsigned char fauxmoESP::addDevice(const char* device_name) {
+    std::lock_guard<std::recursive_mutex> lock(HOST_BACKEND::GetNetworkMutex());
+    DEVICE device;
+    device.NAME = device_name;
+    devices_.push_back(device);
+    return devices_.size() - 1;
+}
+
+char* fauxmoESP::getDeviceName(unsigned char id, char* buffer, size_t length) {
+    std::lock_guard<std::recursive_mutex> lock(HOST_BACKEND::GetNetworkMutex());
+    if (id >= devices_.size() || buffer == nullptr || length == 0) {
+        return buffer;
+    }
+    std::strncpy(buffer, devices_[id].NAME.c_str(), length - 1);
+    buffer[length - 1] = '\0';
+    return buffer;
+}
+
+int fauxmoESP::getDeviceId(const char* device_name) {
+    std::lock_guard<std::recursive_mutex> lock(HOST_BACKEND::GetNetworkMutex());
+    for (size_t id = 0; id < devices_.size(); id++) {
+        if (devices_[id].NAME == device_name) {
+            return id;
+        }
+    }
+    return -1;
+}
+
+void fauxmoESP::onSetState(TSetStateCallback callback) {
+    std::lock_guard<std::recursive_mutex> lock(HOST_BACKEND::GetNetworkMutex());
+    set_state_callback_ = callback;
+}
+
+bool fauxmoESP::setState(unsigned char id, bool state, unsigned char value) {
+    std::lock_guard<std::recursive_mutex> lock(HOST_BACKEND::GetNetworkMutex());
+    if (id >= devices_.size()) {
+        return false;
+    }
+    devices_[id].STATE = state;
+    devices_[id].VALUE = value;
+    return true;
+}
+
+bool fauxmoESP::setState(const char* device_name, bool state, unsigned char value) {
+    int id = getDeviceId(device_name);
+    return id >= 0 && setState(id, state, value);
+}
+
+void fauxmoESP::createServer(bool internal) {
+    std::lock_guard<std::recursive_mutex> lock(HOST_BACKEND::GetNetworkMutex());
+    if (!is_port_claimed_) {
+        is_internal_server_ = internal;
+    }
+}
+
+void fauxmoESP::setPort(unsigned long tcp_port) {
+    std::lock_guard<std::recursive_mutex> lock(HOST_BACKEND::GetNetworkMutex());
+    if (!is_port_claimed_) {
+        tcp_port_ = tcp_port;
+    }
+}
+
+void fauxmoESP::enable(bool enable) {
+    std::lock_guard<std::recursive_mutex> lock(HOST_BACKEND::GetNetworkMutex());
+    // as with fauxmoESP, the TCP server is created once and kept
+    if (enable && is_internal_server_ && !is_port_claimed_) {
+        is_port_claimed_ = HOST_BACKEND::ClaimPort(tcp_port_, this);
+        if (!is_port_claimed_) {
+            HOST_SIM::Report("fauxmoESP: port " + String(uint32_t(tcp_port_)) + " already in use");
+        }
+    }
+    is_enabled_ = enable;
+}
+
+void fauxmoESP::handle() {}
+
+bool fauxmoESP::process(AsyncClient* client, bool is_get, String url, String body) {
+    // only the state requests of Alexa, /api/<user>/lights/<id from 1>/state
+    // with a body of {"on":<bool>,"bri":<0-255>}
+    int lights = url.indexOf("/lights/");
+    int state_path = url.indexOf("/state");
+    if (is_get || lights < 0 || state_path < lights || body.isEmpty()) {
+        return false;
+    }
+    int id = url.substring(lights + 8, state_path).toInt() - 1;
+    {
+        std::lock_guard<std::recursive_mutex> lock(HOST_BACKEND::GetNetworkMutex());
+        if (!is_enabled_ || id < 0 || id >= int(devices_.size())) {
+            return false;
+        }
+    }
+    bool state = body.indexOf("\"on\":true") >= 0;
+    int brightness = body.indexOf("\"bri\":");
+    unsigned char value = brightness >= 0 ? body.substring(brightness + 6).toInt() : (state ? 255 : 0);
+    Deliver(id, state, value);
+    client->GetRequest()->send(200, "application/json",
+                               "[{\"success\":{\"/lights/" + String(id + 1) + "/state/on\":" +
+                                   (state ? "true" : "false") + "}}]");
+    return true;
+}
+
+bool fauxmoESP::Request(const char* device_name, bool state, unsigned char value) {
+    int id = -1;
+    bool is_internal_server = true;
+    unsigned long tcp_port = 0;
+    {
+        std::lock_guard<std::recursive_mutex> lock(HOST_BACKEND::GetNetworkMutex());
+        id = getDeviceId(device_name);
+        if (!is_enabled_ || (is_internal_server_ && !is_port_claimed_) || id < 0) {
+            return false;
+        }
+        is_internal_server = is_internal_server_;
+        tcp_port = tcp_port_;
+    }
+    if (is_internal_server) {
+        Deliver(id, state, value);
+        return true;
+    }
+    // through the web server of the sketch, which passes it on to process()
+    String url = "/api/host/lights/" + String(id + 1) + "/state";
+    std::string body =
+        std::string("{\"on\":") + (state ? "true" : "false") + ",\"bri\":" + std::to_string(value) + "}";
+    AsyncWebServerRequest request(HTTP_PUT, url, {}, body);
+    const AsyncWebServerResponse* response = HOST_BACKEND::HandleRequest(tcp_port, &request);
+    return response != nullptr && response->GetCode() == 200;
+}
+
+void fauxmoESP::Deliver(int id, bool state, unsigned char value) {
+    TSetStateCallback callback;
+    std::string device_name;
+    {
+        std::lock_guard<std::recursive_mutex> lock(HOST_BACKEND::GetNetworkMutex());
+        devices_[id].STATE = state;
+        devices_[id].VALUE = value;
+        callback = set_state_callback_;
+        device_name = devices_[id].NAME;
+    }
+    if (callback) {
+        callback(id, device_name.c_str(), state, value);
+    }
+}
+
+bool fauxmoESP::GetState(const char* device_name, bool* state, unsigned char* value) const {
+    std::lock_guard<std::recursive_mutex> lock(HOST_BACKEND::GetNetworkMutex());
+    for (const DEVICE& device : devices_) {
+        if (device.NAME == device_name) {
+            *state = device.STATE;
+            *value = device.VALUE;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool HOST_SIM::AlexaRequest(const String& device_name, bool state, uint8_t value) {
+    if (!IsStationConnected()) {
+        return false;
+    }
+    fauxmoESP* instance = nullptr;
+    {
+        std::lock_guard<std::recursive_mutex> lock(HOST_BACKEND::GetNetworkMutex());
+        for (fauxmoESP* candidate : s_instances) {
+            if (candidate->getDeviceId(device_name.c_str()) >= 0) {
+                instance = candidate;
+                break;
+            }
+        }
+    }
+    // the callback runs on the caller, as on the async TCP task
+    return instance != nullptr && instance->Request(device_name.c_str(), state, value);
+}
+
+bool HOST_SIM::GetAlexaState(const String& device_name, bool* state, uint8_t* value) {
+    std::lock_guard<std::recursive_mutex> lock(HOST_BACKEND::GetNetworkMutex());
+    for (const fauxmoESP* instance : s_instances) {
+        if (instance->GetState(device_name.c_str(), state, value)) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,197 @@
+/**
+ * @file freertos.cpp
+ * @author Dhiraj Deshmukh (deshmukhdhiraj15@gmail.com)
+ * @brief Contains the FreeRTOS task notifications and queues on host threads,
+ * all of them under the kernel lock of the virtual clock
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <Arduino.h>
+
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#include "host_backend.h"
+
+struct tskTaskControlBlock {
+    uint32_t VALUE = 0;
+    bool IS_PENDING = false;
+};
+
+struct QueueDefinition {
+    UBaseType_t LENGTH;
+    UBaseType_t ITEM_SIZE;
+    std::deque<std::vector<uint8_t>> ITEMS;
+};
+
+namespace {
+// a task outlives its thread as on the ESP32, where tasks of the firmware are
+// never deleted, so that a late notification never hits freed memory
+thread_local tskTaskControlBlock* s_current_task = nullptr;
+
+BaseType_t s_Notify(TaskHandle_t task, uint32_t value, eNotifyAction action) {
+    if (task == nullptr) {
+        return pdFAIL;
+    }
+    std::unique_lock<std::mutex> lock = HOST_BACKEND::LockKernel();
+    switch (action) {
+        case eSetBits:
+            task->VALUE |= value;
+            break;
+        case eIncrement:
+            task->VALUE++;
+            break;
+        case eSetValueWithOverwrite:
+            task->VALUE = value;
+            break;
+        case eSetValueWithoutOverwrite:
+            if (task->IS_PENDING) {
+                return pdFAIL;
+            }
+            task->VALUE = value;
+            break;
+        default:
+            break;
+    }
+    task->IS_PENDING = true;
+    HOST_BACKEND::Notify(task);
+    return pdPASS;
+}
+
+BaseType_t s_Send(QueueHandle_t queue, const void* item, TickType_t ticks_to_wait, bool overwrite) {
+    std::unique_lock<std::mutex> lock = HOST_BACKEND::LockKernel();
+    if (overwrite) {
+        queue->ITEMS.clear();
+    } else if (!HOST_BACKEND::WaitUntilUs(lock, queue, HOST_BACKEND::DeadlineFromTicks(ticks_to_wait),
+                                          [queue]() { return queue->ITEMS.size() < queue->LENGTH; })) {
+        return errQUEUE_FULL;
+    }
+    const uint8_t* bytes = static_cast<const uint8_t*>(item);
+    queue->ITEMS.emplace_back(bytes, bytes + (item ? queue->ITEM_SIZE : 0));
+    HOST_BACKEND::Notify(queue);
+    return pdPASS;
+}
+}  // namespace
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+    if (s_current_task == nullptr) {
+        s_current_task = new tskTaskControlBlock();
+    }
+    return s_current_task;
+}
+
+BaseType_t xPortGetCoreID() {
+    return 0;
+}
+
+void vTaskPrioritySet(TaskHandle_t task, UBaseType_t priority) {
+    // the virtual-time kernel runs every ready task, priorities do not matter
+    (void)task;
+    (void)priority;
+}
+
+BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value, eNotifyAction action) {
+    return s_Notify(task, value, action);
+}
+
+BaseType_t xTaskNotifyFromISR(TaskHandle_t task, uint32_t value, eNotifyAction action,
+                              BaseType_t* higher_priority_task_woken) {
+    if (higher_priority_task_woken) {
+        *higher_priority_task_woken = pdFALSE;
+    }
+    return s_Notify(task, value, action);
+}
+
+BaseType_t xTaskNotifyWait(uint32_t bits_to_clear_on_entry, uint32_t bits_to_clear_on_exit, uint32_t* value,
+                           TickType_t ticks_to_wait) {
+    tskTaskControlBlock* task = xTaskGetCurrentTaskHandle();
+    std::unique_lock<std::mutex> lock = HOST_BACKEND::LockKernel();
+    if (!task->IS_PENDING) {
+        task->VALUE &= ~bits_to_clear_on_entry;
+    }
+    bool is_notified = HOST_BACKEND::WaitUntilUs(lock, task, HOST_BACKEND::DeadlineFromTicks(ticks_to_wait),
+                                                 [task]() { return task->IS_PENDING; });
+    if (value) {
+        *value = task->VALUE;
+    }
+    if (is_notified) {
+        task->VALUE &= ~bits_to_clear_on_exit;
+    }
+    task->IS_PENDING = false;
+    return is_notified ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    return s_Notify(task, 0, eIncrement);
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* higher_priority_task_woken) {
+    xTaskNotifyFromISR(task, 0, eIncrement, higher_priority_task_woken);
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_count_on_exit, TickType_t ticks_to_wait) {
+    tskTaskControlBlock* task = xTaskGetCurrentTaskHandle();
+    std::unique_lock<std::mutex> lock = HOST_BACKEND::LockKernel();
+    HOST_BACKEND::WaitUntilUs(lock, task, HOST_BACKEND::DeadlineFromTicks(ticks_to_wait),
+                              [task]() { return task->VALUE != 0; });
+    uint32_t value = task->VALUE;
+    if (value != 0) {
+        task->VALUE = clear_count_on_exit ? 0 : value - 1;
+    }
+    task->IS_PENDING = false;
+    return value;
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size) {
+    if (length == 0) {
+        return nullptr;
+    }
+    QueueHandle_t queue = new QueueDefinition();
+    queue->LENGTH = length;
+    queue->ITEM_SIZE = item_size;
+    return queue;
+}
+
+void vQueueDelete(QueueHandle_t queue) {
+    delete queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t ticks_to_wait) {
+    return s_Send(queue, item, ticks_to_wait, false);
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void* item, BaseType_t* higher_priority_task_woken) {
+    if (higher_priority_task_woken) {
+        *higher_priority_task_woken = pdFALSE;
+    }
+    return s_Send(queue, item, 0, false);
+}
+
+BaseType_t xQueueOverwrite(QueueHandle_t queue, const void* item) {
+    return s_Send(queue, item, 0, true);
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void* buffer, TickType_t ticks_to_wait) {
+    std::unique_lock<std::mutex> lock = HOST_BACKEND::LockKernel();
+    if (!HOST_BACKEND::WaitUntilUs(lock, queue, HOST_BACKEND::DeadlineFromTicks(ticks_to_wait),
+                                   [queue]() { return !queue->ITEMS.empty(); })) {
+        return errQUEUE_EMPTY;
+    }
+    if (buffer && queue->ITEM_SIZE) {
+        std::memcpy(buffer, queue->ITEMS.front().data(), queue->ITEM_SIZE);
+    }
+    queue->ITEMS.pop_front();
+    HOST_BACKEND::Notify(queue);
+    return pdPASS;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+    std::unique_lock<std::mutex> lock = HOST_BACKEND::LockKernel();
+    return queue->ITEMS.size();
+}
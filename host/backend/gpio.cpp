@@ -0,0 +1,159 @@
+/**
+ * @file gpio.cpp
+ * @author Dhiraj Deshmukh (deshmukhdhiraj15@gmail.com)
+ * @brief Contains the simulated GPIO matrix, pin levels and the interrupts
+ * attached to them
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <Arduino.h>
+#include <driver/gpio.h>
+
+#include <mutex>
+
+#include "host_backend.h"
+#include "simulation.h"
+
+namespace {
+const int PIN_COUNT = 40;
+
+struct PIN {
+    uint8_t MODE = INPUT;
+    int LEVEL = LOW;
+    voidFuncPtr HANDLER = nullptr;
+    int INTERRUPT_MODE = 0;
+    // changes while masked are lost, as with an edge interrupt
+    bool IS_INTERRUPT_ENABLED = true;
+};
+
+std::mutex s_pin_mutex;
+PIN s_pins[PIN_COUNT];
+
+// interrupts of a single core never run concurrently
+std::mutex s_interrupt_mutex;
+
+bool s_IsValidPin(int pin) {
+    return pin >= 0 && pin < PIN_COUNT;
+}
+}  // namespace
+
+void HOST_BACKEND::RunInterrupt(void (*handler)(void)) {
+    std::lock_guard<std::mutex> lock(s_interrupt_mutex);
+    handler();
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    if (!s_IsValidPin(pin)) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(s_pin_mutex);
+    s_pins[pin].MODE = mode;
+    if ((mode & PULLUP) == PULLUP) {
+        s_pins[pin].LEVEL = HIGH;
+    }
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+    if (!s_IsValidPin(pin)) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(s_pin_mutex);
+    s_pins[pin].LEVEL = value ? HIGH : LOW;
+}
+
+int digitalRead(uint8_t pin) {
+    return HOST_SIM::GetPinLevel(pin);
+}
+
+int digitalPinToInterrupt(uint8_t pin) {
+    return s_IsValidPin(pin) ? pin : -1;
+}
+
+void attachInterrupt(uint8_t pin, voidFuncPtr handler, int mode) {
+    if (!s_IsValidPin(pin)) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(s_pin_mutex);
+    s_pins[pin].HANDLER = handler;
+    s_pins[pin].INTERRUPT_MODE = mode;
+    s_pins[pin].IS_INTERRUPT_ENABLED = true;
+}
+
+void detachInterrupt(uint8_t pin) {
+    if (!s_IsValidPin(pin)) {
+        return;
+    }
+    // a running handler finishes first
+    std::lock_guard<std::mutex> interrupt_lock(s_interrupt_mutex);
+    std::lock_guard<std::mutex> lock(s_pin_mutex);
+    s_pins[pin].HANDLER = nullptr;
+    s_pins[pin].INTERRUPT_MODE = 0;
+}
+
+esp_err_t gpio_wakeup_enable(gpio_num_t gpio_num, gpio_int_type_t intr_type) {
+    return s_IsValidPin(gpio_num) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t gpio_wakeup_disable(gpio_num_t gpio_num) {
+    return s_IsValidPin(gpio_num) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t gpio_intr_enable(gpio_num_t gpio_num) {
+    if (!s_IsValidPin(gpio_num)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    std::lock_guard<std::mutex> lock(s_pin_mutex);
+    s_pins[gpio_num].IS_INTERRUPT_ENABLED = true;
+    return ESP_OK;
+}
+
+esp_err_t gpio_intr_disable(gpio_num_t gpio_num) {
+    if (!s_IsValidPin(gpio_num)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    std::lock_guard<std::mutex> lock(s_pin_mutex);
+    s_pins[gpio_num].IS_INTERRUPT_ENABLED = false;
+    return ESP_OK;
+}
+
+void HOST_SIM::SetPinLevel(int pin, int level) {
+    if (!s_IsValidPin(pin)) {
+        return;
+    }
+    // the interrupt lock is taken first, a handler may read pins
+    std::lock_guard<std::mutex> interrupt_lock(s_interrupt_mutex);
+    voidFuncPtr handler = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(s_pin_mutex);
+        PIN& state = s_pins[pin];
+        level = level ? HIGH : LOW;
+        if (level == state.LEVEL) {
+            return;
+        }
+        state.LEVEL = level;
+        bool is_rising = level == HIGH;
+        if (!state.IS_INTERRUPT_ENABLED) {
+            return;
+        }
+        if (state.INTERRUPT_MODE == CHANGE || (state.INTERRUPT_MODE == RISING && is_rising) ||
+            (state.INTERRUPT_MODE == FALLING && !is_rising) || (state.INTERRUPT_MODE == ONHIGH && is_rising) ||
+            (state.INTERRUPT_MODE == ONLOW && !is_rising)) {
+            handler = state.HANDLER;
+        }
+    }
+    if (handler) {
+        handler();
+    }
+}
+
+int HOST_SIM::GetPinLevel(int pin) {
+    if (!s_IsValidPin(pin)) {
+        return LOW;
+    }
+    std::lock_guard<std::mutex> lock(s_pin_mutex);
+    return s_pins[pin].LEVEL;
+}
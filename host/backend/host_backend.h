@@ -0,0 +1,122 @@
+/**
+ * @file host_backend.h
+ * @author Mahimana Bhatt (mahimanabhatt@gmail.com)
+ * @brief Defines what the parts of the Linux backend share: the virtual clock
+ * every wait goes through, interrupt dispatch and the ports of the loopback
+ * network
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef _HOST_BACKEND_INCLUDE_GUARD
+#define _HOST_BACKEND_INCLUDE_GUARD
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+
+class AsyncWebServer;
+class AsyncWebServerRequest;
+class AsyncWebServerResponse;
+
+namespace HOST_BACKEND {
+
+const uint64_t FOREVER = UINT64_MAX;
+
+/**
+ * @brief Microseconds of virtual time since power on
+ *
+ */
+uint64_t NowUs();
+
+/**
+ * @brief Takes the kernel lock, the one lock every wait of the backend and
+ * the state it waits for are under, interrupts never run while it is held
+ *
+ */
+std::unique_lock<std::mutex> LockKernel();
+
+/**
+ * @brief Blocks the calling thread until the given time, time moves on once
+ * every thread waits
+ *
+ */
+void SleepUntilUs(uint64_t deadline_us);
+
+/**
+ * @brief Waits with the kernel lock until the predicate holds or the
+ * deadline passed, FOREVER waits without deadline, the predicate is checked
+ * again whenever the channel is notified
+ *
+ * @return bool : the predicate
+ */
+bool WaitUntilUs(std::unique_lock<std::mutex>& kernel_lock, const void* channel, uint64_t deadline_us,
+                 const std::function<bool()>& predicate);
+
+/**
+ * @brief Wakes the threads waiting on a channel, call with the kernel lock
+ * held
+ *
+ */
+void Notify(const void* channel);
+
+/**
+ * @brief Converts FreeRTOS ticks from now into a deadline
+ *
+ */
+uint64_t DeadlineFromTicks(uint32_t ticks);
+
+/**
+ * @brief Runs an interrupt handler, handlers never run concurrently as on a
+ * single core
+ *
+ */
+void RunInterrupt(void (*handler)(void));
+
+/**
+ * @brief Claims a port of the loopback network
+ *
+ * @return true : if the port was free or already claimed by the owner
+ */
+bool ClaimPort(uint16_t port, const void* owner);
+
+/**
+ * @brief Releases a port claimed by the owner
+ *
+ */
+void ReleasePort(uint16_t port, const void* owner);
+
+/**
+ * @brief Returns the web server listening on a port, nullptr if none
+ *
+ */
+AsyncWebServer* GetServer(uint16_t port);
+
+/**
+ * @brief Lets a web server listen on a claimed port
+ *
+ */
+void SetServer(uint16_t port, AsyncWebServer* server);
+
+/**
+ * @brief Hands a request to the web server listening on a port, on the
+ * calling thread
+ *
+ * @return const AsyncWebServerResponse*: the response, nullptr if nothing
+ * listens or the server did not answer
+ */
+const AsyncWebServerResponse* HandleRequest(uint16_t port, AsyncWebServerRequest* request);
+
+/**
+ * @brief Lock for the loopback network, held while a request is handled so
+ * that servers are not destroyed meanwhile
+ *
+ */
+std::recursive_mutex& GetNetworkMutex();
+
+}  // namespace HOST_BACKEND
+
+#endif
@@ -0,0 +1,48 @@
+/**
+ * @file ota.cpp
+ * @author Dhiraj Deshmukh (deshmukhdhiraj15@gmail.com)
+ * @brief Contains ArduinoOTA, no update is ever offered on the host
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <ArduinoOTA.h>
+
+ArduinoOTAClass ArduinoOTA;
+
+ArduinoOTAClass& ArduinoOTAClass::onStart(THandlerFunction fn) {
+    start_callback_ = fn;
+    return *this;
+}
+
+ArduinoOTAClass& ArduinoOTAClass::onEnd(THandlerFunction fn) {
+    end_callback_ = fn;
+    return *this;
+}
+
+ArduinoOTAClass& ArduinoOTAClass::onError(THandlerFunction_Error fn) {
+    error_callback_ = fn;
+    return *this;
+}
+
+ArduinoOTAClass& ArduinoOTAClass::onProgress(THandlerFunction_Progress fn) {
+    progress_callback_ = fn;
+    return *this;
+}
+
+void ArduinoOTAClass::begin() {
+    is_begun_ = true;
+}
+
+void ArduinoOTAClass::end() {
+    is_begun_ = false;
+}
+
+void ArduinoOTAClass::handle() {}
+
+int ArduinoOTAClass::getCommand() {
+    return U_FLASH;
+}
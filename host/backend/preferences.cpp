@@ -0,0 +1,162 @@
+/**
+ * @file preferences.cpp
+ * @author Dhiraj Deshmukh (deshmukhdhiraj15@gmail.com)
+ * @brief Contains the simulated non volatile storage, it survives simulated
+ * restarts but not the process
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <Preferences.h>
+
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "simulation.h"
+
+namespace {
+std::mutex s_storage_mutex;
+std::map<std::string, std::map<std::string, std::vector<uint8_t>>> s_storage;
+}  // namespace
+
+bool Preferences::begin(const char* name, bool read_only) {
+    if (is_open_ || name == nullptr) {
+        return false;
+    }
+    namespace_ = name;
+    read_only_ = read_only;
+    is_open_ = true;
+    return true;
+}
+
+void Preferences::end() {
+    is_open_ = false;
+}
+
+bool Preferences::clear() {
+    if (!is_open_ || read_only_) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(s_storage_mutex);
+    s_storage[namespace_].clear();
+    return true;
+}
+
+bool Preferences::remove(const char* key) {
+    if (!is_open_ || read_only_ || key == nullptr) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(s_storage_mutex);
+    return s_storage[namespace_].erase(key) > 0;
+}
+
+bool Preferences::isKey(const char* key) {
+    if (!is_open_ || key == nullptr) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(s_storage_mutex);
+    return s_storage[namespace_].count(key) > 0;
+}
+
+size_t Preferences::Put(const char* key, const void* value, size_t length) {
+    if (!is_open_ || read_only_ || key == nullptr) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> lock(s_storage_mutex);
+    const uint8_t* bytes = static_cast<const uint8_t*>(value);
+    s_storage[namespace_][key].assign(bytes, bytes + length);
+    return length;
+}
+
+bool Preferences::Get(const char* key, void* value, size_t length) {
+    if (!is_open_ || key == nullptr) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(s_storage_mutex);
+    auto& entries = s_storage[namespace_];
+    auto entry = entries.find(key);
+    if (entry == entries.end() || entry->second.size() != length) {
+        return false;
+    }
+    std::memcpy(value, entry->second.data(), length);
+    return true;
+}
+
+size_t Preferences::putBool(const char* key, bool value) {
+    uint8_t byte = value ? 1 : 0;
+    return Put(key, &byte, sizeof(byte));
+}
+
+size_t Preferences::putInt(const char* key, int32_t value) {
+    return Put(key, &value, sizeof(value));
+}
+
+size_t Preferences::putUInt(const char* key, uint32_t value) {
+    return Put(key, &value, sizeof(value));
+}
+
+size_t Preferences::putString(const char* key, String value) {
+    // the terminator is stored, the length without it is returned
+    return Put(key, value.c_str(), value.length() + 1) ? value.length() : 0;
+}
+
+size_t Preferences::putBytes(const char* key, const void* value, size_t length) {
+    return Put(key, value, length);
+}
+
+bool Preferences::getBool(const char* key, bool default_value) {
+    uint8_t byte = 0;
+    return Get(key, &byte, sizeof(byte)) ? byte != 0 : default_value;
+}
+
+int32_t Preferences::getInt(const char* key, int32_t default_value) {
+    int32_t value = 0;
+    return Get(key, &value, sizeof(value)) ? value : default_value;
+}
+
+uint32_t Preferences::getUInt(const char* key, uint32_t default_value) {
+    uint32_t value = 0;
+    return Get(key, &value, sizeof(value)) ? value : default_value;
+}
+
+String Preferences::getString(const char* key, String default_value) {
+    if (!is_open_ || key == nullptr) {
+        return default_value;
+    }
+    std::lock_guard<std::mutex> lock(s_storage_mutex);
+    auto& entries = s_storage[namespace_];
+    auto entry = entries.find(key);
+    if (entry == entries.end() || entry->second.empty()) {
+        return default_value;
+    }
+    return String(reinterpret_cast<const char*>(entry->second.data()));
+}
+
+size_t Preferences::getBytesLength(const char* key) {
+    if (!is_open_ || key == nullptr) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> lock(s_storage_mutex);
+    auto& entries = s_storage[namespace_];
+    auto entry = entries.find(key);
+    return entry == entries.end() ? 0 : entry->second.size();
+}
+
+size_t Preferences::getBytes(const char* key, void* buffer, size_t max_length) {
+    size_t length = getBytesLength(key);
+    if (length == 0 || length > max_length || !Get(key, buffer, length)) {
+        return 0;
+    }
+    return length;
+}
+
+void HOST_SIM::ClearStorage() {
+    std::lock_guard<std::mutex> lock(s_storage_mutex);
+    s_storage.clear();
+}
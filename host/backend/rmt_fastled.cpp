@@ -0,0 +1,127 @@
+/**
+ * @file rmt_fastled.cpp
+ * @author Dhiraj Deshmukh (deshmukhdhiraj15@gmail.com)
+ * @brief Contains the RMT transmitter, which decodes WS2812 frames into LED
+ * colors, and the FastLED color math
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <FastLED.h>
+#include <esp32-hal-rmt.h>
+
+#include <mutex>
+#include <vector>
+
+#include "simulation.h"
+
+struct rmt_obj_s {
+    int PIN;
+    float TICK_NS;
+};
+
+namespace {
+std::mutex s_led_mutex;
+std::vector<CRGB> s_leds;
+uint32_t s_frame_count = 0;
+
+/**
+ * @brief Decodes one WS2812 byte, a bit is 1 if it is high longer than low
+ *
+ */
+uint8_t s_DecodeByte(const rmt_data_t* data) {
+    uint8_t value = 0;
+    for (int bit = 0; bit < 8; bit++) {
+        value = (value << 1) | (data[bit].duration0 > data[bit].duration1 ? 1 : 0);
+    }
+    return value;
+}
+}  // namespace
+
+rmt_obj_t* rmtInit(int pin, bool tx_not_rx, rmt_reserve_memsize_t memsize) {
+    if (!tx_not_rx) {
+        return nullptr;
+    }
+    return new rmt_obj_t{pin, 100.0f};
+}
+
+float rmtSetTick(rmt_obj_t* rmt, float tick) {
+    rmt->TICK_NS = tick;
+    return tick;
+}
+
+bool rmtWrite(rmt_obj_t* rmt, rmt_data_t* data, size_t size) {
+    if (rmt == nullptr || data == nullptr) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(s_led_mutex);
+    // GRB order, 24 bits per LED
+    s_leds.resize(size / 24);
+    for (size_t i = 0; i < s_leds.size(); i++) {
+        s_leds[i].g = s_DecodeByte(data + i * 24);
+        s_leds[i].r = s_DecodeByte(data + i * 24 + 8);
+        s_leds[i].b = s_DecodeByte(data + i * 24 + 16);
+    }
+    s_frame_count++;
+    return true;
+}
+
+bool rmtDeinit(rmt_obj_t* rmt) {
+    delete rmt;
+    return true;
+}
+
+CRGB HOST_SIM::GetLed(int index) {
+    std::lock_guard<std::mutex> lock(s_led_mutex);
+    if (index < 0 || index >= int(s_leds.size())) {
+        return CRGB();
+    }
+    return s_leds[index];
+}
+
+uint32_t HOST_SIM::GetLedFrameCount() {
+    std::lock_guard<std::mutex> lock(s_led_mutex);
+    return s_frame_count;
+}
+
+uint8_t scale8(uint8_t value, uint8_t scale) {
+    return (uint16_t(value) * (1 + uint16_t(scale))) >> 8;
+}
+
+uint8_t scale8_video(uint8_t value, uint8_t scale) {
+    return ((uint16_t(value) * scale) >> 8) + (value && scale ? 1 : 0);
+}
+
+uint8_t triwave8(uint8_t in) {
+    if (in & 0x80) {
+        in = 255 - in;
+    }
+    return in << 1;
+}
+
+uint8_t ease8InOutQuad(uint8_t value) {
+    uint8_t half = (value & 0x80) ? 255 - value : value;
+    uint8_t eased = scale8(half, half) << 1;
+    return (value & 0x80) ? 255 - eased : eased;
+}
+
+uint8_t quadwave8(uint8_t in) {
+    return ease8InOutQuad(triwave8(in));
+}
+
+CRGB& CRGB::nscale8(uint8_t scale) {
+    r = scale8(r, scale);
+    g = scale8(g, scale);
+    b = scale8(b, scale);
+    return *this;
+}
+
+CRGB& CRGB::nscale8_video(uint8_t scale) {
+    r = scale8_video(r, scale);
+    g = scale8_video(g, scale);
+    b = scale8_video(b, scale);
+    return *this;
+}
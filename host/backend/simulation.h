@@ -0,0 +1,175 @@
+/**
+ * @file simulation.h
+ * @author Mahimana Bhatt (mahimanabhatt@gmail.com)
+ * @brief Defines the controls of the simulated device around the firmware in
+ * the host build, i.e. what a person, the network and the blind do to it
+ *
+ *   - GPIO: input pins (buttons) are driven, their interrupts run on the
+ *     calling thread
+ *   - blind: a roller blind on the TMC2209, running into either end stalls
+ *     the motor (SG_RESULT drops, DIAG rises)
+ *   - network: an access point which can go up and down, HTTP requests to the
+ *     servers started by the firmware, Alexa requests to fauxmo devices
+ *   - chip: restarts requested by the firmware, the NVS content and the LEDs
+ *
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef _HOST_SIMULATION_INCLUDE_GUARD
+#define _HOST_SIMULATION_INCLUDE_GUARD
+
+#include <FastLED.h>
+#include <WString.h>
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace HOST_SIM {
+
+/**
+ * @brief Mechanics of the simulated blind, positions in microsteps of the
+ * motor (16 microsteps), 0 is the end the motor runs into with the shaft bit
+ * set
+ *
+ */
+struct BLIND {
+    int TRAVEL_MICROSTEPS = 16 * 200 * 10;  // 10 revolutions between the ends
+    int START_MICROSTEP = 16 * 200 * 3;     // position at power on
+    uint16_t FREE_SG_RESULT = 320;          // SG_RESULT while running freely
+    uint16_t SG_RESULT_NOISE = 24;          // peak to peak noise on SG_RESULT
+};
+
+struct HTTP_RESPONSE {
+    int CODE = 0;  // 0 if nothing listens on the port
+    String CONTENT_TYPE;
+    std::string BODY;
+};
+
+/**
+ * @brief Drives an input pin, runs the interrupt attached to it if the level
+ * change matches its mode
+ *
+ */
+void SetPinLevel(int pin, int level);
+
+/**
+ * @brief Returns the level of a pin, input or output
+ *
+ */
+int GetPinLevel(int pin);
+
+/**
+ * @brief Replaces the blind, the motor is put to the start position
+ *
+ */
+void SetBlind(const BLIND& blind);
+
+/**
+ * @brief Returns the position of the blind in microsteps
+ *
+ */
+int GetBlindMicrostep();
+
+/**
+ * @brief Returns the TMC2209 datagrams written so far
+ *
+ */
+uint32_t GetDriverWriteCount();
+
+/**
+ * @brief Sets SSID and password of the access point
+ *
+ */
+void SetAccessPoint(const String& ssid, const String& password);
+
+/**
+ * @brief Switches the access point on or off, associated stations drop
+ *
+ */
+void SetAccessPointUp(bool up);
+
+/**
+ * @brief Returns true if the device is associated with the access point
+ *
+ */
+bool IsStationConnected();
+
+/**
+ * @brief Returns true if the device runs its own hotspot
+ *
+ */
+bool IsSoftAPEnabled();
+
+/**
+ * @brief Sends a GET request to a server of the device, handled on the
+ * calling thread
+ *
+ */
+HTTP_RESPONSE HttpGet(uint16_t port, const String& url, const std::vector<std::pair<String, String>>& args = {});
+
+/**
+ * @brief Sends an Alexa request (value 0-255) to an enabled fauxmo device
+ *
+ * @return true : if a device of that name listens
+ */
+bool AlexaRequest(const String& device_name, bool state, uint8_t value);
+
+/**
+ * @brief Returns the state the device last reported to Alexa
+ *
+ * @return true : if a device of that name exists
+ */
+bool GetAlexaState(const String& device_name, bool* state, uint8_t* value);
+
+/**
+ * @brief Returns the color of a LED as last sent through RMT
+ *
+ */
+CRGB GetLed(int index);
+
+/**
+ * @brief Returns the number of LED frames sent through RMT
+ *
+ */
+uint32_t GetLedFrameCount();
+
+/**
+ * @brief Erases the NVS
+ *
+ */
+void ClearStorage();
+
+/**
+ * @brief Prints a line of the simulation to the console, between the lines of
+ * the firmware
+ *
+ */
+void Report(const String& message);
+
+/**
+ * @brief Seeds esp_random(), runs with the same seed and inputs repeat
+ *
+ */
+void SetRandomSeed(uint32_t seed);
+
+/**
+ * @brief Returns true once the firmware called ESP.restart()
+ *
+ */
+bool IsRestartRequested();
+
+/**
+ * @brief Acknowledges a restart, called after the firmware was set up again
+ *
+ */
+void ClearRestartRequest();
+
+}  // namespace HOST_SIM
+
+#endif
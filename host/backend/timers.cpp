@@ -0,0 +1,293 @@
+/**
+ * @file timers.cpp
+ * @author Dhiraj Deshmukh (deshmukhdhiraj15@gmail.com)
+ * @brief Contains the ESP32 hardware timers and the esp_timer API, each timer
+ * waits for its deadline on a thread of its own
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <Arduino.h>
+#include <esp_timer.h>
+
+#include <algorithm>
+#include <mutex>
+#include <thread>
+
+#include "host_backend.h"
+
+namespace {
+const double APB_CLOCK_MHZ = 80.0;
+
+/**
+ * @brief Runs OnDeadline() on its thread whenever the deadline passes
+ *
+ */
+class TimerThread {
+   public:
+    virtual ~TimerThread() {}
+
+    void Start() {
+        is_running_ = true;
+        thread_ = std::thread(&TimerThread::Run, this);
+    }
+
+    /**
+     * @brief Stops the thread, to be called by the derived destructor
+     *
+     */
+    void Stop() {
+        {
+            std::unique_lock<std::mutex> lock = HOST_BACKEND::LockKernel();
+            is_running_ = false;
+            HOST_BACKEND::Notify(this);
+        }
+        if (thread_.get_id() == std::this_thread::get_id()) {
+            // deleted from its own callback
+            thread_.detach();
+        } else if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+    /**
+     * @brief Sets the next deadline, FOREVER disarms, wins over the deadline
+     * returned by an OnDeadline() running meanwhile
+     *
+     */
+    void SetDeadline(uint64_t deadline_us) {
+        std::unique_lock<std::mutex> lock = HOST_BACKEND::LockKernel();
+        deadline_us_ = deadline_us;
+        generation_++;
+        HOST_BACKEND::Notify(this);
+    }
+
+   protected:
+    /**
+     * @brief Called on the timer thread, without lock, once the deadline
+     * passed
+     *
+     * @return uint64_t : next deadline, FOREVER if none
+     */
+    virtual uint64_t OnDeadline(uint64_t deadline_us) = 0;
+
+   private:
+    std::thread thread_;
+    // under the kernel lock
+    bool is_running_ = false;
+    uint64_t deadline_us_ = HOST_BACKEND::FOREVER;
+    uint64_t generation_ = 0;
+
+    void Run() {
+        std::unique_lock<std::mutex> lock = HOST_BACKEND::LockKernel();
+        while (is_running_) {
+            uint64_t deadline_us = deadline_us_;
+            uint64_t generation = generation_;
+            if (deadline_us == HOST_BACKEND::FOREVER || HOST_BACKEND::NowUs() < deadline_us) {
+                HOST_BACKEND::WaitUntilUs(lock, this, deadline_us, [this, generation]() {
+                    return !is_running_ || generation_ != generation;
+                });
+                continue;
+            }
+            deadline_us_ = HOST_BACKEND::FOREVER;
+            lock.unlock();
+            uint64_t next_deadline_us = OnDeadline(deadline_us);
+            lock.lock();
+            if (generation_ == generation) {
+                deadline_us_ = next_deadline_us;
+            }
+        }
+    }
+};
+}  // namespace
+
+struct hw_timer_s : public TimerThread {
+    std::mutex MUTEX;
+    double TICK_US = 1.0;
+    uint64_t COUNT_AT_REFERENCE = 0;
+    uint64_t REFERENCE_US = 0;
+    uint64_t ALARM = 0;
+    bool AUTORELOAD = false;
+    bool IS_ALARM_ENABLED = false;
+    void (*HANDLER)(void) = nullptr;
+
+    ~hw_timer_s() { Stop(); }
+
+    /**
+     * @brief Deadline of the alarm, call with MUTEX held
+     *
+     */
+    uint64_t GetAlarmDeadline() {
+        if (!IS_ALARM_ENABLED) {
+            return HOST_BACKEND::FOREVER;
+        }
+        if (ALARM <= COUNT_AT_REFERENCE) {
+            return REFERENCE_US;
+        }
+        return REFERENCE_US + uint64_t((ALARM - COUNT_AT_REFERENCE) * TICK_US);
+    }
+
+    uint64_t OnDeadline(uint64_t deadline_us) override {
+        void (*handler)(void) = nullptr;
+        uint64_t next_deadline_us = HOST_BACKEND::FOREVER;
+        {
+            std::lock_guard<std::mutex> lock(MUTEX);
+            handler = HANDLER;
+            if (AUTORELOAD) {
+                COUNT_AT_REFERENCE = 0;
+                REFERENCE_US = deadline_us;
+                next_deadline_us = GetAlarmDeadline();
+            } else {
+                IS_ALARM_ENABLED = false;
+            }
+        }
+        if (handler) {
+            HOST_BACKEND::RunInterrupt(handler);
+        }
+        return next_deadline_us;
+    }
+};
+
+struct esp_timer : public TimerThread {
+    std::mutex MUTEX;
+    esp_timer_cb_t CALLBACK = nullptr;
+    void* ARG = nullptr;
+    uint64_t PERIOD_US = 0;
+    bool IS_ARMED = false;
+
+    ~esp_timer() { Stop(); }
+
+    uint64_t OnDeadline(uint64_t deadline_us) override {
+        {
+            std::lock_guard<std::mutex> lock(MUTEX);
+            if (!IS_ARMED) {
+                return HOST_BACKEND::FOREVER;
+            }
+            IS_ARMED = PERIOD_US != 0;
+        }
+        CALLBACK(ARG);
+        std::lock_guard<std::mutex> lock(MUTEX);
+        if (!IS_ARMED) {
+            return HOST_BACKEND::FOREVER;
+        }
+        // periods missed while the host was busy are skipped
+        return std::max(deadline_us + PERIOD_US, HOST_BACKEND::NowUs());
+    }
+};
+
+hw_timer_t* timerBegin(uint8_t num, uint16_t divider, bool count_up) {
+    hw_timer_t* timer = new hw_timer_t();
+    timer->TICK_US = divider / APB_CLOCK_MHZ;
+    timer->REFERENCE_US = HOST_BACKEND::NowUs();
+    timer->Start();
+    return timer;
+}
+
+void timerEnd(hw_timer_t* timer) {
+    delete timer;
+}
+
+void timerAttachInterrupt(hw_timer_t* timer, void (*fn)(void), bool edge) {
+    std::lock_guard<std::mutex> lock(timer->MUTEX);
+    timer->HANDLER = fn;
+}
+
+void timerDetachInterrupt(hw_timer_t* timer) {
+    std::lock_guard<std::mutex> lock(timer->MUTEX);
+    timer->HANDLER = nullptr;
+}
+
+void timerAlarmWrite(hw_timer_t* timer, uint64_t alarm_value, bool autoreload) {
+    std::lock_guard<std::mutex> lock(timer->MUTEX);
+    timer->ALARM = alarm_value;
+    timer->AUTORELOAD = autoreload;
+    timer->SetDeadline(timer->GetAlarmDeadline());
+}
+
+void timerAlarmEnable(hw_timer_t* timer) {
+    std::lock_guard<std::mutex> lock(timer->MUTEX);
+    timer->IS_ALARM_ENABLED = true;
+    timer->SetDeadline(timer->GetAlarmDeadline());
+}
+
+void timerAlarmDisable(hw_timer_t* timer) {
+    std::lock_guard<std::mutex> lock(timer->MUTEX);
+    timer->IS_ALARM_ENABLED = false;
+    timer->SetDeadline(HOST_BACKEND::FOREVER);
+}
+
+bool timerAlarmEnabled(hw_timer_t* timer) {
+    std::lock_guard<std::mutex> lock(timer->MUTEX);
+    return timer->IS_ALARM_ENABLED;
+}
+
+void timerWrite(hw_timer_t* timer, uint64_t value) {
+    std::lock_guard<std::mutex> lock(timer->MUTEX);
+    timer->COUNT_AT_REFERENCE = value;
+    timer->REFERENCE_US = HOST_BACKEND::NowUs();
+    timer->SetDeadline(timer->GetAlarmDeadline());
+}
+
+uint64_t timerRead(hw_timer_t* timer) {
+    std::lock_guard<std::mutex> lock(timer->MUTEX);
+    return timer->COUNT_AT_REFERENCE + uint64_t((HOST_BACKEND::NowUs() - timer->REFERENCE_US) / timer->TICK_US);
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t* create_args, esp_timer_handle_t* out_handle) {
+    if (create_args == nullptr || create_args->callback == nullptr || out_handle == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_timer_handle_t timer = new esp_timer();
+    timer->CALLBACK = create_args->callback;
+    timer->ARG = create_args->arg;
+    timer->Start();
+    *out_handle = timer;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us) {
+    std::lock_guard<std::mutex> lock(timer->MUTEX);
+    if (timer->IS_ARMED) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->IS_ARMED = true;
+    timer->PERIOD_US = 0;
+    timer->SetDeadline(HOST_BACKEND::NowUs() + timeout_us);
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period_us) {
+    std::lock_guard<std::mutex> lock(timer->MUTEX);
+    if (timer->IS_ARMED) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->IS_ARMED = true;
+    timer->PERIOD_US = period_us;
+    timer->SetDeadline(HOST_BACKEND::NowUs() + period_us);
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer) {
+    // a running callback is not waited for, as with esp_timer
+    std::lock_guard<std::mutex> lock(timer->MUTEX);
+    if (!timer->IS_ARMED) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->IS_ARMED = false;
+    timer->SetDeadline(HOST_BACKEND::FOREVER);
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer) {
+    {
+        std::lock_guard<std::mutex> lock(timer->MUTEX);
+        if (timer->IS_ARMED) {
+            return ESP_ERR_INVALID_STATE;
+        }
+    }
+    delete timer;
+    return ESP_OK;
+}
@@ -0,0 +1,240 @@
+/**
+ * @file tmc2209.cpp
+ * @author Dhiraj Deshmukh (deshmukhdhiraj15@gmail.com)
+ * @brief Contains the simulated TMC2209 driving the blind, it integrates
+ * VACTUAL into the blind position and MSCNT and drives the INDEX and DIAG pins
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <Arduino.h>
+#include <TMCStepper.h>
+
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <thread>
+
+#include "../../mvp/src/config/config.h"
+#include "host_backend.h"
+#include "simulation.h"
+
+namespace {
+const double DRIVER_CLOCK_HZ = 12000000.0;
+const uint64_t MODEL_TICK_US = 1000;
+
+const uint8_t REG_GCONF = 0x00;
+const uint8_t REG_IFCNT = 0x02;
+const uint8_t REG_IHOLD_IRUN = 0x10;
+const uint8_t REG_VACTUAL = 0x22;
+const uint8_t REG_SGTHRS = 0x40;
+const uint8_t REG_SG_RESULT = 0x41;
+const uint8_t REG_MSCNT = 0x6A;
+const uint8_t REG_CHOPCONF = 0x6C;
+const uint8_t REG_DRV_STATUS = 0x6F;
+
+const uint32_t GCONF_SHAFT = 1 << 3;
+const int MSCNT_PER_CYCLE = 1024;
+
+struct DRIVER_MODEL {
+    std::mutex MUTEX;
+    HOST_SIM::BLIND BLIND;
+    double POSITION = HOST_SIM::BLIND().START_MICROSTEP;  // microsteps from the shaft end
+    double MSCNT = 0;
+    std::map<uint8_t, uint32_t> REGISTERS;
+    uint32_t WRITE_COUNT = 0;
+    uint16_t SG_RESULT = 0;
+    bool IS_DIAG_HIGH = false;
+    uint32_t NOISE_STATE = 1;
+    uint32_t NOTIFIED_WRITE_COUNT = 0;  // under the kernel lock, wakes the standing model
+};
+
+DRIVER_MODEL& s_GetModel() {
+    static DRIVER_MODEL s_model;
+    return s_model;
+}
+
+std::once_flag s_model_started;
+
+/**
+ * @brief Signed VACTUAL, call with the model mutex held
+ *
+ */
+int32_t s_GetVactual(DRIVER_MODEL& model) {
+    uint32_t vactual = model.REGISTERS[REG_VACTUAL] & 0xFFFFFF;
+    return (vactual & 0x800000) ? int32_t(vactual) - 0x1000000 : int32_t(vactual);
+}
+
+/**
+ * @brief Advances the model by one tick
+ *
+ * @return int : INDEX pulses to emit
+ */
+int s_Tick(DRIVER_MODEL& model, double dt_s, bool is_enabled) {
+    int32_t vactual = is_enabled ? s_GetVactual(model) : 0;
+    double velocity = vactual * DRIVER_CLOCK_HZ / (1 << 24);
+    double travel = velocity * dt_s;
+
+    // MRES 0 is 256 microsteps, MSCNT always moves by 1024 per electrical cycle
+    uint32_t mres = (model.REGISTERS[REG_CHOPCONF] >> 24) & 0xF;
+    model.MSCNT += travel * (1 << std::min<uint32_t>(mres, 8));
+    int pulses = 0;
+    while (model.MSCNT >= MSCNT_PER_CYCLE) {
+        model.MSCNT -= MSCNT_PER_CYCLE;
+        pulses++;
+    }
+    while (model.MSCNT < 0) {
+        model.MSCNT += MSCNT_PER_CYCLE;
+        pulses++;
+    }
+
+    bool is_shaft = model.REGISTERS[REG_GCONF] & GCONF_SHAFT;
+    double position = model.POSITION + (is_shaft ? -travel : travel);
+    bool is_pinned = false;
+    if (position <= 0 && travel != 0) {
+        position = 0;
+        is_pinned = true;
+    } else if (position >= model.BLIND.TRAVEL_MICROSTEPS && travel != 0) {
+        position = model.BLIND.TRAVEL_MICROSTEPS;
+        is_pinned = true;
+    }
+    model.POSITION = position;
+
+    if (vactual == 0) {
+        model.SG_RESULT = 0;
+    } else if (is_pinned) {
+        model.SG_RESULT = 0;
+    } else {
+        model.NOISE_STATE = model.NOISE_STATE * 1103515245 + 12345;
+        int noise = model.BLIND.SG_RESULT_NOISE ? int((model.NOISE_STATE >> 16) % (model.BLIND.SG_RESULT_NOISE + 1)) -
+                                                      model.BLIND.SG_RESULT_NOISE / 2
+                                                : 0;
+        model.SG_RESULT = std::max(0, int(model.BLIND.FREE_SG_RESULT) + noise);
+    }
+    uint32_t sgthrs = model.REGISTERS[REG_SGTHRS] & 0xFF;
+    model.IS_DIAG_HIGH = vactual != 0 && model.SG_RESULT <= 2 * sgthrs;
+    return pulses;
+}
+
+void s_RunModel() {
+    using namespace CONFIG_SET;
+    DRIVER_MODEL& model = s_GetModel();
+    uint64_t tick_us = HOST_BACKEND::NowUs();
+    bool was_diag_high = false;
+    while (true) {
+        tick_us += MODEL_TICK_US;
+        HOST_BACKEND::SleepUntilUs(tick_us);
+        bool is_enabled = HOST_SIM::GetPinLevel(PIN_MD_ENABLE) == LOW;
+        int pulses = 0;
+        bool is_diag_high = false;
+        bool is_moving = false;
+        uint32_t write_count = 0;
+        {
+            std::lock_guard<std::mutex> lock(model.MUTEX);
+            pulses = s_Tick(model, MODEL_TICK_US / 1e6, is_enabled);
+            is_diag_high = model.IS_DIAG_HIGH;
+            is_moving = s_GetVactual(model) != 0;
+            write_count = model.WRITE_COUNT;
+        }
+        // pins are driven outside the model lock, the interrupts read registers
+        for (int i = 0; i < pulses; i++) {
+            HOST_SIM::SetPinLevel(PIN_MD_INDEX, HIGH);
+            HOST_SIM::SetPinLevel(PIN_MD_INDEX, LOW);
+        }
+        if (is_diag_high != was_diag_high) {
+            HOST_SIM::SetPinLevel(PIN_MD_DIAG, is_diag_high ? HIGH : LOW);
+            was_diag_high = is_diag_high;
+        }
+        if (!is_moving) {
+            // a standing motor has nothing to simulate, ticking on would keep
+            // virtual time from jumping ahead
+            std::unique_lock<std::mutex> lock = HOST_BACKEND::LockKernel();
+            HOST_BACKEND::WaitUntilUs(lock, &model, HOST_BACKEND::FOREVER,
+                                      [&model, write_count]() { return model.NOTIFIED_WRITE_COUNT != write_count; });
+            tick_us = HOST_BACKEND::NowUs();
+        }
+    }
+}
+}  // namespace
+
+TMC2209Stepper::TMC2209Stepper(HardwareSerial* serial, float r_sense, uint8_t address) : slave_address_(address) {
+    // the model runs for the rest of the process, the blind keeps its position
+    // across simulated restarts
+    std::call_once(s_model_started, []() { std::thread(s_RunModel).detach(); });
+}
+
+void TMC2209Stepper::write(uint8_t address, uint32_t value) {
+    DRIVER_MODEL& model = s_GetModel();
+    std::lock_guard<std::mutex> lock(model.MUTEX);
+    model.REGISTERS[address & 0x7F] = value;
+    model.WRITE_COUNT++;
+    std::unique_lock<std::mutex> kernel_lock = HOST_BACKEND::LockKernel();
+    model.NOTIFIED_WRITE_COUNT = model.WRITE_COUNT;
+    HOST_BACKEND::Notify(&model);
+}
+
+uint32_t TMC2209Stepper::read(uint8_t address) {
+    DRIVER_MODEL& model = s_GetModel();
+    std::lock_guard<std::mutex> lock(model.MUTEX);
+    switch (address & 0x7F) {
+        case REG_GCONF:
+        case REG_CHOPCONF:
+            return model.REGISTERS[address & 0x7F];
+        case REG_IFCNT:
+            return model.WRITE_COUNT & 0xFF;
+        case REG_SG_RESULT:
+            return model.SG_RESULT;
+        case REG_MSCNT:
+            return uint32_t(model.MSCNT) & (MSCNT_PER_CYCLE - 1);
+        case REG_DRV_STATUS: {
+            uint32_t ihold_irun = model.REGISTERS[REG_IHOLD_IRUN];
+            uint32_t current_scale = s_GetVactual(model) != 0 ? (ihold_irun >> 8) & 0x1F : ihold_irun & 0x1F;
+            return current_scale << 16;
+        }
+        default:
+            // write only registers
+            return 0;
+    }
+}
+
+uint8_t TMC2209Stepper::IFCNT() {
+    return read(REG_IFCNT);
+}
+
+uint16_t TMC2209Stepper::MSCNT() {
+    return read(REG_MSCNT);
+}
+
+uint16_t TMC2209Stepper::SG_RESULT() {
+    return read(REG_SG_RESULT);
+}
+
+uint32_t TMC2209Stepper::DRV_STATUS() {
+    return read(REG_DRV_STATUS);
+}
+
+uint8_t TMC2209Stepper::test_connection() {
+    return 0;
+}
+
+void HOST_SIM::SetBlind(const BLIND& blind) {
+    DRIVER_MODEL& model = s_GetModel();
+    std::lock_guard<std::mutex> lock(model.MUTEX);
+    model.BLIND = blind;
+    model.POSITION = blind.START_MICROSTEP;
+}
+
+int HOST_SIM::GetBlindMicrostep() {
+    DRIVER_MODEL& model = s_GetModel();
+    std::lock_guard<std::mutex> lock(model.MUTEX);
+    return int(std::lround(model.POSITION));
+}
+
+uint32_t HOST_SIM::GetDriverWriteCount() {
+    DRIVER_MODEL& model = s_GetModel();
+    std::lock_guard<std::mutex> lock(model.MUTEX);
+    return model.WRITE_COUNT;
+}
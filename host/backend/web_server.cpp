@@ -0,0 +1,281 @@
+/**
+ * @file web_server.cpp
+ * @author Dhiraj Deshmukh (deshmukhdhiraj15@gmail.com)
+ * @brief Contains the loopback network, i.e. the TCP ports of the device and
+ * the web servers listening on them
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <ESPAsyncWebServer.h>
+
+#include <cstring>
+#include <map>
+#include <mutex>
+
+#include "host_backend.h"
+#include "simulation.h"
+
+namespace {
+const size_t FILLER_CHUNK_LENGTH = 1436;
+
+struct PORT {
+    const void* OWNER = nullptr;
+    AsyncWebServer* SERVER = nullptr;
+};
+
+std::map<uint16_t, PORT> s_ports;
+}  // namespace
+
+std::recursive_mutex& HOST_BACKEND::GetNetworkMutex() {
+    static std::recursive_mutex s_network_mutex;
+    return s_network_mutex;
+}
+
+bool HOST_BACKEND::ClaimPort(uint16_t port, const void* owner) {
+    std::lock_guard<std::recursive_mutex> lock(GetNetworkMutex());
+    PORT& entry = s_ports[port];
+    if (entry.OWNER != nullptr && entry.OWNER != owner) {
+        return false;
+    }
+    entry.OWNER = owner;
+    return true;
+}
+
+void HOST_BACKEND::ReleasePort(uint16_t port, const void* owner) {
+    std::lock_guard<std::recursive_mutex> lock(GetNetworkMutex());
+    auto entry = s_ports.find(port);
+    if (entry != s_ports.end() && entry->second.OWNER == owner) {
+        s_ports.erase(entry);
+    }
+}
+
+AsyncWebServer* HOST_BACKEND::GetServer(uint16_t port) {
+    std::lock_guard<std::recursive_mutex> lock(GetNetworkMutex());
+    auto entry = s_ports.find(port);
+    return entry == s_ports.end() ? nullptr : entry->second.SERVER;
+}
+
+void HOST_BACKEND::SetServer(uint16_t port, AsyncWebServer* server) {
+    std::lock_guard<std::recursive_mutex> lock(GetNetworkMutex());
+    s_ports[port].SERVER = server;
+}
+
+const AsyncWebServerResponse* HOST_BACKEND::HandleRequest(uint16_t port, AsyncWebServerRequest* request) {
+    // held through the handler, servers are not torn down meanwhile
+    std::lock_guard<std::recursive_mutex> lock(GetNetworkMutex());
+    AsyncWebServer* server = GetServer(port);
+    if (server == nullptr) {
+        return nullptr;
+    }
+    server->Handle(request);
+    return request->GetResponse();
+}
+
+AsyncWebServerResponse::AsyncWebServerResponse(int code, const String& content_type, const std::string& content)
+    : code_(code), content_type_(content_type), content_(content), length_(content.size()) {}
+
+AsyncWebServerResponse::AsyncWebServerResponse(const String& content_type, size_t length, AwsResponseFiller filler)
+    : code_(200), content_type_(content_type), length_(length), filler_(filler) {}
+
+void AsyncWebServerResponse::addHeader(const String& name, const String& value) {
+    headers_[name.str()] = value.str();
+}
+
+int AsyncWebServerResponse::GetCode() const {
+    return code_;
+}
+
+const String& AsyncWebServerResponse::GetContentType() const {
+    return content_type_;
+}
+
+const std::map<std::string, std::string>& AsyncWebServerResponse::GetHeaders() const {
+    return headers_;
+}
+
+std::string AsyncWebServerResponse::GetContent() const {
+    if (!filler_) {
+        return content_;
+    }
+    std::string content;
+    uint8_t chunk[FILLER_CHUNK_LENGTH];
+    while (content.size() < length_) {
+        size_t length = filler_(chunk, std::min(sizeof(chunk), length_ - content.size()), content.size());
+        if (length == 0) {
+            break;
+        }
+        content.append(reinterpret_cast<const char*>(chunk), length);
+    }
+    return content;
+}
+
+AsyncClient::AsyncClient(AsyncWebServerRequest* request) : request_(request) {}
+
+AsyncWebServerRequest* AsyncClient::GetRequest() const {
+    return request_;
+}
+
+AsyncWebServerRequest::AsyncWebServerRequest(WebRequestMethod method, const String& url,
+                                             const std::vector<std::pair<String, String>>& args,
+                                             const std::string& body)
+    : method_(method), url_(url), args_(args), body_(body), client_(this) {}
+
+AsyncWebServerRequest::~AsyncWebServerRequest() {
+    delete response_;
+}
+
+AsyncClient* AsyncWebServerRequest::client() {
+    return &client_;
+}
+
+WebRequestMethod AsyncWebServerRequest::method() const {
+    return method_;
+}
+
+const String& AsyncWebServerRequest::url() const {
+    return url_;
+}
+
+bool AsyncWebServerRequest::hasArg(const char* name) const {
+    for (const auto& arg : args_) {
+        if (arg.first == name) {
+            return true;
+        }
+    }
+    return false;
+}
+
+String AsyncWebServerRequest::arg(const char* name) const {
+    for (const auto& arg : args_) {
+        if (arg.first == name) {
+            return arg.second;
+        }
+    }
+    return String();
+}
+
+AsyncWebServerResponse* AsyncWebServerRequest::beginResponse(int code, const String& content_type,
+                                                             const String& content) {
+    return new AsyncWebServerResponse(code, content_type, content.str());
+}
+
+AsyncWebServerResponse* AsyncWebServerRequest::beginResponse(const String& content_type, size_t length,
+                                                             AwsResponseFiller filler) {
+    return new AsyncWebServerResponse(content_type, length, filler);
+}
+
+AsyncWebServerResponse* AsyncWebServerRequest::beginResponse_P(int code, const String& content_type,
+                                                               const uint8_t* content, size_t length) {
+    return new AsyncWebServerResponse(code, content_type,
+                                      std::string(reinterpret_cast<const char*>(content), length));
+}
+
+void AsyncWebServerRequest::send(AsyncWebServerResponse* response) {
+    delete response_;
+    response_ = response;
+}
+
+void AsyncWebServerRequest::send(int code, const String& content_type, const String& content) {
+    send(beginResponse(code, content_type, content));
+}
+
+void AsyncWebServerRequest::send_P(int code, const String& content_type, const char* content) {
+    send(beginResponse(code, content_type, String(content)));
+}
+
+const AsyncWebServerResponse* AsyncWebServerRequest::GetResponse() const {
+    return response_;
+}
+
+const std::string& AsyncWebServerRequest::GetBody() const {
+    return body_;
+}
+
+AsyncWebServer::AsyncWebServer(uint16_t port) : port_(port) {}
+
+AsyncWebServer::~AsyncWebServer() {
+    end();
+}
+
+void AsyncWebServer::on(const char* uri, WebRequestMethod method, ArRequestHandlerFunction handler) {
+    std::lock_guard<std::recursive_mutex> lock(HOST_BACKEND::GetNetworkMutex());
+    routes_.push_back({uri, method, handler});
+}
+
+void AsyncWebServer::onNotFound(ArRequestHandlerFunction handler) {
+    std::lock_guard<std::recursive_mutex> lock(HOST_BACKEND::GetNetworkMutex());
+    not_found_handler_ = handler;
+}
+
+void AsyncWebServer::onRequestBody(ArBodyHandlerFunction handler) {
+    std::lock_guard<std::recursive_mutex> lock(HOST_BACKEND::GetNetworkMutex());
+    body_handler_ = handler;
+}
+
+void AsyncWebServer::begin() {
+    std::lock_guard<std::recursive_mutex> lock(HOST_BACKEND::GetNetworkMutex());
+    if (is_listening_) {
+        return;
+    }
+    if (!HOST_BACKEND::ClaimPort(port_, this)) {
+        HOST_SIM::Report("AsyncWebServer: port " + String(port_) + " already in use, not listening");
+        return;
+    }
+    HOST_BACKEND::SetServer(port_, this);
+    is_listening_ = true;
+}
+
+void AsyncWebServer::end() {
+    std::lock_guard<std::recursive_mutex> lock(HOST_BACKEND::GetNetworkMutex());
+    if (!is_listening_) {
+        return;
+    }
+    HOST_BACKEND::ReleasePort(port_, this);
+    is_listening_ = false;
+}
+
+void AsyncWebServer::Handle(AsyncWebServerRequest* request) {
+    std::lock_guard<std::recursive_mutex> lock(HOST_BACKEND::GetNetworkMutex());
+    if (!request->GetBody().empty() && body_handler_) {
+        // one chunk, null terminated as the sketches read it as a string
+        std::vector<uint8_t> data(request->GetBody().begin(), request->GetBody().end());
+        data.push_back(0);
+        body_handler_(request, data.data(), data.size() - 1, 0, data.size() - 1);
+        if (request->GetResponse() != nullptr) {
+            return;
+        }
+    }
+    for (const ROUTE& route : routes_) {
+        if (route.URI == request->url().str() && (route.METHOD & request->method())) {
+            route.HANDLER(request);
+            return;
+        }
+    }
+    if (not_found_handler_) {
+        not_found_handler_(request);
+    } else {
+        request->send(404);
+    }
+}
+
+HOST_SIM::HTTP_RESPONSE HOST_SIM::HttpGet(uint16_t port, const String& url,
+                                          const std::vector<std::pair<String, String>>& args) {
+    HTTP_RESPONSE http_response;
+    if (!IsSoftAPEnabled() && !IsStationConnected()) {
+        return http_response;
+    }
+    AsyncWebServerRequest request(HTTP_GET, url, args);
+    const AsyncWebServerResponse* response = HOST_BACKEND::HandleRequest(port, &request);
+    if (response == nullptr) {
+        // the client times out
+        return http_response;
+    }
+    http_response.CODE = response->GetCode();
+    http_response.CONTENT_TYPE = response->GetContentType();
+    http_response.BODY = response->GetContent();
+    return http_response;
+}
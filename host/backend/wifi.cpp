@@ -0,0 +1,201 @@
+/**
+ * @file wifi.cpp
+ * @author Dhiraj Deshmukh (deshmukhdhiraj15@gmail.com)
+ * @brief Contains the simulated WiFi radio and the access point the station
+ * connects to
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <Arduino.h>
+#include <WiFi.h>
+
+#include <algorithm>
+#include <mutex>
+#include <string>
+
+#include "host_backend.h"
+#include "simulation.h"
+
+WiFiClass WiFi;
+
+namespace {
+// association and DHCP
+const uint64_t CONNECT_LATENCY_US = 300000;
+
+struct RADIO {
+    std::string AP_SSID;
+    std::string AP_PASSWORD;
+    bool IS_AP_UP = false;
+    uint64_t AP_UP_SINCE_US = 0;
+
+    wifi_mode_t MODE = WIFI_OFF;
+    bool IS_BEGUN = false;
+    std::string SSID;
+    std::string PASSWORD;
+    uint64_t BEGIN_US = 0;
+    bool IS_SOFT_AP_ENABLED = false;
+    IPAddress SOFT_AP_IP = IPAddress(192, 168, 4, 1);
+    wifi_ps_type_t SLEEP_TYPE = WIFI_PS_MIN_MODEM;
+};
+
+std::mutex s_radio_mutex;
+RADIO s_radio;
+
+/**
+ * @brief Station status, call with s_radio_mutex held
+ *
+ */
+wl_status_t s_GetStatus() {
+    if (!s_radio.IS_BEGUN || (s_radio.MODE & WIFI_STA) == 0) {
+        return WL_DISCONNECTED;
+    }
+    if (!s_radio.IS_AP_UP || s_radio.SSID != s_radio.AP_SSID) {
+        return WL_NO_SSID_AVAIL;
+    }
+    if (s_radio.PASSWORD != s_radio.AP_PASSWORD) {
+        return WL_CONNECT_FAILED;
+    }
+    if (HOST_BACKEND::NowUs() < std::max(s_radio.BEGIN_US, s_radio.AP_UP_SINCE_US) + CONNECT_LATENCY_US) {
+        return WL_DISCONNECTED;
+    }
+    return WL_CONNECTED;
+}
+}  // namespace
+
+bool WiFiClass::mode(wifi_mode_t mode) {
+    std::lock_guard<std::mutex> lock(s_radio_mutex);
+    s_radio.MODE = mode;
+    if ((mode & WIFI_AP) == 0) {
+        s_radio.IS_SOFT_AP_ENABLED = false;
+    }
+    return true;
+}
+
+wifi_mode_t WiFiClass::getMode() {
+    std::lock_guard<std::mutex> lock(s_radio_mutex);
+    return s_radio.MODE;
+}
+
+wl_status_t WiFiClass::begin(const char* ssid, const char* password) {
+    std::lock_guard<std::mutex> lock(s_radio_mutex);
+    if (s_radio.MODE == WIFI_OFF) {
+        s_radio.MODE = WIFI_STA;
+    }
+    s_radio.IS_BEGUN = true;
+    s_radio.SSID = ssid ? ssid : "";
+    s_radio.PASSWORD = password ? password : "";
+    s_radio.BEGIN_US = HOST_BACKEND::NowUs();
+    return s_GetStatus();
+}
+
+bool WiFiClass::disconnect(bool wifi_off, bool erase_ap) {
+    std::lock_guard<std::mutex> lock(s_radio_mutex);
+    s_radio.IS_BEGUN = false;
+    if (erase_ap) {
+        s_radio.SSID.clear();
+        s_radio.PASSWORD.clear();
+    }
+    if (wifi_off) {
+        s_radio.MODE = WIFI_OFF;
+        s_radio.IS_SOFT_AP_ENABLED = false;
+    }
+    return true;
+}
+
+bool WiFiClass::reconnect() {
+    std::lock_guard<std::mutex> lock(s_radio_mutex);
+    s_radio.IS_BEGUN = true;
+    s_radio.BEGIN_US = HOST_BACKEND::NowUs();
+    return true;
+}
+
+wl_status_t WiFiClass::status() {
+    std::lock_guard<std::mutex> lock(s_radio_mutex);
+    return s_GetStatus();
+}
+
+uint8_t WiFiClass::waitForConnectResult(unsigned long timeout_ms) {
+    unsigned long start_ms = millis();
+    wl_status_t wifi_status = status();
+    while (wifi_status != WL_CONNECTED && wifi_status != WL_CONNECT_FAILED && millis() - start_ms < timeout_ms) {
+        delay(100);
+        wifi_status = status();
+    }
+    return wifi_status;
+}
+
+IPAddress WiFiClass::localIP() {
+    return status() == WL_CONNECTED ? IPAddress(192, 168, 1, 42) : IPAddress();
+}
+
+bool WiFiClass::setSleep(bool enabled) {
+    return setSleep(enabled ? WIFI_PS_MIN_MODEM : WIFI_PS_NONE);
+}
+
+bool WiFiClass::setSleep(wifi_ps_type_t sleep_type) {
+    std::lock_guard<std::mutex> lock(s_radio_mutex);
+    s_radio.SLEEP_TYPE = sleep_type;
+    return true;
+}
+
+wifi_ps_type_t WiFiClass::getSleep() {
+    std::lock_guard<std::mutex> lock(s_radio_mutex);
+    return s_radio.SLEEP_TYPE;
+}
+
+bool WiFiClass::softAPConfig(IPAddress local_ip, IPAddress gateway, IPAddress subnet) {
+    std::lock_guard<std::mutex> lock(s_radio_mutex);
+    s_radio.SOFT_AP_IP = local_ip;
+    return true;
+}
+
+bool WiFiClass::softAP(const char* ssid, const char* password) {
+    std::lock_guard<std::mutex> lock(s_radio_mutex);
+    if ((s_radio.MODE & WIFI_AP) == 0) {
+        s_radio.MODE = wifi_mode_t(s_radio.MODE | WIFI_AP);
+    }
+    s_radio.IS_SOFT_AP_ENABLED = true;
+    return true;
+}
+
+bool WiFiClass::softAPdisconnect(bool wifi_off) {
+    std::lock_guard<std::mutex> lock(s_radio_mutex);
+    s_radio.IS_SOFT_AP_ENABLED = false;
+    s_radio.MODE = wifi_off ? WIFI_OFF : wifi_mode_t(s_radio.MODE & ~WIFI_AP);
+    return true;
+}
+
+IPAddress WiFiClass::softAPIP() {
+    std::lock_guard<std::mutex> lock(s_radio_mutex);
+    return s_radio.IS_SOFT_AP_ENABLED ? s_radio.SOFT_AP_IP : IPAddress();
+}
+
+void HOST_SIM::SetAccessPoint(const String& ssid, const String& password) {
+    std::lock_guard<std::mutex> lock(s_radio_mutex);
+    s_radio.AP_SSID = ssid.str();
+    s_radio.AP_PASSWORD = password.str();
+    s_radio.IS_AP_UP = true;
+    s_radio.AP_UP_SINCE_US = HOST_BACKEND::NowUs();
+}
+
+void HOST_SIM::SetAccessPointUp(bool up) {
+    std::lock_guard<std::mutex> lock(s_radio_mutex);
+    if (up && !s_radio.IS_AP_UP) {
+        s_radio.AP_UP_SINCE_US = HOST_BACKEND::NowUs();
+    }
+    s_radio.IS_AP_UP = up;
+}
+
+bool HOST_SIM::IsStationConnected() {
+    std::lock_guard<std::mutex> lock(s_radio_mutex);
+    return s_GetStatus() == WL_CONNECTED;
+}
+
+bool HOST_SIM::IsSoftAPEnabled() {
+    std::lock_guard<std::mutex> lock(s_radio_mutex);
+    return s_radio.IS_SOFT_AP_ENABLED;
+}
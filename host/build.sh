@@ -0,0 +1,37 @@
+#!/bin/bash
+
+# path to repository
+repo_path=$(dirname $(dirname $(realpath ${BASH_SOURCE})))
+
+# output directory of the simulator, the first argument overrides it
+build_path=${1:-$repo_path/host/build}
+mkdir -p $build_path
+
+# the sketch sources with the host HAL in place of the ESP32 core and libraries
+g++ -std=gnu++17 -O1 -g -pthread \
+-I$repo_path/host/hal \
+-I$repo_path/host/backend \
+$(find $repo_path/mvp/src -name '*.cpp' | sort) \
+$repo_path/host/backend/*.cpp \
+$repo_path/host/sim/main.cpp \
+-o $build_path/sim || exit 1
+
+echo "built $build_path/sim"
+
+# renders the binary log records of the sketch, needs no HAL, reads the format
+# strings from the sources at run time
+g++ -std=gnu++17 -O1 -g \
+$repo_path/host/decoder/main.cpp \
+-o $build_path/log_decoder || exit 1
+
+echo "built $build_path/log_decoder"
+
+# checks the motion profiles against their limits, pure C++ like the profile
+g++ -std=gnu++17 -O1 -g \
+$repo_path/mvp/src/motion_profile/motion_profile.cpp \
+$repo_path/host/profile_check/main.cpp \
+-o $build_path/profile_check || exit 1
+
+echo "built $build_path/profile_check"
+
+exit 0
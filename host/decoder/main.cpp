@@ -0,0 +1,372 @@
+/**
+ * @file main.cpp
+ * @author Dhiraj Deshmukh (deshmukhdhiraj15@gmail.com)
+ * @brief Renders the binary log records of the sketch as text, see
+ * mvp/src/logging/log_format.h for the format on the wire
+ *
+ * The format strings are collected from the LOG_FORMAT() literals of the
+ * given source directory and keyed by the same hash the compiler computes
+ * for the firmware. Lines which are not records pass through unchanged.
+ *
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../../mvp/src/logging/log_format.h"
+
+namespace {
+struct ARG {
+    LOG_ARG TAG;
+    int64_t INTEGER = 0;
+    uint64_t UNSIGNED = 0;
+    double REAL = 0;
+    std::string TEXT;
+};
+
+const char* s_GetTypeName(uint8_t log_type) {
+    using namespace CONFIG_SET;
+    switch (LOG_TYPE(log_type)) {
+        case LOG_TYPE::INFO:
+            return "[INFO] ";
+        case LOG_TYPE::WARN:
+            return "[WARN] ";
+        case LOG_TYPE::ERROR:
+            return "[ERROR] ";
+    }
+    return "[INFO] ";
+}
+
+const char* s_GetClassName(uint8_t log_class) {
+    using namespace CONFIG_SET;
+    switch (LOG_CLASS(log_class)) {
+        case LOG_CLASS::CONTROLLER:
+            return "[CONTROLLER] ";
+        case LOG_CLASS::CONNECTIVITY:
+            return "[CONNECTIVITY] ";
+        case LOG_CLASS::INDICATOR:
+            return "[INDICATOR] ";
+        case LOG_CLASS::LOGGING:
+            return "[LOGGING] ";
+        case LOG_CLASS::MANUAL_INTERACTION:
+            return "[MANUAL_INTERACTION] ";
+        case LOG_CLASS::MOTOR_DRIVER:
+            return "[MOTOR_DRIVER] ";
+        case LOG_CLASS::STORAGE:
+            return "[STORAGE] ";
+        case LOG_CLASS::ALEXA_INTERACTION:
+            return "[ALEXA_INTERACTION] ";
+        case LOG_CLASS::POWER_MANAGER:
+            return "[POWER_MANAGER] ";
+        case LOG_CLASS::LATENCY:
+            return "[LATENCY] ";
+    }
+    return "[LOGGING] ";
+}
+
+/**
+ * @brief Reads the string literal(s) at position, adjacent ones joined, and
+ * undoes the simple escapes
+ *
+ * @return false : if there is no literal
+ */
+bool s_ReadLiteral(const std::string& source, size_t position, std::string& literal) {
+    bool is_found = false;
+    while (true) {
+        while (position < source.size() && std::isspace(static_cast<unsigned char>(source[position]))) {
+            position++;
+        }
+        if (position >= source.size() || source[position] != '"') {
+            return is_found;
+        }
+        for (position++; position < source.size() && source[position] != '"'; position++) {
+            char c = source[position];
+            if (c == '\\' && position + 1 < source.size()) {
+                c = source[++position];
+                c = c == 'n' ? '\n' : c == 't' ? '\t' : c;
+            }
+            literal += c;
+        }
+        position++;
+        is_found = true;
+    }
+}
+
+void s_CollectFormats(const std::string& source_path, std::map<uint32_t, std::string>& formats) {
+    const std::string marker = "LOG_FORMAT(";
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(source_path)) {
+        std::string extension = entry.path().extension().string();
+        if (!entry.is_regular_file() || (extension != ".cpp" && extension != ".h" && extension != ".ino")) {
+            continue;
+        }
+        std::ifstream file(entry.path());
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+        std::string source = buffer.str();
+        for (size_t position = source.find(marker); position != std::string::npos;
+             position = source.find(marker, position + 1)) {
+            std::string format;
+            if (!s_ReadLiteral(source, position + marker.size(), format)) {
+                continue;
+            }
+            uint32_t id = LogFormatId(format.c_str());
+            auto known = formats.find(id);
+            if (known != formats.end() && known->second != format) {
+                std::fprintf(stderr, "log_decoder: '%s' and '%s' share the id %08x\n", known->second.c_str(),
+                             format.c_str(), unsigned(id));
+            }
+            formats[id] = format;
+        }
+    }
+}
+
+bool s_DecodeBase64(const std::string& text, std::vector<uint8_t>& bytes) {
+    if (text.empty() || text.size() % 4 != 0) {
+        return false;
+    }
+    uint32_t bits = 0;
+    int bit_count = 0;
+    for (size_t i = 0; i < text.size(); i++) {
+        char c = text[i];
+        int value;
+        if (c >= 'A' && c <= 'Z') {
+            value = c - 'A';
+        } else if (c >= 'a' && c <= 'z') {
+            value = c - 'a' + 26;
+        } else if (c >= '0' && c <= '9') {
+            value = c - '0' + 52;
+        } else if (c == '+') {
+            value = 62;
+        } else if (c == '/') {
+            value = 63;
+        } else if (c == '=' && i >= text.size() - 2) {
+            continue;
+        } else {
+            return false;
+        }
+        bits = (bits << 6) | uint32_t(value);
+        bit_count += 6;
+        if (bit_count >= 8) {
+            bit_count -= 8;
+            bytes.push_back(uint8_t(bits >> bit_count));
+        }
+    }
+    return true;
+}
+
+template <typename T>
+T s_Read(const uint8_t* bytes) {
+    T value;
+    std::memcpy(&value, bytes, sizeof(T));
+    return value;
+}
+
+/**
+ * @brief Splits the arguments of a record
+ *
+ * @return false : if they are malformed
+ */
+bool s_ReadArgs(const uint8_t* bytes, size_t length, std::vector<ARG>& args) {
+    size_t position = 0;
+    while (position < length) {
+        ARG arg;
+        arg.TAG = LOG_ARG(bytes[position++]);
+        size_t size;
+        switch (arg.TAG) {
+            case LOG_ARG::INT32:
+            case LOG_ARG::UINT32:
+            case LOG_ARG::FLOAT:
+                size = 4;
+                break;
+            case LOG_ARG::INT64:
+            case LOG_ARG::UINT64:
+            case LOG_ARG::DOUBLE:
+                size = 8;
+                break;
+            case LOG_ARG::STRING:
+                size = position < length ? 1 + bytes[position] : 1;
+                break;
+            default:
+                return false;
+        }
+        if (position + size > length) {
+            return false;
+        }
+        const uint8_t* value = &bytes[position];
+        switch (arg.TAG) {
+            case LOG_ARG::INT32:
+                arg.INTEGER = s_Read<int32_t>(value);
+                break;
+            case LOG_ARG::UINT32:
+                arg.UNSIGNED = s_Read<uint32_t>(value);
+                break;
+            case LOG_ARG::INT64:
+                arg.INTEGER = s_Read<int64_t>(value);
+                break;
+            case LOG_ARG::UINT64:
+                arg.UNSIGNED = s_Read<uint64_t>(value);
+                break;
+            case LOG_ARG::FLOAT:
+                arg.REAL = s_Read<float>(value);
+                break;
+            case LOG_ARG::DOUBLE:
+                arg.REAL = s_Read<double>(value);
+                break;
+            case LOG_ARG::STRING:
+                arg.TEXT.assign(reinterpret_cast<const char*>(value + 1), value[0]);
+                break;
+        }
+        position += size;
+        args.push_back(arg);
+    }
+    return true;
+}
+
+/**
+ * @brief Formats one conversion, converting the argument if its type does not
+ * match
+ *
+ */
+std::string s_FormatArg(std::string spec, char conversion, const ARG& arg) {
+    bool is_signed = arg.TAG == LOG_ARG::INT32 || arg.TAG == LOG_ARG::INT64;
+    bool is_real = arg.TAG == LOG_ARG::FLOAT || arg.TAG == LOG_ARG::DOUBLE;
+    char text[256];
+    if (arg.TAG == LOG_ARG::STRING || conversion == 's') {
+        std::string value = arg.TEXT;
+        if (arg.TAG != LOG_ARG::STRING) {
+            value = is_real ? std::to_string(arg.REAL)
+                            : is_signed ? std::to_string(arg.INTEGER) : std::to_string(arg.UNSIGNED);
+        }
+        std::snprintf(text, sizeof(text), (spec + "s").c_str(), value.c_str());
+    } else if (std::strchr("fFeEgGaA", conversion)) {
+        double value = is_real ? arg.REAL : is_signed ? double(arg.INTEGER) : double(arg.UNSIGNED);
+        std::snprintf(text, sizeof(text), (spec + conversion).c_str(), value);
+    } else if (std::strchr("di", conversion)) {
+        long long value = is_real ? (long long)(arg.REAL) : is_signed ? arg.INTEGER : (long long)(arg.UNSIGNED);
+        std::snprintf(text, sizeof(text), (spec + "ll" + conversion).c_str(), value);
+    } else {
+        unsigned long long value = is_real     ? (unsigned long long)(arg.REAL)
+                                   : is_signed ? (unsigned long long)(arg.INTEGER)
+                                               : arg.UNSIGNED;
+        // a signed value printed unsigned keeps the width it was logged with
+        if (is_signed && arg.TAG == LOG_ARG::INT32) {
+            value = uint32_t(arg.INTEGER);
+        }
+        std::snprintf(text, sizeof(text), (spec + "ll" + (conversion == 'c' ? 'u' : conversion)).c_str(), value);
+    }
+    return text;
+}
+
+std::string s_Format(const std::string& format, const std::vector<ARG>& args) {
+    std::string message;
+    size_t arg_index = 0;
+    for (size_t i = 0; i < format.size(); i++) {
+        if (format[i] != '%') {
+            message += format[i];
+            continue;
+        }
+        if (i + 1 < format.size() && format[i + 1] == '%') {
+            message += '%';
+            i++;
+            continue;
+        }
+        // flags, width and precision are kept, length modifiers dropped
+        std::string spec = "%";
+        for (i++; i < format.size() && std::strchr("-+ #0123456789.", format[i]); i++) {
+            spec += format[i];
+        }
+        while (i < format.size() && std::strchr("hlLqjzt", format[i])) {
+            i++;
+        }
+        char conversion = i < format.size() ? format[i] : 'd';
+        if (arg_index < args.size()) {
+            message += s_FormatArg(spec, conversion, args[arg_index++]);
+        } else {
+            // left out on the device, the record was full
+            message += "?";
+        }
+    }
+    return message;
+}
+
+/**
+ * @brief Renders a line if it is a record
+ *
+ * @return false : if it is not
+ */
+bool s_Decode(const std::map<uint32_t, std::string>& formats, const std::string& line, std::string& text) {
+    std::vector<uint8_t> frame;
+    if (line.empty() || line[0] != LOG_FRAME_MARKER || !s_DecodeBase64(line.substr(1), frame) ||
+        frame.size() < 2 + sizeof(uint32_t) + 1) {
+        return false;
+    }
+    uint8_t checksum = 0;
+    for (uint8_t byte : frame) {
+        checksum ^= byte;
+    }
+    if (checksum != 0) {
+        return false;
+    }
+    uint32_t id = s_Read<uint32_t>(&frame[2]);
+    std::vector<ARG> args;
+    if (!s_ReadArgs(&frame[6], frame.size() - 7, args)) {
+        return false;
+    }
+    text = std::string(s_GetTypeName(frame[0])) + s_GetClassName(frame[1]);
+    auto format = formats.find(id);
+    if (format == formats.end()) {
+        char unknown[64];
+        std::snprintf(unknown, sizeof(unknown), "<unknown format %08x, %zu arguments>", unsigned(id), args.size());
+        text += unknown;
+    } else {
+        text += s_Format(format->second, args);
+    }
+    return true;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2 || argc > 3) {
+        std::fprintf(stderr, "usage: %s <sketch source directory> [log file, default stdin]\n", argv[0]);
+        return 2;
+    }
+    std::map<uint32_t, std::string> formats;
+    try {
+        s_CollectFormats(argv[1], formats);
+    } catch (const std::filesystem::filesystem_error& error) {
+        std::fprintf(stderr, "log_decoder: %s\n", error.what());
+        return 2;
+    }
+    std::ifstream file;
+    if (argc == 3) {
+        file.open(argv[2]);
+        if (!file) {
+            std::fprintf(stderr, "log_decoder: cannot open %s\n", argv[2]);
+            return 2;
+        }
+    }
+    std::istream& input = argc == 3 ? file : std::cin;
+    std::string line;
+    while (std::getline(input, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        std::string text;
+        std::cout << (s_Decode(formats, line, text) ? text : line) << std::endl;
+    }
+    return 0;
+}
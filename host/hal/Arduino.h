@@ -0,0 +1,84 @@
+/**
+ * @file Arduino.h
+ * @author Mahimana Bhatt (mahimanabhatt@gmail.com)
+ * @brief Host build of the ESP32 Arduino core, the part of the hardware
+ * abstraction the firmware uses: time, GPIO with interrupts, UARTs, hardware
+ * timers, RMT and the chip itself
+ *
+ * The firmware includes the same headers on both targets, on the ESP32 they
+ * resolve to the Arduino core and libraries, in the host build to this
+ * directory, backed by the Linux implementation in host/backend. Input pins
+ * are driven by the simulation, see host/backend/simulation.h.
+ *
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef _HOST_ARDUINO_INCLUDE_GUARD
+#define _HOST_ARDUINO_INCLUDE_GUARD
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include "Esp.h"
+#include "HardwareSerial.h"
+#include "IPAddress.h"
+#include "Print.h"
+#include "WString.h"
+#include "esp32-hal-rmt.h"
+#include "esp32-hal-timer.h"
+#include "esp_sleep.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define PROGMEM
+
+#define LOW 0x0
+#define HIGH 0x1
+
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define PULLUP 0x04
+#define INPUT_PULLUP 0x05
+#define PULLDOWN 0x08
+#define INPUT_PULLDOWN 0x09
+
+#define RISING 0x01
+#define FALLING 0x02
+#define CHANGE 0x03
+#define ONLOW 0x04
+#define ONHIGH 0x05
+
+typedef uint8_t byte;
+typedef void (*voidFuncPtr)(void);
+
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void yield();
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+int digitalPinToInterrupt(uint8_t pin);
+void attachInterrupt(uint8_t pin, voidFuncPtr handler, int mode);
+void detachInterrupt(uint8_t pin);
+
+bool setCpuFrequencyMhz(uint32_t cpu_freq_mhz);
+uint32_t getCpuFrequencyMhz();
+
+#endif
@@ -0,0 +1,55 @@
+/**
+ * @file ArduinoOTA.h
+ * @author Mahimana Bhatt (mahimanabhatt@gmail.com)
+ * @brief Host build of ArduinoOTA, the simulated device is never invited to
+ * an update, callbacks are kept
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef _HOST_ARDUINO_OTA_INCLUDE_GUARD
+#define _HOST_ARDUINO_OTA_INCLUDE_GUARD
+
+#include <functional>
+
+#define U_FLASH 0
+#define U_SPIFFS 100
+
+typedef enum {
+    OTA_AUTH_ERROR,
+    OTA_BEGIN_ERROR,
+    OTA_CONNECT_ERROR,
+    OTA_RECEIVE_ERROR,
+    OTA_END_ERROR
+} ota_error_t;
+
+class ArduinoOTAClass {
+   public:
+    typedef std::function<void(void)> THandlerFunction;
+    typedef std::function<void(ota_error_t)> THandlerFunction_Error;
+    typedef std::function<void(unsigned int, unsigned int)> THandlerFunction_Progress;
+
+    ArduinoOTAClass& onStart(THandlerFunction fn);
+    ArduinoOTAClass& onEnd(THandlerFunction fn);
+    ArduinoOTAClass& onError(THandlerFunction_Error fn);
+    ArduinoOTAClass& onProgress(THandlerFunction_Progress fn);
+
+    void begin();
+    void end();
+    void handle();
+    int getCommand();
+
+   private:
+    THandlerFunction start_callback_;
+    THandlerFunction end_callback_;
+    THandlerFunction_Error error_callback_;
+    THandlerFunction_Progress progress_callback_;
+    bool is_begun_ = false;
+};
+
+extern ArduinoOTAClass ArduinoOTA;
+
+#endif
@@ -0,0 +1,34 @@
+/**
+ * @file AsyncTCP.h
+ * @author Mahimana Bhatt (mahimanabhatt@gmail.com)
+ * @brief Host build of AsyncTCP, the loopback network of the simulation has
+ * no sockets, a client only stands for the connection of a request, see
+ * ESPAsyncWebServer.h
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef _HOST_ASYNC_TCP_INCLUDE_GUARD
+#define _HOST_ASYNC_TCP_INCLUDE_GUARD
+
+class AsyncWebServerRequest;
+
+class AsyncClient {
+   public:
+    explicit AsyncClient(AsyncWebServerRequest* request);
+
+    /**
+     * @brief Returns the request the connection belongs to, a response sent to
+     * it is what the client receives
+     *
+     */
+    AsyncWebServerRequest* GetRequest() const;
+
+   private:
+    AsyncWebServerRequest* request_;
+};
+
+#endif
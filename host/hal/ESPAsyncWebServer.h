@@ -0,0 +1,143 @@
+/**
+ * @file ESPAsyncWebServer.h
+ * @author Mahimana Bhatt (mahimanabhatt@gmail.com)
+ * @brief Host build of the ESPAsyncWebServer on a loopback network, a started
+ * server listens on its port of the simulated device, requests are injected by
+ * the simulation and handled on its thread (as on the AsyncTCP task)
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef _HOST_ESP_ASYNC_WEB_SERVER_INCLUDE_GUARD
+#define _HOST_ESP_ASYNC_WEB_SERVER_INCLUDE_GUARD
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "AsyncTCP.h"
+#include "WString.h"
+
+typedef enum {
+    HTTP_GET = 0b00000001,
+    HTTP_POST = 0b00000010,
+    HTTP_PUT = 0b00001000,
+    HTTP_ANY = 0b01111111
+} WebRequestMethod;
+
+typedef std::function<size_t(uint8_t* buffer, size_t max_length, size_t index)> AwsResponseFiller;
+
+class AsyncWebServerResponse {
+   public:
+    AsyncWebServerResponse(int code, const String& content_type, const std::string& content);
+    AsyncWebServerResponse(const String& content_type, size_t length, AwsResponseFiller filler);
+
+    void addHeader(const String& name, const String& value);
+
+    int GetCode() const;
+    const String& GetContentType() const;
+    const std::map<std::string, std::string>& GetHeaders() const;
+
+    /**
+     * @brief Produces the body, through the filler if there is one
+     *
+     */
+    std::string GetContent() const;
+
+   private:
+    int code_;
+    String content_type_;
+    std::string content_;
+    size_t length_ = 0;
+    AwsResponseFiller filler_;
+    std::map<std::string, std::string> headers_;
+};
+
+class AsyncWebServerRequest {
+   public:
+    AsyncWebServerRequest(WebRequestMethod method, const String& url,
+                          const std::vector<std::pair<String, String>>& args, const std::string& body = std::string());
+    ~AsyncWebServerRequest();
+
+    AsyncClient* client();
+    WebRequestMethod method() const;
+    const String& url() const;
+    bool hasArg(const char* name) const;
+    String arg(const char* name) const;
+
+    AsyncWebServerResponse* beginResponse(int code, const String& content_type = String(),
+                                          const String& content = String());
+    AsyncWebServerResponse* beginResponse(const String& content_type, size_t length, AwsResponseFiller filler);
+    AsyncWebServerResponse* beginResponse_P(int code, const String& content_type, const uint8_t* content,
+                                            size_t length);
+
+    void send(AsyncWebServerResponse* response);
+    void send(int code, const String& content_type = String(), const String& content = String());
+    void send_P(int code, const String& content_type, const char* content);
+
+    /**
+     * @brief Returns the response sent, nullptr if none was
+     *
+     */
+    const AsyncWebServerResponse* GetResponse() const;
+
+    /**
+     * @brief Returns the body, empty for a GET
+     *
+     */
+    const std::string& GetBody() const;
+
+   private:
+    WebRequestMethod method_;
+    String url_;
+    std::vector<std::pair<String, String>> args_;
+    std::string body_;
+    AsyncClient client_;
+    AsyncWebServerResponse* response_ = nullptr;
+};
+
+typedef std::function<void(AsyncWebServerRequest* request)> ArRequestHandlerFunction;
+typedef std::function<void(AsyncWebServerRequest* request, uint8_t* data, size_t length, size_t index, size_t total)>
+    ArBodyHandlerFunction;
+
+class AsyncWebServer {
+   public:
+    explicit AsyncWebServer(uint16_t port);
+    ~AsyncWebServer();
+
+    void on(const char* uri, WebRequestMethod method, ArRequestHandlerFunction handler);
+    void onNotFound(ArRequestHandlerFunction handler);
+    void onRequestBody(ArBodyHandlerFunction handler);
+    void begin();
+    void end();
+
+    /**
+     * @brief Handles a request of the loopback network, a body is passed to
+     * the body handler first in one chunk, the request is done if that
+     * answered it
+     *
+     */
+    void Handle(AsyncWebServerRequest* request);
+
+   private:
+    struct ROUTE {
+        std::string URI;
+        WebRequestMethod METHOD;
+        ArRequestHandlerFunction HANDLER;
+    };
+
+    const uint16_t port_;
+    bool is_listening_ = false;
+    std::vector<ROUTE> routes_;
+    ArRequestHandlerFunction not_found_handler_;
+    ArBodyHandlerFunction body_handler_;
+};
+
+#endif
@@ -0,0 +1,28 @@
+/**
+ * @file Esp.h
+ * @author Mahimana Bhatt (mahimanabhatt@gmail.com)
+ * @brief Host build of the ESP32 chip object, a restart is handed to the
+ * simulation which tears the firmware down and runs setup() again
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef _HOST_ESP_INCLUDE_GUARD
+#define _HOST_ESP_INCLUDE_GUARD
+
+#include <cstdint>
+
+class EspClass {
+   public:
+    void restart();
+    uint32_t getCpuFreqMHz();
+    uint32_t getCycleCount();
+    uint32_t getFreeHeap();
+};
+
+extern EspClass ESP;
+
+#endif
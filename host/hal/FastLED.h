@@ -0,0 +1,53 @@
+/**
+ * @file FastLED.h
+ * @author Mahimana Bhatt (mahimanabhatt@gmail.com)
+ * @brief Host build of the FastLED color and math used by the firmware, same
+ * integer math as the library
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef _HOST_FASTLED_INCLUDE_GUARD
+#define _HOST_FASTLED_INCLUDE_GUARD
+
+#include <cstdint>
+
+uint8_t scale8(uint8_t value, uint8_t scale);
+uint8_t scale8_video(uint8_t value, uint8_t scale);
+uint8_t triwave8(uint8_t in);
+uint8_t ease8InOutQuad(uint8_t value);
+uint8_t quadwave8(uint8_t in);
+
+struct CRGB {
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+
+    typedef enum : uint32_t {
+        Black = 0x000000,
+        Blue = 0x0000FF,
+        Cyan = 0x00FFFF,
+        Green = 0x008000,
+        Magenta = 0xFF00FF,
+        Orange = 0xFFA500,
+        Purple = 0x800080,
+        Red = 0xFF0000,
+        White = 0xFFFFFF,
+        Yellow = 0xFFFF00
+    } HTMLColorCode;
+
+    CRGB() : r(0), g(0), b(0) {}
+    CRGB(uint8_t red, uint8_t green, uint8_t blue) : r(red), g(green), b(blue) {}
+    CRGB(HTMLColorCode color) : r((color >> 16) & 0xFF), g((color >> 8) & 0xFF), b(color & 0xFF) {}
+
+    CRGB& nscale8(uint8_t scale);
+    CRGB& nscale8_video(uint8_t scale);
+
+    bool operator==(const CRGB& other) const { return r == other.r && g == other.g && b == other.b; }
+    bool operator!=(const CRGB& other) const { return !(*this == other); }
+};
+
+#endif
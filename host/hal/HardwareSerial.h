@@ -0,0 +1,47 @@
+/**
+ * @file HardwareSerial.h
+ * @author Mahimana Bhatt (mahimanabhatt@gmail.com)
+ * @brief Host build of the ESP32 UARTs, Serial prints to stdout, the other
+ * UARTs discard their output (the TMC2209 on Serial2 is simulated at register
+ * level, see TMCStepper.h)
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef _HOST_HARDWARE_SERIAL_INCLUDE_GUARD
+#define _HOST_HARDWARE_SERIAL_INCLUDE_GUARD
+
+#include <cstdint>
+#include <string>
+
+#include "Print.h"
+
+#define SERIAL_8N1 0x800001c
+
+class HardwareSerial : public Print {
+   public:
+    explicit HardwareSerial(int uart_nr);
+
+    void begin(unsigned long baud, uint32_t config = SERIAL_8N1, int8_t rx_pin = -1, int8_t tx_pin = -1);
+    void end();
+    int available();
+    int read();
+    size_t write(uint8_t value) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    void flush() override;
+    operator bool() const;
+
+   private:
+    const int uart_nr_;
+    bool is_begun_ = false;
+    std::string line_;
+};
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial1;
+extern HardwareSerial Serial2;
+
+#endif
@@ -0,0 +1,31 @@
+/**
+ * @file IPAddress.h
+ * @author Mahimana Bhatt (mahimanabhatt@gmail.com)
+ * @brief Host build of the Arduino IPv4 address
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef _HOST_IPADDRESS_INCLUDE_GUARD
+#define _HOST_IPADDRESS_INCLUDE_GUARD
+
+#include <cstdint>
+
+#include "WString.h"
+
+class IPAddress {
+   public:
+    IPAddress(uint8_t first = 0, uint8_t second = 0, uint8_t third = 0, uint8_t fourth = 0);
+
+    String toString() const;
+    uint8_t operator[](int index) const;
+    bool operator==(const IPAddress& other) const;
+
+   private:
+    uint8_t octets_[4];
+};
+
+#endif
@@ -0,0 +1,52 @@
+/**
+ * @file Preferences.h
+ * @author Mahimana Bhatt (mahimanabhatt@gmail.com)
+ * @brief Host build of the ESP32 Preferences, the NVS is kept in memory for
+ * the lifetime of the simulation, i.e. across simulated restarts
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef _HOST_PREFERENCES_INCLUDE_GUARD
+#define _HOST_PREFERENCES_INCLUDE_GUARD
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "WString.h"
+
+class Preferences {
+   public:
+    bool begin(const char* name, bool read_only = false);
+    void end();
+    bool clear();
+    bool remove(const char* key);
+    bool isKey(const char* key);
+
+    size_t putBool(const char* key, bool value);
+    size_t putInt(const char* key, int32_t value);
+    size_t putUInt(const char* key, uint32_t value);
+    size_t putString(const char* key, String value);
+    size_t putBytes(const char* key, const void* value, size_t length);
+
+    bool getBool(const char* key, bool default_value = false);
+    int32_t getInt(const char* key, int32_t default_value = 0);
+    uint32_t getUInt(const char* key, uint32_t default_value = 0);
+    String getString(const char* key, String default_value = String());
+    size_t getBytesLength(const char* key);
+    size_t getBytes(const char* key, void* buffer, size_t max_length);
+
+   private:
+    std::string namespace_;
+    bool is_open_ = false;
+    bool read_only_ = false;
+
+    size_t Put(const char* key, const void* value, size_t length);
+    bool Get(const char* key, void* value, size_t length);
+};
+
+#endif
@@ -0,0 +1,50 @@
+/**
+ * @file Print.h
+ * @author Mahimana Bhatt (mahimanabhatt@gmail.com)
+ * @brief Host build of the Arduino Print, formatting on top of a byte sink
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef _HOST_PRINT_INCLUDE_GUARD
+#define _HOST_PRINT_INCLUDE_GUARD
+
+#include <cstddef>
+#include <cstdint>
+
+#include "IPAddress.h"
+#include "WString.h"
+
+class Print {
+   public:
+    virtual ~Print() {}
+
+    /**
+     * @brief Byte sink of the printer
+     *
+     */
+    virtual size_t write(uint8_t value) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size);
+
+    size_t print(const char* value);
+    size_t print(const String& value);
+    size_t print(char value);
+    size_t print(int value);
+    size_t print(unsigned int value);
+    size_t print(long value);
+    size_t print(unsigned long value);
+    size_t print(double value, int decimals = 2);
+    size_t print(const IPAddress& value);
+
+    size_t println();
+    template <typename T>
+    size_t println(const T& value) {
+        return print(value) + println();
+    }
+    virtual void flush() {}
+};
+
+#endif
@@ -0,0 +1,39 @@
+/**
+ * @file TMCStepper.h
+ * @author Mahimana Bhatt (mahimanabhatt@gmail.com)
+ * @brief Host build of the TMCStepper library, the datagrams go to a simulated
+ * TMC2209 with a register map, VACTUAL motion, MSCNT, the INDEX output and
+ * StallGuard against the end stops of a simulated blind, see
+ * host/backend/simulation.h
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef _HOST_TMC_STEPPER_INCLUDE_GUARD
+#define _HOST_TMC_STEPPER_INCLUDE_GUARD
+
+#include <cstdint>
+
+#include "HardwareSerial.h"
+
+class TMC2209Stepper {
+   public:
+    TMC2209Stepper(HardwareSerial* serial, float r_sense, uint8_t address);
+
+    void write(uint8_t address, uint32_t value);
+    uint32_t read(uint8_t address);
+
+    uint8_t IFCNT();
+    uint16_t MSCNT();
+    uint16_t SG_RESULT();
+    uint32_t DRV_STATUS();
+    uint8_t test_connection();
+
+   private:
+    const uint8_t slave_address_;
+};
+
+#endif
@@ -0,0 +1,56 @@
+/**
+ * @file WString.h
+ * @author Mahimana Bhatt (mahimanabhatt@gmail.com)
+ * @brief Host build of the Arduino String, the subset used by the firmware on
+ * top of std::string
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef _HOST_WSTRING_INCLUDE_GUARD
+#define _HOST_WSTRING_INCLUDE_GUARD
+
+#include <string>
+
+class String {
+   public:
+    String(const char* value = "");
+    String(const std::string& value);
+    explicit String(char value);
+    String(int value);
+    String(unsigned int value);
+    String(long value);
+    String(unsigned long value);
+    String(long long value);
+    String(unsigned long long value);
+    String(float value, unsigned int decimals = 2);
+    String(double value, unsigned int decimals = 2);
+
+    const char* c_str() const;
+    unsigned int length() const;
+    bool isEmpty() const;
+    long toInt() const;
+    float toFloat() const;
+    int indexOf(const String& value, unsigned int from = 0) const;
+    String substring(unsigned int begin) const;
+    String substring(unsigned int begin, unsigned int end) const;
+    const std::string& str() const;
+
+    char operator[](unsigned int index) const;
+    bool operator==(const String& other) const;
+    bool operator!=(const String& other) const;
+    bool operator<(const String& other) const;
+    String& operator+=(const String& other);
+
+   private:
+    std::string value_;
+};
+
+String operator+(const String& lhs, const String& rhs);
+String operator+(const String& lhs, const char* rhs);
+String operator+(const char* lhs, const String& rhs);
+
+#endif
@@ -0,0 +1,55 @@
+/**
+ * @file WiFi.h
+ * @author Mahimana Bhatt (mahimanabhatt@gmail.com)
+ * @brief Host build of the ESP32 WiFi, the station connects to the simulated
+ * access point when SSID and password match and the access point is up, see
+ * host/backend/simulation.h
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef _HOST_WIFI_INCLUDE_GUARD
+#define _HOST_WIFI_INCLUDE_GUARD
+
+#include <cstdint>
+
+#include "IPAddress.h"
+#include "WString.h"
+
+typedef enum { WIFI_OFF = 0, WIFI_STA, WIFI_AP, WIFI_AP_STA } wifi_mode_t;
+typedef enum { WIFI_PS_NONE, WIFI_PS_MIN_MODEM, WIFI_PS_MAX_MODEM } wifi_ps_type_t;
+typedef enum {
+    WL_IDLE_STATUS = 0,
+    WL_NO_SSID_AVAIL = 1,
+    WL_CONNECTED = 3,
+    WL_CONNECT_FAILED = 4,
+    WL_CONNECTION_LOST = 5,
+    WL_DISCONNECTED = 6
+} wl_status_t;
+
+class WiFiClass {
+   public:
+    bool mode(wifi_mode_t mode);
+    wifi_mode_t getMode();
+    wl_status_t begin(const char* ssid, const char* password = nullptr);
+    bool disconnect(bool wifi_off = false, bool erase_ap = false);
+    bool reconnect();
+    wl_status_t status();
+    uint8_t waitForConnectResult(unsigned long timeout_ms = 60000);
+    IPAddress localIP();
+    bool setSleep(bool enabled);
+    bool setSleep(wifi_ps_type_t sleep_type);
+    wifi_ps_type_t getSleep();
+
+    bool softAPConfig(IPAddress local_ip, IPAddress gateway, IPAddress subnet);
+    bool softAP(const char* ssid, const char* password = nullptr);
+    bool softAPdisconnect(bool wifi_off = false);
+    IPAddress softAPIP();
+};
+
+extern WiFiClass WiFi;
+
+#endif
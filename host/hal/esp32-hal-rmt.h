@@ -0,0 +1,43 @@
+/**
+ * @file esp32-hal-rmt.h
+ * @author Mahimana Bhatt (mahimanabhatt@gmail.com)
+ * @brief Host build of the ESP32 RMT peripheral, transmitted frames are
+ * decoded as WS2812 data into the simulated LEDs
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef _HOST_ESP32_HAL_RMT_INCLUDE_GUARD
+#define _HOST_ESP32_HAL_RMT_INCLUDE_GUARD
+
+#include <cstddef>
+#include <cstdint>
+
+typedef struct {
+    union {
+        struct {
+            uint32_t duration0 : 15;
+            uint32_t level0 : 1;
+            uint32_t duration1 : 15;
+            uint32_t level1 : 1;
+        };
+        uint32_t val;
+    };
+} rmt_data_t;
+
+typedef struct rmt_obj_s rmt_obj_t;
+
+typedef enum { RMT_MEM_64 = 1, RMT_MEM_128, RMT_MEM_192, RMT_MEM_256 } rmt_reserve_memsize_t;
+
+#define RMT_TX_MODE true
+#define RMT_RX_MODE false
+
+rmt_obj_t* rmtInit(int pin, bool tx_not_rx, rmt_reserve_memsize_t memsize);
+float rmtSetTick(rmt_obj_t* rmt, float tick);
+bool rmtWrite(rmt_obj_t* rmt, rmt_data_t* data, size_t size);
+bool rmtDeinit(rmt_obj_t* rmt);
+
+#endif
@@ -0,0 +1,31 @@
+/**
+ * @file esp32-hal-timer.h
+ * @author Mahimana Bhatt (mahimanabhatt@gmail.com)
+ * @brief Host build of the ESP32 hardware timers, counting at the 80 MHz APB
+ * clock through the prescaler, the alarm interrupt runs on a thread per timer
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef _HOST_ESP32_HAL_TIMER_INCLUDE_GUARD
+#define _HOST_ESP32_HAL_TIMER_INCLUDE_GUARD
+
+#include <cstdint>
+
+typedef struct hw_timer_s hw_timer_t;
+
+hw_timer_t* timerBegin(uint8_t num, uint16_t divider, bool count_up);
+void timerEnd(hw_timer_t* timer);
+void timerAttachInterrupt(hw_timer_t* timer, void (*fn)(void), bool edge);
+void timerDetachInterrupt(hw_timer_t* timer);
+void timerAlarmWrite(hw_timer_t* timer, uint64_t alarm_value, bool autoreload);
+void timerAlarmEnable(hw_timer_t* timer);
+void timerAlarmDisable(hw_timer_t* timer);
+bool timerAlarmEnabled(hw_timer_t* timer);
+void timerWrite(hw_timer_t* timer, uint64_t value);
+uint64_t timerRead(hw_timer_t* timer);
+
+#endif
@@ -0,0 +1,20 @@
+/**
+ * @file esp_sleep.h
+ * @author Mahimana Bhatt (mahimanabhatt@gmail.com)
+ * @brief Host build of the ESP-IDF sleep wake up sources, the host never
+ * sleeps, wake up sources are accepted
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef _HOST_ESP_SLEEP_INCLUDE_GUARD
+#define _HOST_ESP_SLEEP_INCLUDE_GUARD
+
+#include "esp_err.h"
+
+esp_err_t esp_sleep_enable_gpio_wakeup();
+
+#endif
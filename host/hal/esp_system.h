@@ -0,0 +1,22 @@
+/**
+ * @file esp_system.h
+ * @author Mahimana Bhatt (mahimanabhatt@gmail.com)
+ * @brief Host build of the ESP-IDF system functions, the random numbers are
+ * pseudo random with a fixed seed so that simulation runs are reproducible
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef _HOST_ESP_SYSTEM_INCLUDE_GUARD
+#define _HOST_ESP_SYSTEM_INCLUDE_GUARD
+
+#include <cstdint>
+
+#include "esp_err.h"
+
+uint32_t esp_random();
+
+#endif
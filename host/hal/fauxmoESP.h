@@ -0,0 +1,83 @@
+/**
+ * @file fauxmoESP.h
+ * @author Mahimana Bhatt (mahimanabhatt@gmail.com)
+ * @brief Host build of fauxmoESP, Alexa requests are injected by the
+ * simulation for the devices of enabled instances and delivered to the state
+ * callback on the injecting thread (as on the AsyncTCP task). With its own
+ * server the port is claimed on the loopback network on the first enable and
+ * never released, without (createServer(false)) the requests are sent as
+ * HTTP PUT to the web server on the port, which hands them to process()
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef _HOST_FAUXMO_ESP_INCLUDE_GUARD
+#define _HOST_FAUXMO_ESP_INCLUDE_GUARD
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "AsyncTCP.h"
+#include "WString.h"
+
+typedef std::function<void(unsigned char, const char*, bool, unsigned char)> TSetStateCallback;
+
+class fauxmoESP {
+   public:
+    fauxmoESP();
+    ~fauxmoESP();
+
+    unsigned char addDevice(const char* device_name);
+    char* getDeviceName(unsigned char id, char* buffer, size_t length);
+    int getDeviceId(const char* device_name);
+    void onSetState(TSetStateCallback callback);
+    bool setState(unsigned char id, bool state, unsigned char value);
+    bool setState(const char* device_name, bool state, unsigned char value);
+    void createServer(bool internal);
+    void setPort(unsigned long tcp_port);
+    void enable(bool enable);
+    void handle();
+    bool process(AsyncClient* client, bool is_get, String url, String body);
+
+    /**
+     * @brief Delivers an Alexa request for a device of this instance
+     *
+     * @return true : if the instance is enabled and has the device
+     */
+    bool Request(const char* device_name, bool state, unsigned char value);
+
+    /**
+     * @brief Returns the state last reported for a device
+     *
+     * @return true : if the instance has the device
+     */
+    bool GetState(const char* device_name, bool* state, unsigned char* value) const;
+
+   private:
+    struct DEVICE {
+        std::string NAME;
+        bool STATE = false;
+        unsigned char VALUE = 0;
+    };
+
+    std::vector<DEVICE> devices_;
+    TSetStateCallback set_state_callback_;
+    unsigned long tcp_port_ = 80;
+    bool is_enabled_ = false;
+    bool is_internal_server_ = true;
+    bool is_port_claimed_ = false;
+
+    /**
+     * @brief Updates a device and calls the state callback
+     *
+     */
+    void Deliver(int id, bool state, unsigned char value);
+};
+
+#endif
@@ -0,0 +1,38 @@
+/**
+ * @file FreeRTOS.h
+ * @author Mahimana Bhatt (mahimanabhatt@gmail.com)
+ * @brief Host build of the FreeRTOS types, a tick is a millisecond as with
+ * CONFIG_FREERTOS_HZ 1000 on the ESP32, interrupts run on host threads and
+ * never preempt, yielding from them is a no-op
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef _HOST_FREERTOS_INCLUDE_GUARD
+#define _HOST_FREERTOS_INCLUDE_GUARD
+
+#include <cstdint>
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdFALSE ((BaseType_t)0)
+#define pdTRUE ((BaseType_t)1)
+#define pdFAIL pdFALSE
+#define pdPASS pdTRUE
+#define errQUEUE_FULL ((BaseType_t)0)
+#define errQUEUE_EMPTY ((BaseType_t)0)
+
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+#define portTICK_PERIOD_MS ((TickType_t)1)
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+
+#define portYIELD_FROM_ISR() \
+    do {                     \
+    } while (0)
+
+#endif
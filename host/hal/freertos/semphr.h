@@ -0,0 +1,27 @@
+/**
+ * @file semphr.h
+ * @author Mahimana Bhatt (mahimanabhatt@gmail.com)
+ * @brief Host build of the FreeRTOS semaphores, on top of queues of empty
+ * items as in FreeRTOS
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef _HOST_FREERTOS_SEMPHR_INCLUDE_GUARD
+#define _HOST_FREERTOS_SEMPHR_INCLUDE_GUARD
+
+#include "FreeRTOS.h"
+#include "queue.h"
+
+typedef QueueHandle_t SemaphoreHandle_t;
+
+#define xSemaphoreCreateBinary() xQueueCreate(1, 0)
+#define xSemaphoreTake(semaphore, ticks_to_wait) xQueueReceive((semaphore), nullptr, (ticks_to_wait))
+#define xSemaphoreGive(semaphore) xQueueSend((semaphore), nullptr, 0)
+#define xSemaphoreGiveFromISR(semaphore, woken) xQueueSendFromISR((semaphore), nullptr, (woken))
+#define vSemaphoreDelete(semaphore) vQueueDelete(semaphore)
+
+#endif
@@ -0,0 +1,18 @@
+/**
+ * @file sdkconfig.h
+ * @author Mahimana Bhatt (mahimanabhatt@gmail.com)
+ * @brief Host build of the ESP-IDF configuration, power management and
+ * tickless idle are not built in
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef _HOST_SDKCONFIG_INCLUDE_GUARD
+#define _HOST_SDKCONFIG_INCLUDE_GUARD
+
+#define CONFIG_FREERTOS_HZ 1000
+
+#endif
@@ -0,0 +1,172 @@
+/**
+ * @file main.cpp
+ * @author Dhiraj Deshmukh (deshmukhdhiraj15@gmail.com)
+ * @brief Checks the motion profiles the sketch plans, over a grid of limits,
+ * distances, start and end velocities
+ *
+ * Every plan is sampled densely and has to cover the requested distance,
+ * stay within the velocity, acceleration and jerk limits, never move
+ * backwards and end at the requested end velocity. TransitionDistance() has
+ * to be the shortest distance Plan() accepts for a velocity change, and
+ * GetDistance(), GetDuration() and GetPeakVelocity() have to agree with the
+ * samples. Prints every failure and exits with 1 if there is any.
+ *
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+
+#include "../../mvp/src/motion_profile/motion_profile.h"
+
+namespace {
+const float SAMPLE_INTERVAL_SEC = 0.0002f;
+const float DISTANCE_TOLERANCE = 0.5f;  // microsteps
+const float RELATIVE_TOLERANCE = 1e-3f;
+
+// the limits of the sketch, see MOTION_PROFILE_* and SPEED_SCHEDULER_* in
+// config.h, and some far from them
+const MotionProfile::LIMITS LIMITS_SET[] = {
+    {5000.0f, 8000.0f, 40000.0f},
+    {2000.0f, 8000.0f, 40000.0f},
+    {8000.0f, 8000.0f, 40000.0f},
+    {800.0f, 8000.0f, 40000.0f},
+    {5000.0f, 2000.0f, 200000.0f},
+    {300.0f, 50000.0f, 1000.0f},
+};
+const float DISTANCES[] = {1.0f, 10.0f, 100.0f, 1000.0f, 4000.0f, 16000.0f, 32000.0f};
+const float VELOCITY_FRACTIONS[] = {0.0f, 0.1f, 0.5f, 1.0f, 1.5f};  // of the cruise velocity
+
+int s_check_count = 0;
+int s_failure_count = 0;
+
+bool s_Near(float value, float expected, float tolerance) {
+    return std::fabs(value - expected) <= tolerance + RELATIVE_TOLERANCE * std::fabs(expected);
+}
+
+void s_Check(bool condition, const char* what, float distance, float start_velocity, float end_velocity,
+             const MotionProfile::LIMITS& limits, float value) {
+    s_check_count++;
+    if (condition) {
+        return;
+    }
+    s_failure_count++;
+    printf("[FAIL] %s: %g, distance %g, start %g, end %g, limits %g %g %g\n", what, value, distance, start_velocity,
+           end_velocity, limits.CRUISE_VELOCITY, limits.ACCELERATION, limits.JERK);
+}
+
+/**
+ * @brief Plans one move, samples it to the end and checks the samples
+ * against the limits and the request
+ *
+ */
+void s_CheckMove(float distance, float start_velocity, float end_velocity, const MotionProfile::LIMITS& limits) {
+    auto check = [&](bool condition, const char* what, float value) {
+        s_Check(condition, what, distance, start_velocity, end_velocity, limits, value);
+    };
+
+    MotionProfile profile;
+    bool reachable = profile.Plan(distance, start_velocity, end_velocity, limits);
+    float min_distance = MotionProfile::TransitionDistance(start_velocity, end_velocity, limits);
+    check(reachable == (distance >= min_distance - DISTANCE_TOLERANCE) || !s_Near(distance, min_distance, 1.0f),
+          "reachable disagrees with TransitionDistance", min_distance);
+
+    // a start above cruise velocity is slowed down from, never exceeded
+    float max_velocity = std::max(limits.CRUISE_VELOCITY, start_velocity);
+    float peak_velocity = 0;
+    float max_acceleration = 0;
+    float max_jerk_excess = 0;  // beyond the float resolution of the time
+    float max_backwards = 0;  // beyond the float resolution of the position
+    MotionProfile::SAMPLE last = profile.Sample(0);
+    check(s_Near(last.VELOCITY, start_velocity, 1.0f), "start velocity", last.VELOCITY);
+    check(last.POSITION == 0, "start position", last.POSITION);
+    float time_sec = 0;
+    for (int index = 1; !last.FINISHED; index++) {
+        float last_time_sec = time_sec;
+        time_sec = index * SAMPLE_INTERVAL_SEC;
+        MotionProfile::SAMPLE sample = profile.Sample(time_sec);
+        peak_velocity = std::max(peak_velocity, sample.VELOCITY);
+        max_acceleration = std::max(max_acceleration, std::fabs(sample.ACCELERATION));
+        if (!sample.FINISHED) {
+            float interval_sec = time_sec - last_time_sec;
+            float jerk = std::fabs(sample.ACCELERATION - last.ACCELERATION) / interval_sec;
+            float jerk_resolution = 4 * std::numeric_limits<float>::epsilon() * time_sec / interval_sec;
+            max_jerk_excess = std::max(max_jerk_excess, jerk / limits.JERK - 1 - jerk_resolution);
+        }
+        float resolution = 1e-3f + 4 * std::numeric_limits<float>::epsilon() * std::fabs(sample.POSITION);
+        max_backwards = std::max(max_backwards, last.POSITION - sample.POSITION - resolution);
+        last = sample;
+    }
+    check(max_backwards <= 0, "moves backwards", max_backwards);
+    check(peak_velocity <= max_velocity * (1 + RELATIVE_TOLERANCE) + 1.0f, "velocity above limit", peak_velocity);
+    check(max_acceleration <= limits.ACCELERATION * (1 + RELATIVE_TOLERANCE), "acceleration above limit",
+          max_acceleration);
+    check(max_jerk_excess <= RELATIVE_TOLERANCE, "jerk above limit", limits.JERK * (1 + max_jerk_excess));
+    check(s_Near(peak_velocity, profile.GetPeakVelocity(), 1.0f), "peak velocity disagrees with the samples",
+          profile.GetPeakVelocity());
+    check(s_Near(time_sec, profile.GetDuration(), SAMPLE_INTERVAL_SEC), "duration disagrees with the samples",
+          profile.GetDuration());
+
+    float planned_end_velocity = std::min(end_velocity, limits.CRUISE_VELOCITY);
+    check(last.VELOCITY == planned_end_velocity, "end velocity", last.VELOCITY);
+    check(last.ACCELERATION == 0, "end acceleration", last.ACCELERATION);
+    float end_position = profile.Sample(profile.GetDuration()).POSITION;
+    check(s_Near(end_position, profile.GetDistance(), DISTANCE_TOLERANCE), "distance disagrees with the samples",
+          end_position);
+    if (reachable) {
+        check(s_Near(end_position, distance, DISTANCE_TOLERANCE), "distance", end_position);
+    } else {
+        // brought to end velocity as fast as the limits allow
+        check(end_position > distance, "unreachable move does not overshoot", end_position);
+        check(s_Near(end_position, min_distance, DISTANCE_TOLERANCE), "overshoot longer than TransitionDistance",
+              end_position);
+    }
+}
+
+/**
+ * @brief Checks that TransitionDistance() is the shortest distance over which
+ * Plan() changes velocity directly
+ *
+ */
+void s_CheckTransition(float start_velocity, float end_velocity, const MotionProfile::LIMITS& limits) {
+    float transition_distance = MotionProfile::TransitionDistance(start_velocity, end_velocity, limits);
+    s_Check(s_Near(transition_distance, MotionProfile::TransitionDistance(end_velocity, start_velocity, limits), 0),
+            "TransitionDistance not symmetric", transition_distance, start_velocity, end_velocity, limits,
+            transition_distance);
+    if (start_velocity <= end_velocity || transition_distance < 2 * DISTANCE_TOLERANCE) {
+        return;
+    }
+    MotionProfile profile;
+    s_Check(profile.Plan(transition_distance * (1 + RELATIVE_TOLERANCE) + DISTANCE_TOLERANCE, start_velocity,
+                         end_velocity, limits),
+            "rejects TransitionDistance", transition_distance, start_velocity, end_velocity, limits,
+            transition_distance);
+    s_Check(!profile.Plan(transition_distance * (1 - RELATIVE_TOLERANCE) - DISTANCE_TOLERANCE, start_velocity,
+                          end_velocity, limits),
+            "accepts less than TransitionDistance", transition_distance, start_velocity, end_velocity, limits,
+            transition_distance);
+}
+}  // namespace
+
+int main() {
+    for (const MotionProfile::LIMITS& limits : LIMITS_SET) {
+        for (float start_fraction : VELOCITY_FRACTIONS) {
+            float start_velocity = start_fraction * limits.CRUISE_VELOCITY;
+            for (float end_fraction : VELOCITY_FRACTIONS) {
+                float end_velocity = std::min(end_fraction, 1.0f) * limits.CRUISE_VELOCITY;
+                s_CheckTransition(start_velocity, end_velocity, limits);
+                for (float distance : DISTANCES) {
+                    s_CheckMove(distance, start_velocity, end_velocity, limits);
+                }
+            }
+        }
+    }
+    printf("%d checks, %d failed\n", s_check_count, s_failure_count);
+    return s_failure_count ? 1 : 0;
+}
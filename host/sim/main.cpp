@@ -0,0 +1,313 @@
+/**
+ * @file main.cpp
+ * @author Dhiraj Deshmukh (deshmukhdhiraj15@gmail.com)
+ * @brief Runs the sketch on the host against the simulated device, driven by
+ * a scenario script (see host/README.md)
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <Arduino.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "../../mvp/mvp.ino"
+#include "host_backend.h"
+#include "simulation.h"
+
+namespace {
+// a tap as pressed by hand
+const unsigned long TAP_PRESS_MS = 100;
+const unsigned long TAP_GAP_MS = 150;
+
+bool s_is_boot_requested = false;  // under the kernel lock
+
+[[noreturn]] void s_Exit(int code) {
+    // the sketch never returns from loop(), the process ends here
+    std::fflush(stdout);
+    std::fflush(stderr);
+    std::_Exit(code);
+}
+
+[[noreturn]] void s_Fail(int line_number, const std::string& line, const std::string& reason) {
+    HOST_SIM::Report(String("line ") + String(line_number) + ": '" + line + "' " + reason);
+    s_Exit(1);
+}
+
+bool s_GetButtonPins(const std::string& button, std::vector<int>& pins) {
+    using namespace CONFIG_SET;
+    if (button == "up" || button == "both") {
+        pins.push_back(PIN_BUTTON_UP);
+    }
+    if (button == "down" || button == "both") {
+        pins.push_back(PIN_BUTTON_DOWN);
+    }
+    return !pins.empty();
+}
+
+void s_SetButtons(const std::vector<int>& pins, int level) {
+    for (int pin : pins) {
+        HOST_SIM::SetPinLevel(pin, level);
+    }
+}
+
+/**
+ * @brief Replays a recorded button trace, one '<ms> up|down|both <level>'
+ * per line, times from the start of the trace
+ *
+ * @return std::string : why the trace could not be played, empty if played
+ */
+std::string s_PlayTrace(const std::string& path) {
+    std::ifstream trace(path);
+    if (!trace) {
+        return "cannot open " + path;
+    }
+    uint64_t start_us = HOST_BACKEND::NowUs();
+    std::string line;
+    for (int line_number = 1; std::getline(trace, line); line_number++) {
+        std::istringstream words(line);
+        double time_ms = 0;
+        std::string button;
+        int level = 0;
+        std::vector<int> pins;
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        if (!(words >> time_ms >> button >> level) || !s_GetButtonPins(button, pins)) {
+            return path + ":" + std::to_string(line_number) + " expects: <ms> up|down|both <level>";
+        }
+        HOST_BACKEND::SleepUntilUs(start_us + uint64_t(std::llround(time_ms * 1000)));
+        s_SetButtons(pins, level);
+    }
+    return "";
+}
+
+double s_GetBlindPercent(const HOST_SIM::BLIND& blind) {
+    return 100.0 * HOST_SIM::GetBlindMicrostep() / blind.TRAVEL_MICROSTEPS;
+}
+
+void s_ReportStatus() {
+    CRGB led = HOST_SIM::GetLed(0);
+    char color[8];
+    std::snprintf(color, sizeof(color), "#%02X%02X%02X", led.r, led.g, led.b);
+    HOST_SIM::Report(String("blind ") + String(HOST_SIM::GetBlindMicrostep()) + " microsteps, station " +
+                     (HOST_SIM::IsStationConnected() ? "connected" : "disconnected") + ", soft AP " +
+                     (HOST_SIM::IsSoftAPEnabled() ? "on" : "off") + ", LED " + color + ", " +
+                     String(HOST_SIM::GetLedFrameCount()) + " frames, " +
+                     String(HOST_SIM::GetDriverWriteCount()) + " driver writes");
+}
+
+void s_Boot() {
+    std::unique_lock<std::mutex> lock = HOST_BACKEND::LockKernel();
+    s_is_boot_requested = true;
+    HOST_BACKEND::Notify(&s_is_boot_requested);
+}
+
+/**
+ * @brief Runs the scenario on its own thread, the sketch runs on the main one
+ *
+ */
+void s_RunScenario(std::vector<std::string> lines, std::string directory) {
+    HOST_SIM::BLIND blind;
+    for (size_t index = 0; index < lines.size(); index++) {
+        const std::string& line = lines[index];
+        int line_number = index + 1;
+        std::istringstream words(line);
+        std::string command;
+        if (!(words >> command) || command[0] == '#') {
+            continue;
+        }
+
+        if (command == "blind") {
+            if (!(words >> blind.TRAVEL_MICROSTEPS >> blind.START_MICROSTEP)) {
+                s_Fail(line_number, line, "expects: blind <travel microsteps> <start microstep>");
+            }
+            HOST_SIM::SetBlind(blind);
+        } else if (command == "ap") {
+            std::string first, second;
+            words >> first;
+            if (first == "up" || first == "down") {
+                HOST_SIM::SetAccessPointUp(first == "up");
+            } else if (words >> second) {
+                HOST_SIM::SetAccessPoint(first, second);
+            } else {
+                s_Fail(line_number, line, "expects: ap <ssid> <password> | ap up | ap down");
+            }
+        } else if (command == "seed") {
+            uint32_t seed = 0;
+            if (!(words >> seed)) {
+                s_Fail(line_number, line, "expects: seed <n>");
+            }
+            HOST_SIM::SetRandomSeed(seed);
+        } else if (command == "boot") {
+            s_Boot();
+        } else if (command == "wait") {
+            unsigned long duration_ms = 0;
+            if (!(words >> duration_ms)) {
+                s_Fail(line_number, line, "expects: wait <ms>");
+            }
+            delay(duration_ms);
+        } else if (command == "press") {
+            std::string button;
+            unsigned long duration_ms = 0;
+            std::vector<int> pins;
+            if (!(words >> button >> duration_ms) || !s_GetButtonPins(button, pins)) {
+                s_Fail(line_number, line, "expects: press up|down|both <ms>");
+            }
+            s_SetButtons(pins, HIGH);
+            delay(duration_ms);
+            s_SetButtons(pins, LOW);
+        } else if (command == "tap") {
+            std::string button;
+            int count = 1;
+            std::vector<int> pins;
+            if (!(words >> button) || !s_GetButtonPins(button, pins)) {
+                s_Fail(line_number, line, "expects: tap up|down|both [count]");
+            }
+            words >> count;
+            for (int i = 0; i < count; i++) {
+                s_SetButtons(pins, HIGH);
+                delay(TAP_PRESS_MS);
+                s_SetButtons(pins, LOW);
+                delay(TAP_GAP_MS);
+            }
+        } else if (command == "trace") {
+            std::string path;
+            if (!(words >> path)) {
+                s_Fail(line_number, line, "expects: trace <file>");
+            }
+            std::string error = s_PlayTrace(path[0] == '/' ? path : directory + path);
+            if (!error.empty()) {
+                s_Fail(line_number, line, error);
+            }
+        } else if (command == "http") {
+            uint16_t port = 0;
+            std::string url, pair;
+            if (!(words >> port >> url)) {
+                s_Fail(line_number, line, "expects: http <port> <url> [key=value...]");
+            }
+            std::vector<std::pair<String, String>> args;
+            while (words >> pair) {
+                size_t separator = pair.find('=');
+                args.push_back({pair.substr(0, separator),
+                                separator == std::string::npos ? "" : pair.substr(separator + 1)});
+            }
+            HOST_SIM::HTTP_RESPONSE response = HOST_SIM::HttpGet(port, url, args);
+            HOST_SIM::Report(String("http ") + String(port) + url + " -> " + String(response.CODE) + ", " +
+                             String(uint32_t(response.BODY.size())) + " bytes");
+        } else if (command == "alexa") {
+            std::string device;
+            int percent = 0;
+            if (!(words >> device >> percent)) {
+                s_Fail(line_number, line, "expects: alexa <device> <percent>");
+            }
+            bool is_delivered = HOST_SIM::AlexaRequest(device, percent > 0, (percent * 255 + 50) / 100);
+            HOST_SIM::Report(String("alexa ") + device + " " + String(percent) + "% " +
+                             (is_delivered ? "delivered" : "not delivered"));
+        } else if (command == "expect") {
+            std::string what;
+            words >> what;
+            if (what == "alexa") {
+                std::string device;
+                double percent = 0, tolerance = 1;
+                if (!(words >> device >> percent)) {
+                    s_Fail(line_number, line, "expects: expect alexa <device> <percent> [tolerance]");
+                }
+                words >> tolerance;
+                bool state = false;
+                uint8_t value = 0;
+                if (!HOST_SIM::GetAlexaState(device, &state, &value)) {
+                    s_Fail(line_number, line, "failed, no such Alexa device");
+                }
+                double reported = state ? value / 2.55 : 0;
+                if (std::fabs(reported - percent) > tolerance) {
+                    s_Fail(line_number, line, "failed, Alexa reports " + std::to_string(reported) + "%");
+                }
+            } else if (what == "blind") {
+                double percent = 0, tolerance = 1;
+                if (!(words >> percent)) {
+                    s_Fail(line_number, line, "expects: expect blind <percent> [tolerance]");
+                }
+                words >> tolerance;
+                double position = s_GetBlindPercent(blind);
+                if (std::fabs(position - percent) > tolerance) {
+                    s_Fail(line_number, line, "failed, blind is at " + std::to_string(position) + "%");
+                }
+            } else if (what == "connected") {
+                int is_expected = 0;
+                if (!(words >> is_expected)) {
+                    s_Fail(line_number, line, "expects: expect connected 0|1");
+                }
+                if (HOST_SIM::IsStationConnected() != bool(is_expected)) {
+                    s_Fail(line_number, line, "failed");
+                }
+            } else {
+                s_Fail(line_number, line, "unknown expectation");
+            }
+            HOST_SIM::Report(String("line ") + String(line_number) + ": '" + line + "' passed");
+        } else if (command == "status") {
+            s_ReportStatus();
+        } else if (command == "quit") {
+            int code = 0;
+            words >> code;
+            s_Exit(code);
+        } else {
+            s_Fail(line_number, line, "unknown command");
+        }
+    }
+    s_Exit(0);
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::vector<std::string> lines;
+    std::string line;
+    // traces are found next to the script
+    std::string directory;
+    if (argc > 1) {
+        std::string path(argv[1]);
+        directory = path.substr(0, path.find_last_of('/') + 1);
+        std::ifstream script(argv[1]);
+        if (!script) {
+            std::fprintf(stderr, "cannot open %s\n", argv[1]);
+            return 2;
+        }
+        while (std::getline(script, line)) {
+            lines.push_back(line);
+        }
+    } else {
+        while (std::getline(std::cin, line)) {
+            lines.push_back(line);
+        }
+    }
+    std::thread(s_RunScenario, lines, directory).detach();
+
+    {
+        std::unique_lock<std::mutex> lock = HOST_BACKEND::LockKernel();
+        HOST_BACKEND::WaitUntilUs(lock, &s_is_boot_requested, HOST_BACKEND::FOREVER,
+                                  []() { return s_is_boot_requested; });
+    }
+    setup();
+    while (true) {
+        loop();
+        if (HOST_SIM::IsRestartRequested()) {
+            // RAM is lost, the flash and the blind stay as they are
+            ctrl.reset();
+            HOST_SIM::ClearRestartRequest();
+            setup();
+        }
+    }
+}
@@ -25,7 +25,7 @@ void setup() {
 
 /**
  * @brief Runs recurrently until power on after setup, handles the device
- * functioning
+ * functioning, each pass blocks in the controller until an event or deadline
  *
  */
 void loop() {
@@ -17,18 +17,22 @@
 #include <tuple>
 
 #include "../config/config.h"
+#include "../event_queue/event_queue.h"
+#include "../latency/latency.h"
 #include "../logging/logging.h"
 #include "fauxmoESP.h"
 
 // declaring static variables to be used by callback
-bool AlexaInteraction::is_new_request_available_ = false;
-CONFIG_SET::MOTION_REQUEST AlexaInteraction::latest_alexa_request_ = CONFIG_SET::MOTION_REQUEST();
 String AlexaInteraction::device_id_ = CONFIG_SET::DEFAULT_DEVICE_ID;
-std::mutex AlexaInteraction::alexa_request_mutex_;
+std::shared_ptr<EventQueue> AlexaInteraction::event_queue_{nullptr};
 
-AlexaInteraction::AlexaInteraction(std::shared_ptr<Logging>& logging, String device_id)
+AlexaInteraction::AlexaInteraction(std::shared_ptr<Logging>& logging, String device_id,
+                                   std::shared_ptr<EventQueue> event_queue)
     : logger_(logging), fauxmoESP() {
     device_id_ = device_id;
+    event_queue_ = event_queue;
+    // port 80 is shared with the reset webpage, see Connectivity::ServeAlexa()
+    this->createServer(false);
     this->setPort(80);
     this->enable(true);
     this->addDevice(device_id_.c_str());
@@ -36,32 +40,36 @@ AlexaInteraction::AlexaInteraction(std::shared_ptr<Logging>& logging, String dev
 }
 
 void AlexaInteraction::Callback(unsigned char id, const char* device_name, bool state, unsigned char percentage) {
-    if (strcmp(device_name, AlexaInteraction::device_id_.c_str()) == 0) {
-        std::unique_lock<std::mutex> lock(alexa_request_mutex_);
-        AlexaInteraction::latest_alexa_request_.PERCENTAGE = (float(percentage) / 255) * 100;
+    using namespace CONFIG_SET;
+    if (strcmp(device_name, AlexaInteraction::device_id_.c_str()) == 0 && event_queue_) {
+        CONTROLLER_EVENT event;
+        event.TYPE = CONTROLLER_EVENT_TYPE::ALEXA_REQUEST;
+        event.REQUEST.PERCENTAGE = (float(percentage) / 255) * 100;
         if (percentage == 255 || percentage == 254) {
-            latest_alexa_request_.PERCENTAGE = 100;
+            event.REQUEST.PERCENTAGE = 100;
         }
         if (!state) {
-            latest_alexa_request_.PERCENTAGE = 0;
+            event.REQUEST.PERCENTAGE = 0;
         }
-        AlexaInteraction::is_new_request_available_ = true;
+        event_queue_->Post(event);
     }
 }
 
 AlexaInteraction::~AlexaInteraction() {}
 
-std::tuple<bool, CONFIG_SET::MOTION_REQUEST> AlexaInteraction::GetAlexaRequest() {
-    std::unique_lock<std::mutex> lock(alexa_request_mutex_);
-    std::tuple<bool, CONFIG_SET::MOTION_REQUEST> return_value(is_new_request_available_, latest_alexa_request_);
-    is_new_request_available_ = false;
-    return return_value;
-}
-
 void AlexaInteraction::HandleFauxmo() {
+    LatencyTimer timer(CONFIG_SET::LATENCY_PROBE::FAUXMO_HANDLE);
     this->handle();
 }
 
 void AlexaInteraction::SetState(CONFIG_SET::MOTION_REQUEST request) {
     this->setState(device_id_.c_str(), request.PERCENTAGE != 0, request.PERCENTAGE * 2.55);
-}
\ No newline at end of file
+}
+
+void AlexaInteraction::Enable(bool enable) {
+    this->enable(enable);
+}
+
+bool AlexaInteraction::Process(AsyncWebServerRequest* request, const String& body) {
+    return this->process(request->client(), request->method() == HTTP_GET, request->url(), body);
+}
@@ -12,12 +12,15 @@
 #ifndef _ALEXA_INT_INCLUDE_GUARD
 #define _ALEXA_INT_INCLUDE_GUARD
 
+#include <ESPAsyncWebServer.h>
+
 #include <mutex>
 #include <sstream>
 #include <string>
 #include <tuple>
 
 #include "../config/config.h"
+#include "../event_queue/event_queue.h"
 #include "../logging/logging.h"
 #include "fauxmoESP.h"
 
@@ -25,9 +28,12 @@ class AlexaInteraction : private fauxmoESP {
    public:
     /**
    * @brief Construct a new AlexaInteraction object, initializes fauxmoesp
+   * without its own TCP server, the HTTP requests of Alexa are handed in
+   * through Process(), Alexa requests are posted to the event queue as
+   * ALEXA_REQUEST
    *
    */
-    AlexaInteraction(std::shared_ptr<Logging>& logging, String device_id);
+    AlexaInteraction(std::shared_ptr<Logging>& logging, String device_id, std::shared_ptr<EventQueue> event_queue);
 
     /**
    * @brief Destroy the AlexaInteraction object
@@ -35,13 +41,6 @@ class AlexaInteraction : private fauxmoESP {
    */
     ~AlexaInteraction();
 
-    /**
-   * @brief Get the latest Alexa Request object
-   *
-   * @return std::tuple<bool, CONFIG_SET::MOTION_REQUEST>
-   */
-    std::tuple<bool, CONFIG_SET::MOTION_REQUEST> GetAlexaRequest();
-
     /**
    * @brief Handler function for the class
    *
@@ -54,12 +53,26 @@ class AlexaInteraction : private fauxmoESP {
    */
     void SetState(CONFIG_SET::MOTION_REQUEST request);
 
+    /**
+   * @brief Enables or disables answering Alexa
+   *
+   */
+    void Enable(bool enable);
+
+    /**
+   * @brief Answers an HTTP request of Alexa, called by the web server on
+   * port 80
+   *
+   * @param body: body of the request, empty if none
+   * @return true : if it was a request of Alexa and is answered
+   * @return false : otherwise
+   */
+    bool Process(AsyncWebServerRequest* request, const String& body);
+
    private:
     std::shared_ptr<Logging> logger_;
-    static std::mutex alexa_request_mutex_;
     static String device_id_;
-    static bool is_new_request_available_;
-    static CONFIG_SET::MOTION_REQUEST latest_alexa_request_;
+    static std::shared_ptr<EventQueue> event_queue_;
 
     /**
    * @brief Gets called by fauxmo esp when a alexa calls the device
@@ -21,6 +21,9 @@
 #include <deque>
 #include <iostream>
 
+#include "../logging/log_format.h"
+#include "../monotonic_clock/monotonic_clock.h"
+
 /**
  * @brief Namespace to be used for constants/enums
  *
@@ -28,17 +31,32 @@
 namespace CONFIG_SET {
 
 const int LOGGING_BAUD_RATE = 115200;
+const uint32_t LOG_RING_CAPACITY = 32;           // records waiting for the drain task, power of two
+const uint32_t LOG_ARGS_LENGTH = 56;             // bytes of binary arguments per record, the rest is left out
+const UBaseType_t LOG_DRAIN_TASK_PRIORITY = 1;   // just above idle, below the default 5 of the other threads
+const unsigned long LOG_FLUSH_TIMEOUT_MS = 500;  // longest wait for the queued records before a restart
 const int MOTOR_DRIVER_BAUD_RATE = 115200;
-const int TRY_RECONNECT = 3;            // 3 seconds
-const int MAX_SECONDS_LOST_WIFI = 600;  // 10 mins
+const int TRY_RECONNECT = 3;  // 3 seconds, link check interval while connected
+const int64_t WIFI_CONNECT_TIMEOUT_MS = 10000;
+const unsigned long WIFI_CONNECT_POLL_INTERVAL_MS = 100;
+const unsigned long WIFI_RECONNECT_MIN_BACKOFF_MS = 3000;    // doubled after every failed attempt
+const unsigned long WIFI_RECONNECT_MAX_BACKOFF_MS = 300000;  // 5 mins
+const unsigned long WIFI_RECONNECT_STAGGER_MS = 30000;       // spread of the first attempt after losing the link
 const std::string STORAGE_NAMESPACE = "madac";
 
 // Vars For Indicator Class
 const int NUMBER_OF_LEDS = 1;
 const int LED_BRIGHTNESS = 25;
 
-// Freq var for Manual Interaction Class
-const int DEQUE_ANALYZER_FREQ = 2;
+// Vars for Manual Interaction Class
+const uint32_t BUTTON_EDGE_RING_CAPACITY = 32;       // edges between two analyser runs, power of two
+const uint8_t BUTTON_SAMPLE_TIMER_ID = 1;            // hardware timer sampling the buttons, 0 is the motion profile
+const uint16_t BUTTON_SAMPLE_TIMER_PRESCALER = 80;   // 80 MHz APB clock -> 1 us timer resolution
+const uint32_t BUTTON_SAMPLE_INTERVAL_US = 1000;     // 1 kHz while a button changes, off once settled
+const uint8_t BUTTON_DEBOUNCE_SAMPLES = 10;          // net samples at a level before it is taken, ~10 ms
+const int64_t GESTURE_LONG_PRESS_MS = 1100;          // buttons held this long are a long press
+const int64_t GESTURE_TAP_GAP_MS = 400;              // a tap ends its gesture unless pressed again within this
+const int MANUAL_NUDGE_STEPS = 800;                  // microsteps a single tap moves the blind, a quarter revolution
 
 /*
 ****** STORAGE KEYS ******
@@ -49,6 +67,10 @@ const std::string KEY_PASSWORD = "password";
 const std::string KEY_DEVICE_ID = "deviceID";
 const std::string KEY_TOTAL_STEP_COUNT = "totalStepCount";
 const std::string KEY_DIRECTION = "direction";
+const std::string KEY_SG_THRESHOLD = "sgThreshold";
+const std::string KEY_SG_MARGIN = "sgMargin";
+const std::string KEY_PERCENT_MAP = "percentMap";
+const std::string KEY_PERCENT_MARKS = "percentMarks";
 const std::string KEY_MODE = "mode";
 const String DEFAULT_DEVICE_ID = "madac_blinds";
 
@@ -65,12 +87,144 @@ const uint32_t MOTOR_DRIVER_TCOOL_THRS = 0xFFFFF;
 const uint8_t MOTOR_DRIVER_SE_MIN = 0;
 const uint8_t MOTOR_DRIVER_SE_MAX = 2;
 const uint8_t MOTOR_DRIVER_SEDN = 0b01;
-const uint32_t MOTOR_DRIVER_MAX_SPEED = 5000;
+const uint32_t MOTOR_DRIVER_MAX_SPEED = 11200;  // VACTUAL ceiling, ~8000 microsteps/s
 const int MOTOR_DRIVER_SG_THRESH = 45;
-const int MOTOR_STOP_TIME_SEC = 120;                // 2 mins
-const float STEP_FRACTION_ALLOWANCE = 0.05;         // 5% Allowance allowed for motor reaching destination
-const int MODE_EXPIRE_TIME_LIMIT = 300;             // 5 mins
-const int WIFI_DISCONNECT_RESTART_TIME_LIMIT = 60;  // 1 mins
+const float MOTOR_DRIVER_HOLD_MULTIPLIER = 0.5f;       // IHOLD = IRUN * multiplier
+const bool MOTOR_DRIVER_VERIFY_WRITES = true;          // read back IFCNT and readable registers after configuring
+const bool MOTOR_DRIVER_IDLE_HOLD = false;             // hold at IHOLD between moves instead of switching off
+const uint8_t MOTOR_DRIVER_IHOLD_DELAY = 8;            // 2^18 clocks per current step down to IHOLD
+const uint8_t MOTOR_DRIVER_TPOWERDOWN = 20;            // 2^18 clocks (~0.44 s) standstill before dropping to IHOLD
+const int MOTOR_STOP_TIME_SEC = 120;                   // 2 mins
+const unsigned long MOTOR_STALL_BLANK_TIME_MS = 1000;  // stall is ignored while motor spins up
+const int STEP_STOP_WINDOW = MOTOR_DRIVER_MICROSTEP;   // 1 full step allowed for motor reaching destination
+const int MODE_EXPIRE_TIME_LIMIT = 300;                // 5 mins
+const int WIFI_DISCONNECT_RESTART_TIME_LIMIT = 60;     // 1 mins
+
+/*
+****** MOTION PROFILE PARAMETERS ******
+Velocities are in microsteps per second, they are converted to VACTUAL
+register units using the internal clock of TMC2209 (VACTUAL = v * 2^24 / fCLK)
+*/
+const float MOTOR_DRIVER_CLOCK_HZ = 12000000.0f;
+const float MOTION_PROFILE_CRUISE_VELOCITY = 5000.0f;  // microsteps / s
+const float MOTION_PROFILE_ACCELERATION = 8000.0f;     // microsteps / s^2
+const float MOTION_PROFILE_JERK = 40000.0f;            // microsteps / s^3
+const float MOTION_PROFILE_CREEP_VELOCITY = 800.0f;    // velocity for running into the end stops
+const uint8_t MOTION_PROFILE_TIMER_ID = 0;
+const uint16_t MOTION_PROFILE_TIMER_PRESCALER = 80;  // 80 MHz APB clock -> 1 us timer resolution
+const uint32_t MOTION_PROFILE_TICK_US = 5000;        // 200 Hz velocity updates
+
+/*
+****** POSITION ESTIMATOR PARAMETERS ******
+MSCNT is read over UART at most every POSITION_ESTIMATOR_READ_INTERVAL_US while
+moving, position is predicted from the commanded travel in between, the
+estimate holds while DIAG or SG_RESULT (when cruising) flags a stall
+*/
+const int64_t POSITION_ESTIMATOR_READ_INTERVAL_US = 20000;
+const int MAX_TARGET_CORRECTIONS = 2;  // inline re-plans when a move lands short of the stop window
+const int MOTION_FEEDBACK_QUEUE_SIZE = 8;
+
+/*
+****** SPEED SCHEDULER PARAMETERS ******
+DRV_STATUS and SG_RESULT are polled while moving, cruise velocity starts at
+MOTION_PROFILE_CRUISE_VELOCITY and adapts between MIN and MAX velocity to the
+load and temperature of the driver
+*/
+const int64_t SPEED_SCHEDULER_POLL_INTERVAL_US = 100000;
+const float SPEED_SCHEDULER_MIN_VELOCITY = 2000.0f;
+const float SPEED_SCHEDULER_MAX_VELOCITY = 8000.0f;
+const float SPEED_SCHEDULER_STEP_UP = 250.0f;              // microsteps / s per poll with headroom
+const float SPEED_SCHEDULER_BACK_OFF = 0.8f;               // velocity factor per poll without headroom
+const int SPEED_SCHEDULER_SG_LOW_MARGIN = 40;              // SG_RESULT above stall level
+const int SPEED_SCHEDULER_SG_HIGH_MARGIN = 120;            // SG_RESULT above stall level
+const int SPEED_SCHEDULER_CS_HEADROOM = 4;                 // CS_ACTUAL below IRUN
+const int64_t SPEED_SCHEDULER_THERMAL_HOLD_US = 60000000;  // 1 min without raising after a temperature warning
+
+/*
+****** STALLGUARD TUNING PARAMETERS ******
+SG_RESULT (0-510, higher means less load) is sampled while cruising during
+calibration, stall is signalled by driver when SG_RESULT <= 2 * SGTHRS
+*/
+const int STALLGUARD_HISTOGRAM_BINS = 32;
+const int STALLGUARD_MIN_SAMPLES = 50;
+const float STALLGUARD_PERCENTILE = 0.05f;       // low percentile of free running load taken as reference
+const float STALLGUARD_MARGIN_FRACTION = 0.35f;  // fraction of reference kept as headroom before stall
+
+/*
+****** CALIBRATION PARAMETERS ******
+Each end is found by a fast seek into the end stop, a back off and a slow
+approach at creep velocity. A stall during a normal traversal within
+END_STOP_MAX_DRIFT_FRACTION of the calibrated end updates TOTAL_STEP_COUNT
+*/
+const int CALIBRATION_BACKOFF_STEPS = 200 * MOTOR_DRIVER_MICROSTEP;  // 1 revolution
+const float END_STOP_MAX_DRIFT_FRACTION = 0.05f;
+
+/*
+****** TELEMETRY PARAMETERS ******
+Every move is recorded into a ring buffer, downloadable as binary blob from
+http://<device ip>:TELEMETRY_SERVER_PORT/telemetry in operation mode (port 80
+serves Alexa and the reset webpage)
+*/
+const int64_t TELEMETRY_SAMPLE_INTERVAL_US = 50000;  // 20 Hz
+const int TELEMETRY_SERVER_PORT = 8080;
+
+/*
+****** PERCENT MAP PARAMETERS ******
+Opening percentage is mapped to steps through PERCENT_MAP_KNOTS knots (every 5
+percent), initialised at calibration from the roller wrap ratio and refined
+by marks sent to http://<device ip>:TELEMETRY_SERVER_PORT/mark?percent=<5-95>
+while the blind stands at that opening, only the inner knots can be marked
+*/
+const int PERCENT_MAP_KNOTS = 21;
+const float ROLLER_WRAP_RATIO = 1.0f;  // wrap diameter at 100% / at 0%, 1.0 is linear
+
+/*
+****** POWER PARAMETERS ******
+In operation mode the device idles POWER_IDLE_TIMEOUT_MS after the last
+motion, button or network request: the CPU is clocked down, WiFi modem sleeps
+between DTIM beacons and the controller polls less often, so that the CPU light
+sleeps where automatic light sleep is built in. Buttons, network traffic and
+the controller deadline wake it up
+*/
+const int64_t POWER_IDLE_TIMEOUT_MS = 5000;
+const unsigned long POWER_IDLE_POLL_INTERVAL_MS = 250;  // CONTROLLER_POLL_INTERVAL_MS while idle
+const uint32_t POWER_ACTIVE_CPU_FREQ_MHZ = 240;
+const uint32_t POWER_IDLE_CPU_FREQ_MHZ = 80;   // lowest that keeps WiFi and the 80 MHz APB clock
+const bool POWER_IDLE_MAX_MODEM_SLEEP = true;  // skip DTIM beacons per listen interval while idle
+
+/*
+****** CONTROLLER PARAMETERS ******
+Controller blocks on its event queue until an event is posted or its next
+deadline, Alexa discovery and OTA are UDP based and polled every
+CONTROLLER_POLL_INTERVAL_MS
+*/
+const int CONTROLLER_EVENT_QUEUE_SIZE = 16;
+const unsigned long CONTROLLER_POLL_INTERVAL_MS = 50;
+
+/*
+****** INDICATOR PARAMETERS ******
+LED frames are sent by the RMT peripheral and only when they change, animated
+effects (breathing, blink codes, position progress) are rendered by a timer at
+INDICATOR_FRAME_RATE_HZ which only runs while one is shown
+*/
+const int INDICATOR_FRAME_RATE_HZ = 25;
+const int INDICATOR_RMT_TICK_NS = 100;  // WS2812 bit timing resolution
+const unsigned long INDICATOR_BREATHE_PERIOD_MS = 3000;
+const unsigned long INDICATOR_BLINK_MS = 200;         // on and off time of a blink code
+const unsigned long INDICATOR_BLINK_PAUSE_MS = 1000;  // between repetitions of a blink code
+const int INDICATOR_FAULT_BLINKS = 3;
+const uint8_t INDICATOR_DIM_LEVEL = 32;  // floor of breathing and of the unlit part of the progress bar
+
+/*
+****** LATENCY PARAMETERS ******
+Task iterations and sections (fauxmo, LED frames, driver UART) are timed into
+histograms, see latency.h, whose percentiles are logged every
+LATENCY_REPORT_INTERVAL_MS and which are served with their buckets as text on
+http://<device ip>:TELEMETRY_SERVER_PORT/latency in operation mode,
+/latency?clear=1 drops the samples
+*/
+const int LATENCY_BUCKET_COUNT = 20;                 // the last one from 2^18 us (262 ms) up
+const int64_t LATENCY_REPORT_INTERVAL_MS = 3600000;  // 1 hour, 0 never logs
 
 enum class OPERATION_MODE {
     RESET,
@@ -111,25 +265,25 @@ const int PIN_MD_DIR = 23;
 const int PIN_MD_INDEX = 21;
 const int PIN_MD_DIAG = 19;
 
-enum class LOG_TYPE {
-    INFO,
-    ERROR,
-    WARN,
-};
-
-enum class LOG_CLASS {
-    CONTROLLER,
-    CONNECTIVITY,
-    INDICATOR,
-    LOGGING,
-    MANUAL_INTERACTION,
-    MOTOR_DRIVER,
-    STORAGE,
-    ALEXA_INTERACTION,
+enum class LATENCY_PROBE {
+    CONTROLLER_HANDLE,       // handling of an event or poll
+    CONTROLLER_LATENESS,     // event posted or poll deadline to handling
+    MOTOR_HANDLER,           // one motor handler iteration
+    MOTOR_LATENESS,          // profile tick interrupt to handler
+    BUTTON_ANALYSER,         // one button analyser iteration
+    BUTTON_LATENESS,         // button edge or gesture timeout to handling
+    CONNECTIVITY_RECONNECT,  // starting a connection attempt
+    CONNECTIVITY_LATENESS,   // connectivity handler deadline to run
+    FAUXMO_HANDLE,
+    LED_SHOW,
+    UART_TRANSACTION,  // one driver register read or write
+    COUNT,
 };
 
 enum class MANUAL_PUSH {
     NO_PUSH,
+    SINGLE_TAP_UP,
+    SINGLE_TAP_DOWN,
     LONG_PRESS_UP,
     LONG_PRESS_DOWN,
     LONG_PRESS_BOTH,
@@ -138,27 +292,118 @@ enum class MANUAL_PUSH {
     DOUBLE_TAP_BOTH,
 };
 
-enum class BUTTON_PRESS {
-    NO_PUSH,
-    LONG_PRESS,
-    DOUBLE_TAP,
+/*
+****** GESTURE TABLE ******
+A gesture is a chord of buttons pressed together and either tapped TAPS times
+or held for GESTURE_LONG_PRESS_MS (TAPS = 0). A held gesture lasts until its
+buttons are released, which is reported as NO_PUSH and also stops a jog of the
+motor right away through MotorDriver::StopJog(). A tap count is reported as
+soon as no gesture of the chord has more taps, otherwise GESTURE_TAP_GAP_MS
+after the last release.
+*/
+const uint8_t GESTURE_BUTTON_UP = 1;
+const uint8_t GESTURE_BUTTON_DOWN = 2;
+const uint8_t GESTURE_BUTTON_BOTH = GESTURE_BUTTON_UP | GESTURE_BUTTON_DOWN;
+
+struct GESTURE {
+    uint8_t BUTTONS;  // GESTURE_BUTTON_* mask
+    uint8_t TAPS;     // 0 for held
+    MANUAL_PUSH ACTION;
+};
+
+const GESTURE GESTURE_TABLE[] = {
+    {GESTURE_BUTTON_UP, 0, MANUAL_PUSH::LONG_PRESS_UP},
+    {GESTURE_BUTTON_DOWN, 0, MANUAL_PUSH::LONG_PRESS_DOWN},
+    {GESTURE_BUTTON_BOTH, 0, MANUAL_PUSH::LONG_PRESS_BOTH},
+    {GESTURE_BUTTON_UP, 1, MANUAL_PUSH::SINGLE_TAP_UP},
+    {GESTURE_BUTTON_DOWN, 1, MANUAL_PUSH::SINGLE_TAP_DOWN},
+    {GESTURE_BUTTON_UP, 2, MANUAL_PUSH::DOUBLE_TAP_UP},
+    {GESTURE_BUTTON_DOWN, 2, MANUAL_PUSH::DOUBLE_TAP_DOWN},
+    {GESTURE_BUTTON_BOTH, 2, MANUAL_PUSH::DOUBLE_TAP_BOTH},
 };
 
 enum class DEVICE_STATUS {
     FAULT,
     OPERATION_MODE,
+    OFFLINE_MODE,
     RESET_MODE,
     MAINTENANCE_MODE,
 };
 
+enum class INDICATOR_EFFECT {
+    SOLID,
+    BREATHE,
+    BLINK_CODE,
+    PROGRESS,
+};
+
 enum class DRIVER_STATUS {
     AVAILABLE,
     BUSY,
     IN_ACTIVE,
 };
 
+enum class CONTROLLER_EVENT_TYPE {
+    ALEXA_REQUEST,       // REQUEST from Alexa
+    MANUAL_ACTION,       // button gesture changed to MANUAL_ACTION
+    WEBPAGE_SUBMISSION,  // device credentials submitted on the webpage
+    PERCENT_MARK,        // VALUE: percentage the resting blind is marked as
+    CONNECTIVITY,        // VALUE: 1 if WiFi got connected, 0 if lost
+    MOTOR_STATE,         // VALUE: 1 if the motor started, 0 if stopped
+    MOTION_FEEDBACK,     // result of a motion request available
+};
+
 struct MOTION_REQUEST {
-    int PERCENTAGE;  // 0, 100 for blind traversal
+    int PERCENTAGE = 0;      // 0, 100 for blind traversal
+    int RELATIVE_STEPS = 0;  // moves by steps instead of to PERCENTAGE if non-zero
+    bool CREEP = false;      // moves at creep velocity, e.g. for approaching an end stop
+    bool JOG = false;        // decelerates to standstill on MotorDriver::StopJog(), e.g. on button release
+};
+
+struct CONTROLLER_EVENT {
+    CONTROLLER_EVENT_TYPE TYPE = CONTROLLER_EVENT_TYPE::MOTION_FEEDBACK;
+    MOTION_REQUEST REQUEST;
+    MANUAL_PUSH MANUAL_ACTION = MANUAL_PUSH::NO_PUSH;
+    int VALUE = 0;
+    int64_t POST_TIME_US = 0;  // MonotonicClock, set by EventQueue::Post()
+};
+
+enum class MOTION_RESULT {
+    COMPLETED,
+    SUPERSEDED,
+    CANCELLED,
+    STALLED,
+    TIMED_OUT,
+};
+
+struct MOTION_FEEDBACK {
+    uint32_t ID = 0;
+    MOTION_RESULT RESULT = MOTION_RESULT::COMPLETED;
+    int PERCENTAGE = 0;
+    int TOTAL_STEP_COUNT = 0;  // non-zero if the move re-measured the travel on an end stop
+};
+
+struct MOTOR_STATE {
+    int STEP = 0;
+    int TOTAL_STEP_COUNT = 0;
+    int PERCENTAGE = 0;
+    bool DIRECTION = false;
+    bool RUNNING = false;
+    uint32_t LAST_PULSE_TIME_US = 0;
+};
+
+enum class CALIBRATION_STATE {
+    IDLE,
+    SEEK,      // fast traversal into the end stop
+    BACK_OFF,  // moves away from the end stop
+    APPROACH,  // creeps into the end stop for the precise end
+    FAILED,
+};
+
+enum class CALIBRATION_RESULT {
+    PENDING,  // waits for the feedback of a move
+    SUCCEEDED,
+    FAILED,
 };
 
 struct DEVICE_CRED {
@@ -170,11 +415,23 @@ struct DEVICE_CRED {
 struct CALIB_PARAMS {
     int TOTAL_STEP_COUNT = INT_MAX;
     bool DIRECTION = false;
+    int SG_THRESHOLD = MOTOR_DRIVER_SG_THRESH;
+    int SG_MARGIN = 0;                              // SG_RESULT headroom between free running load and stall threshold
+    uint16_t PERCENT_MAP[PERCENT_MAP_KNOTS] = {0};  // step fraction (0-65535) per knot, all zero is linear
+    uint32_t PERCENT_MARKS = 0;                     // bit mask of knots set by user marks
+};
+
+struct STALLGUARD_TUNING {
+    bool VALID = false;
+    int SAMPLE_COUNT = 0;
+    int REFERENCE = 0;  // low percentile of SG_RESULT while free running
+    int THRESHOLD = MOTOR_DRIVER_SG_THRESH;
+    int MARGIN = 0;
 };
 
-// alias for time variables
-using time_var = std::chrono::time_point<std::chrono::system_clock>;
-using current_time = std::chrono::system_clock;
+// alias for time variables, monotonic since boot
+using current_time = MonotonicClock;
+using time_var = current_time::time_point;
 
 }  // namespace CONFIG_SET
 
@@ -16,26 +16,39 @@
 #include <AsyncTCP.h>
 #include <ESPAsyncWebServer.h>
 
+#include <algorithm>
+#include <cstring>
 #include <mutex>
+#include <string>
 #include <tuple>
+#include <vector>
 
 #include "../config/config.h"
+#include "../event_queue/event_queue.h"
+#include "../latency/latency.h"
 #include "../logging/logging.h"
+#include "../monotonic_clock/monotonic_clock.h"
+#include "../percent_map/percent_map.h"
+#include "../telemetry/telemetry.h"
 #include "WiFi.h"
 #include "webpage.h"
 
-Connectivity::Connectivity(std::shared_ptr<Logging>& logging, CONFIG_SET::DEVICE_CRED* device_cred) : logger_(logging) {
+Connectivity::Connectivity(std::shared_ptr<Logging>& logging, CONFIG_SET::DEVICE_CRED* device_cred,
+                           std::shared_ptr<EventQueue> event_queue)
+    : logger_(logging), event_queue_(event_queue) {
     using namespace CONFIG_SET;
     time_last_connected_ = current_time::now();
 }
 
 Connectivity::~Connectivity() {
     StopEnsuringConnectivity();
+    StopTelemetryServer();
     StopOTA();
     StopWiFi();
     StopWebpage();
+    StopWebServer();
     StopHotspot();
-    logger_->Log(CONFIG_SET::LOG_TYPE::INFO, CONFIG_SET::LOG_CLASS::CONNECTIVITY, "Done Destroying");
+    logger_->Log(CONFIG_SET::LOG_TYPE::INFO, CONFIG_SET::LOG_CLASS::CONNECTIVITY, LOG_FORMAT("Done Destroying"));
 }
 
 void Connectivity::StartEnsureConnectivity(const CONFIG_SET::DEVICE_CRED device_cred) {
@@ -43,35 +56,92 @@ void Connectivity::StartEnsureConnectivity(const CONFIG_SET::DEVICE_CRED device_
         return;
     }
     device_cred_ = device_cred;
+    keep_handler_running_ = true;
     ensure_conn_thread_.reset(new std::thread(&Connectivity::EnsureConnectivity, this));
 }
 
 void Connectivity::StopEnsuringConnectivity() {
+    if (ensure_conn_thread_ == nullptr) {
+        return;
+    }
+    keep_handler_running_ = false;
+    if (handler_task_ != NULL) {
+        xTaskNotifyGive(handler_task_);
+    }
+    // waits are cut short, so this only takes until the handler wakes up
+    ensure_conn_thread_->join();
+    ensure_conn_thread_.reset();
+}
+
+bool Connectivity::WaitForStop(unsigned long timeout_ms) {
     if (keep_handler_running_) {
-        keep_handler_running_ = false;
-        ensure_conn_thread_->detach();
+        int64_t due_us = MonotonicClock::NowUs() + int64_t(timeout_ms) * 1000;
+        if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(timeout_ms)) == 0) {
+            // woken by the deadline, not by a stop
+            Latency::AddLateness(CONFIG_SET::LATENCY_PROBE::CONNECTIVITY_LATENESS, due_us);
+        }
     }
+    return !keep_handler_running_;
 }
 
 void Connectivity::EnsureConnectivity() {
     using namespace CONFIG_SET;
-    logger_->Log(LOG_TYPE::INFO, LOG_CLASS::CONNECTIVITY, "Starting handler");
-    keep_handler_running_ = true;
+    logger_->Log(LOG_TYPE::INFO, LOG_CLASS::CONNECTIVITY, LOG_FORMAT("Starting handler"));
+    handler_task_ = xTaskGetCurrentTaskHandle();
 
+    bool was_connected = false;
+    unsigned long backoff_ms = WIFI_RECONNECT_MIN_BACKOFF_MS;
     while (keep_handler_running_) {
         if (!IsConnected()) {
-            logger_->Log(LOG_TYPE::INFO, LOG_CLASS::CONNECTIVITY, "Lost Connectivity, Trying to Connect WiFi");
-            WiFi.disconnect(true);
-            WiFi.mode(WIFI_STA);
-            WiFi.begin(device_cred_.SSID.c_str(), device_cred_.PASSWORD.c_str());
-            WiFi.waitForConnectResult();
+            if (was_connected) {
+                // the controller goes offline right away, the reconnects of all
+                // devices which lost the same access point are spread out
+                logger_->Log(LOG_TYPE::INFO, LOG_CLASS::CONNECTIVITY, LOG_FORMAT("Lost Connectivity"));
+                was_connected = false;
+                is_reported_connected_ = false;
+                PostEvent(CONTROLLER_EVENT_TYPE::CONNECTIVITY, false);
+                if (WaitForStop(esp_random() % WIFI_RECONNECT_STAGGER_MS)) {
+                    break;
+                }
+            }
+            logger_->Log(LOG_TYPE::INFO, LOG_CLASS::CONNECTIVITY, LOG_FORMAT("Trying to Connect WiFi"));
+            {
+                LatencyTimer reconnect_timer(LATENCY_PROBE::CONNECTIVITY_RECONNECT);
+                WiFi.disconnect(true);
+                WiFi.mode(WIFI_STA);
+                WiFi.begin(device_cred_.SSID.c_str(), device_cred_.PASSWORD.c_str());
+            }
+            // polled instead of WiFi.waitForConnectResult() so that stopping
+            // the handler does not wait for the connection attempt
+            int64_t connect_start_ms = MonotonicClock::NowMs();
+            while (!IsConnected() && (MonotonicClock::NowMs() - connect_start_ms) < WIFI_CONNECT_TIMEOUT_MS) {
+                if (WaitForStop(WIFI_CONNECT_POLL_INTERVAL_MS)) {
+                    break;
+                }
+            }
+        }
+        bool connected = IsConnected();
+        if (connected && !was_connected) {
+            logger_->Log(LOG_TYPE::INFO, LOG_CLASS::CONNECTIVITY, LOG_FORMAT("Connected after %d s offline"),
+                         GetSecLostConnection());
+            was_connected = true;
+            is_reported_connected_ = true;
+            PostEvent(CONTROLLER_EVENT_TYPE::CONNECTIVITY, true);
         }
-        if (IsConnected()) {
+        if (connected) {
             time_last_connected_ = current_time::now();
+            backoff_ms = WIFI_RECONNECT_MIN_BACKOFF_MS;
+            WaitForStop(TRY_RECONNECT * 1000);
+        } else {
+            // progressive backoff, jittered so that devices drift apart
+            unsigned long wait_ms = backoff_ms / 2 + esp_random() % (backoff_ms / 2 + 1);
+            logger_->Log(LOG_TYPE::INFO, LOG_CLASS::CONNECTIVITY, LOG_FORMAT("Retrying in %u ms"), wait_ms);
+            WaitForStop(wait_ms);
+            backoff_ms = std::min(backoff_ms * 2, WIFI_RECONNECT_MAX_BACKOFF_MS);
         }
-        std::this_thread::sleep_for(std::chrono::seconds(TRY_RECONNECT));
     }
-    logger_->Log(LOG_TYPE::INFO, LOG_CLASS::CONNECTIVITY, "Exiting handler");
+    handler_task_ = NULL;
+    logger_->Log(LOG_TYPE::INFO, LOG_CLASS::CONNECTIVITY, LOG_FORMAT("Exiting handler"));
 }
 
 int Connectivity::GetSecLostConnection() {
@@ -81,7 +151,7 @@ int Connectivity::GetSecLostConnection() {
 
 void Connectivity::StopWiFi() {
     WiFi.disconnect(true);
-    logger_->Log(CONFIG_SET::LOG_TYPE::INFO, CONFIG_SET::LOG_CLASS::CONNECTIVITY, "Stopping WiFi");
+    logger_->Log(CONFIG_SET::LOG_TYPE::INFO, CONFIG_SET::LOG_CLASS::CONNECTIVITY, LOG_FORMAT("Stopping WiFi"));
 }
 
 void Connectivity::StartOTA() {
@@ -92,42 +162,46 @@ void Connectivity::StartOTA() {
     StartHotspot();
 
     ArduinoOTA.onStart([&]() {
-        String type;
+        const char* type;
         if (ArduinoOTA.getCommand() == U_FLASH) {
             type = "sketch";
         } else {
             type = "filesystem";
         }
         logger_->Log(CONFIG_SET::LOG_TYPE::INFO, CONFIG_SET::LOG_CLASS::CONNECTIVITY,
-                     String("Start updating " + type).c_str());
+                     LOG_FORMAT("Start updating %s"), type);
     });
 
-    ArduinoOTA.onEnd([&]() { logger_->Log(CONFIG_SET::LOG_TYPE::INFO, CONFIG_SET::LOG_CLASS::CONNECTIVITY, "End"); });
+    ArduinoOTA.onEnd([&]() {
+        logger_->Log(CONFIG_SET::LOG_TYPE::INFO, CONFIG_SET::LOG_CLASS::CONNECTIVITY, LOG_FORMAT("End"));
+    });
 
     ArduinoOTA.onProgress([&](unsigned int progress, unsigned int total) {
-        logger_->Log(CONFIG_SET::LOG_TYPE::INFO, CONFIG_SET::LOG_CLASS::CONNECTIVITY,
-                     String("Progress: " + (progress / (total / 100))).c_str());
+        logger_->Log(CONFIG_SET::LOG_TYPE::INFO, CONFIG_SET::LOG_CLASS::CONNECTIVITY, LOG_FORMAT("Progress: %u %%"),
+                     total ? uint32_t(uint64_t(progress) * 100 / total) : 0);
     });
 
     ArduinoOTA.onError([&](ota_error_t error) {
-        logger_->Log(CONFIG_SET::LOG_TYPE::INFO, CONFIG_SET::LOG_CLASS::CONNECTIVITY,
-                     String("Error: " + error).c_str());
+        logger_->Log(CONFIG_SET::LOG_TYPE::INFO, CONFIG_SET::LOG_CLASS::CONNECTIVITY, LOG_FORMAT("Error: %d"),
+                     int(error));
         if (error == OTA_AUTH_ERROR) {
-            logger_->Log(CONFIG_SET::LOG_TYPE::ERROR, CONFIG_SET::LOG_CLASS::CONNECTIVITY, "Auth Failed");
+            logger_->Log(CONFIG_SET::LOG_TYPE::ERROR, CONFIG_SET::LOG_CLASS::CONNECTIVITY, LOG_FORMAT("Auth Failed"));
         } else if (error == OTA_BEGIN_ERROR) {
-            logger_->Log(CONFIG_SET::LOG_TYPE::ERROR, CONFIG_SET::LOG_CLASS::CONNECTIVITY, "Begin Failed");
+            logger_->Log(CONFIG_SET::LOG_TYPE::ERROR, CONFIG_SET::LOG_CLASS::CONNECTIVITY, LOG_FORMAT("Begin Failed"));
         } else if (error == OTA_CONNECT_ERROR) {
-            logger_->Log(CONFIG_SET::LOG_TYPE::ERROR, CONFIG_SET::LOG_CLASS::CONNECTIVITY, "Connect Failed");
+            logger_->Log(CONFIG_SET::LOG_TYPE::ERROR, CONFIG_SET::LOG_CLASS::CONNECTIVITY,
+                         LOG_FORMAT("Connect Failed"));
         } else if (error == OTA_RECEIVE_ERROR) {
-            logger_->Log(CONFIG_SET::LOG_TYPE::ERROR, CONFIG_SET::LOG_CLASS::CONNECTIVITY, "Receive Failed");
+            logger_->Log(CONFIG_SET::LOG_TYPE::ERROR, CONFIG_SET::LOG_CLASS::CONNECTIVITY,
+                         LOG_FORMAT("Receive Failed"));
         } else if (error == OTA_END_ERROR) {
-            logger_->Log(CONFIG_SET::LOG_TYPE::ERROR, CONFIG_SET::LOG_CLASS::CONNECTIVITY, "End Failed");
+            logger_->Log(CONFIG_SET::LOG_TYPE::ERROR, CONFIG_SET::LOG_CLASS::CONNECTIVITY, LOG_FORMAT("End Failed"));
         }
     });
 
     ArduinoOTA.begin();
     ota_enabled_ = true;
-    logger_->Log(CONFIG_SET::LOG_TYPE::INFO, CONFIG_SET::LOG_CLASS::CONNECTIVITY, "Starting OTA");
+    logger_->Log(CONFIG_SET::LOG_TYPE::INFO, CONFIG_SET::LOG_CLASS::CONNECTIVITY, LOG_FORMAT("Starting OTA"));
 }
 
 void Connectivity::HandleOTA() {
@@ -142,13 +216,17 @@ void Connectivity::StopOTA() {
     }
     StopHotspot();
     ota_enabled_ = false;
-    logger_->Log(CONFIG_SET::LOG_TYPE::INFO, CONFIG_SET::LOG_CLASS::CONNECTIVITY, "Stopping OTA");
+    logger_->Log(CONFIG_SET::LOG_TYPE::INFO, CONFIG_SET::LOG_CLASS::CONNECTIVITY, LOG_FORMAT("Stopping OTA"));
 }
 
 bool Connectivity::IsConnected() {
     return WiFi.status() == WL_CONNECTED;
 }
 
+bool Connectivity::IsReportedConnected() {
+    return is_reported_connected_;
+}
+
 void Connectivity::StartHotspot() {
     CONFIG_SET::DEVICE_CRED device_cred;
     IPAddress local_IP(192, 168, 0, 10);
@@ -158,14 +236,14 @@ void Connectivity::StartHotspot() {
     WiFi.softAPConfig(local_IP, gateway, subnet);
     WiFi.softAP(device_cred.SSID.c_str(), device_cred.PASSWORD.c_str());
     hotspot_enabled_ = true;
-    logger_->Log(CONFIG_SET::LOG_TYPE::INFO, CONFIG_SET::LOG_CLASS::CONNECTIVITY, "Starting Hotspot");
+    logger_->Log(CONFIG_SET::LOG_TYPE::INFO, CONFIG_SET::LOG_CLASS::CONNECTIVITY, LOG_FORMAT("Starting Hotspot"));
 }
 
 void Connectivity::StopHotspot() {
     if (hotspot_enabled_) {
         WiFi.softAPdisconnect(true);
     }
-    logger_->Log(CONFIG_SET::LOG_TYPE::INFO, CONFIG_SET::LOG_CLASS::CONNECTIVITY, "Stopping Hotspot");
+    logger_->Log(CONFIG_SET::LOG_TYPE::INFO, CONFIG_SET::LOG_CLASS::CONNECTIVITY, LOG_FORMAT("Stopping Hotspot"));
     hotspot_enabled_ = false;
 }
 
@@ -176,13 +254,48 @@ void Connectivity::StartWebpage() {
         return;
     }
 
-    webpage_server_.reset(new AsyncWebServer(80));
-    webpage_server_->on("/", HTTP_GET,
-                        [](AsyncWebServerRequest* request) { request->send_P(200, "text/html", index_html); });
+    StartWebServer();
+    Serial.println(WiFi.softAPIP());
+    webpage_enabled_ = true;
+    logger_->Log(CONFIG_SET::LOG_TYPE::INFO, CONFIG_SET::LOG_CLASS::CONNECTIVITY, LOG_FORMAT("Starting Webpage"));
+}
+
+void Connectivity::StopWebpage() {
+    StopHotspot();
+    logger_->Log(CONFIG_SET::LOG_TYPE::INFO, CONFIG_SET::LOG_CLASS::CONNECTIVITY, LOG_FORMAT("Stopping Webpage"));
+    webpage_enabled_ = false;
+}
+
+void Connectivity::ServeAlexa(ALEXA_HANDLER handler) {
+    {
+        const std::lock_guard<std::mutex> lock(alexa_handler_mutex_);
+        alexa_handler_ = handler;
+    }
+    StartWebServer();
+    logger_->Log(CONFIG_SET::LOG_TYPE::INFO, CONFIG_SET::LOG_CLASS::CONNECTIVITY, LOG_FORMAT("Serving Alexa"));
+}
+
+void Connectivity::StartWebServer() {
+    if (web_server_) {
+        return;
+    }
+
+    web_server_.reset(new AsyncWebServer(80));
+    web_server_->on("/", HTTP_GET, [&](AsyncWebServerRequest* request) {
+        if (!webpage_enabled_) {
+            request->send(404);
+            return;
+        }
+        request->send_P(200, "text/html", index_html);
+    });
 
     // Send a GET request to
     // <ESP_IP>/update?output=<inputMessage1>&state=<inputMessage2>
-    webpage_server_->on("/submit", HTTP_GET, [&](AsyncWebServerRequest* request) {
+    web_server_->on("/submit", HTTP_GET, [&](AsyncWebServerRequest* request) {
+        if (!webpage_enabled_) {
+            request->send(404);
+            return;
+        }
         if (request->hasArg("device_name")) {
             String arg = request->arg("device_name");
             webpage_submitted_device_cred_.DEVICE_ID = String(arg.c_str());
@@ -197,26 +310,107 @@ void Connectivity::StartWebpage() {
         }
         request->send_P(200, "text/html", dialog_html);
 
-        logger_->Log(CONFIG_SET::LOG_TYPE::INFO, CONFIG_SET::LOG_CLASS::CONNECTIVITY, "Got webpage submission");
-        const std::lock_guard<std::mutex> lock(webpage_submission_mutex_);
-        is_new_submission_available_ = true;
+        logger_->Log(CONFIG_SET::LOG_TYPE::INFO, CONFIG_SET::LOG_CLASS::CONNECTIVITY,
+                     LOG_FORMAT("Got webpage submission"));
+        {
+            const std::lock_guard<std::mutex> lock(webpage_submission_mutex_);
+            is_new_submission_available_ = true;
+        }
+        PostEvent(CONFIG_SET::CONTROLLER_EVENT_TYPE::WEBPAGE_SUBMISSION);
+    });
+
+    // Alexa sends the state changes as PUT with a short JSON body, which
+    // arrives in one chunk, the other requests of Alexa end up as not found
+    web_server_->onRequestBody(
+        [&](AsyncWebServerRequest* request, uint8_t* data, size_t length, size_t index, size_t total) {
+            if (index == 0 && length == total) {
+                ProcessAlexa(request, String(std::string(reinterpret_cast<const char*>(data), length).c_str()));
+            }
+        });
+    web_server_->onNotFound([&](AsyncWebServerRequest* request) {
+        if (!ProcessAlexa(request, String())) {
+            request->send(404);
+        }
     });
 
     // Start server
-    webpage_server_->begin();
-    Serial.println(WiFi.softAPIP());
-    webpage_enabled_ = true;
-    logger_->Log(CONFIG_SET::LOG_TYPE::INFO, CONFIG_SET::LOG_CLASS::CONNECTIVITY, "Starting Webpage");
+    web_server_->begin();
 }
 
-void Connectivity::StopWebpage() {
-    StopHotspot();
-    if (webpage_enabled_) {
-        webpage_server_->end();
-        webpage_server_.reset();
+void Connectivity::StopWebServer() {
+    if (!web_server_) {
+        return;
     }
-    logger_->Log(CONFIG_SET::LOG_TYPE::INFO, CONFIG_SET::LOG_CLASS::CONNECTIVITY, "Stopping Webpage");
-    webpage_enabled_ = false;
+    web_server_->end();
+    web_server_.reset();
+}
+
+bool Connectivity::ProcessAlexa(AsyncWebServerRequest* request, const String& body) {
+    const std::lock_guard<std::mutex> lock(alexa_handler_mutex_);
+    return alexa_handler_ && alexa_handler_(request, body);
+}
+
+void Connectivity::StartTelemetryServer(std::shared_ptr<TelemetryRecorder> telemetry) {
+    if (telemetry_server_) {
+        return;
+    }
+    telemetry_server_.reset(new AsyncWebServer(CONFIG_SET::TELEMETRY_SERVER_PORT));
+    telemetry_server_->on("/telemetry", HTTP_GET, [telemetry](AsyncWebServerRequest* request) {
+        // the copy is taken at once, recording continues while it is sent
+        std::shared_ptr<std::vector<uint8_t>> blob(new std::vector<uint8_t>());
+        telemetry->Export(*blob);
+        AsyncWebServerResponse* response = request->beginResponse(
+            "application/octet-stream", blob->size(), [blob](uint8_t* buffer, size_t max_len, size_t index) -> size_t {
+                size_t length = std::min(max_len, blob->size() - index);
+                std::memcpy(buffer, blob->data() + index, length);
+                return length;
+            });
+        response->addHeader("Content-Disposition", "attachment; filename=telemetry.bin");
+        request->send(response);
+    });
+    telemetry_server_->on("/latency", HTTP_GET, [](AsyncWebServerRequest* request) {
+        std::string report;
+        for (int probe = 0; probe < int(CONFIG_SET::LATENCY_PROBE::COUNT); probe++) {
+            report += Latency::Format(CONFIG_SET::LATENCY_PROBE(probe)) + "\n";
+        }
+        if (request->hasArg("clear") && request->arg("clear").toInt() == 1) {
+            // the report holds the samples dropped here
+            Latency::Clear();
+        }
+        request->send(200, "text/plain", report.c_str());
+    });
+    telemetry_server_->on("/mark", HTTP_GET, [&](AsyncWebServerRequest* request) {
+        const int knot_count = CONFIG_SET::PERCENT_MAP_KNOTS;
+        int percent = request->hasArg("percent") ? request->arg("percent").toInt() : -1;
+        int knot = PercentMap::KnotFromPercent(percent, knot_count);
+        if (knot == 0 || knot == knot_count - 1) {
+            request->send(400, "text/plain", "0 and 100 are set by the end stops, they cannot be marked");
+            return;
+        }
+        if (knot < 0) {
+            // a step measured between knots cannot be assigned to one
+            request->send(400, "text/plain",
+                          "percent must be a multiple of " + String(100 / (knot_count - 1)) + " within 0-100");
+            return;
+        }
+        request->send(200, "text/plain", "OK");
+
+        logger_->Log(CONFIG_SET::LOG_TYPE::INFO, CONFIG_SET::LOG_CLASS::CONNECTIVITY, LOG_FORMAT("Got percent mark"));
+        PostEvent(CONFIG_SET::CONTROLLER_EVENT_TYPE::PERCENT_MARK, percent);
+    });
+    telemetry_server_->begin();
+    logger_->Log(CONFIG_SET::LOG_TYPE::INFO, CONFIG_SET::LOG_CLASS::CONNECTIVITY,
+                 LOG_FORMAT("Starting Telemetry Server"));
+}
+
+void Connectivity::StopTelemetryServer() {
+    if (!telemetry_server_) {
+        return;
+    }
+    telemetry_server_->end();
+    telemetry_server_.reset();
+    logger_->Log(CONFIG_SET::LOG_TYPE::INFO, CONFIG_SET::LOG_CLASS::CONNECTIVITY,
+                 LOG_FORMAT("Stopping Telemetry Server"));
 }
 
 std::tuple<bool, CONFIG_SET::DEVICE_CRED> Connectivity::GetWebpageSubmission() {
@@ -225,4 +419,14 @@ std::tuple<bool, CONFIG_SET::DEVICE_CRED> Connectivity::GetWebpageSubmission() {
                                                            webpage_submitted_device_cred_);
     is_new_submission_available_ = false;
     return return_value;
-}
\ No newline at end of file
+}
+
+void Connectivity::PostEvent(CONFIG_SET::CONTROLLER_EVENT_TYPE type, int value) {
+    if (!event_queue_) {
+        return;
+    }
+    CONFIG_SET::CONTROLLER_EVENT event;
+    event.TYPE = type;
+    event.VALUE = value;
+    event_queue_->Post(event);
+}
@@ -17,23 +17,37 @@
 #include <AsyncTCP.h>
 #include <ESPAsyncWebServer.h>
 
+#include <atomic>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <thread>
 #include <tuple>
 
 #include "../config/config.h"
+#include "../event_queue/event_queue.h"
 #include "../logging/logging.h"
+#include "../telemetry/telemetry.h"
 #include "WiFi.h"
 #include "webpage.h"
 
 class Connectivity {
    public:
+    /**
+   * @brief Answers a request on port 80 if it is one of Alexa, see
+   * AlexaInteraction::Process()
+   *
+   */
+    typedef std::function<bool(AsyncWebServerRequest* request, const String& body)> ALEXA_HANDLER;
+
     /**
    * @brief Fetches the LED pin from config, setups pin mode, setup WS2812
-   * RGBLED, initializes logger
+   * RGBLED, initializes logger, webpage submissions, percent marks and WiFi
+   * connection changes are posted to the event queue if given
    *
    */
-    Connectivity(std::shared_ptr<Logging>& logging, CONFIG_SET::DEVICE_CRED* device_cred);
+    Connectivity(std::shared_ptr<Logging>& logging, CONFIG_SET::DEVICE_CRED* device_cred,
+                 std::shared_ptr<EventQueue> event_queue = nullptr);
 
     /**
    * @brief Destroy the Connectivity object
@@ -80,17 +94,50 @@ class Connectivity {
     bool IsConnected();
 
     /**
-   * @brief Creates a server and starts hosting webpage
+   * @brief Returns the connectivity the handler posted last, unlike
+   * IsConnected() it does not run ahead of the CONNECTIVITY events
+   *
+   */
+    bool IsReportedConnected();
+
+    /**
+   * @brief Starts the hotspot and hosts the webpage on the web server of port
+   * 80
    *
    */
     void StartWebpage();
 
     /**
-   * @brief Stops webpage server
+   * @brief Stops the hotspot and hosting the webpage
    *
    */
     void StopWebpage();
 
+    /**
+   * @brief Hands the requests on port 80 which are not for the webpage to
+   * Alexa, fauxmo runs without its own server so that the port is shared
+   * with the webpage
+   *
+   * @param handler: called on the async TCP task, its target has to outlive
+   * this object
+   */
+    void ServeAlexa(ALEXA_HANDLER handler);
+
+    /**
+   * @brief Starts a server on CONFIG_SET::TELEMETRY_SERVER_PORT serving the
+   * recorded move telemetry as binary blob on /telemetry, the latency
+   * histograms as text on /latency, and taking percent map marks (the current
+   * position is at the given percentage) on /mark?percent=<inner knot>
+   *
+   */
+    void StartTelemetryServer(std::shared_ptr<TelemetryRecorder> telemetry);
+
+    /**
+   * @brief Stops telemetry server
+   *
+   */
+    void StopTelemetryServer();
+
     /**
    * @brief disconnects WiFi
    *
@@ -107,18 +154,51 @@ class Connectivity {
 
    private:
     std::shared_ptr<Logging> logger_;
-    std::unique_ptr<AsyncWebServer> webpage_server_{nullptr};
+    std::unique_ptr<AsyncWebServer> web_server_{nullptr};  // port 80, webpage and Alexa
+    std::unique_ptr<AsyncWebServer> telemetry_server_{nullptr};
 
     // boolean vars to store the status of functionalities
     bool ota_enabled_ = false;
-    bool webpage_enabled_ = false;
+    std::atomic<bool> webpage_enabled_{false};
     bool hotspot_enabled_ = false;
-    bool keep_handler_running_ = false;
+    std::atomic<bool> keep_handler_running_{false};
+    std::atomic<bool> is_reported_connected_{false};
+    TaskHandle_t handler_task_ = NULL;
     bool is_new_submission_available_ = false;
     CONFIG_SET::time_var time_last_connected_;
     CONFIG_SET::DEVICE_CRED webpage_submitted_device_cred_, device_cred_;
     std::unique_ptr<std::thread> ensure_conn_thread_{nullptr};
     std::mutex webpage_submission_mutex_;
+    ALEXA_HANDLER alexa_handler_;
+    std::mutex alexa_handler_mutex_;
+    std::shared_ptr<EventQueue> event_queue_{nullptr};
+
+    /**
+   * @brief Posts an event to the event queue, if there is one
+   *
+   */
+    void PostEvent(CONFIG_SET::CONTROLLER_EVENT_TYPE type, int value = 0);
+
+    /**
+   * @brief Starts the web server on port 80, if not running, requests are
+   * routed to the webpage while it is enabled and to Alexa otherwise
+   *
+   */
+    void StartWebServer();
+
+    /**
+   * @brief Stops the web server on port 80
+   *
+   */
+    void StopWebServer();
+
+    /**
+   * @brief Answers a request of Alexa, if Alexa is served
+   *
+   * @return true : if answered
+   * @return false : otherwise
+   */
+    bool ProcessAlexa(AsyncWebServerRequest* request, const String& body);
 
     /**
    * @brief Starts wifi hotspot, basically start wifi in soft access point mode
@@ -142,13 +222,19 @@ class Connectivity {
     void EnsureConnectivity();
 
     /**
-   * @brief Check if the device is connected, if not, try to connect it
+   * @brief Stops the connectivity handler and waits for it to exit
    *
-   * @return true : wifi is connected
-   * @return false : failed to connect, device is no longer connected, despite
-   * of trying
    */
     void StopEnsuringConnectivity();
+
+    /**
+   * @brief Sleeps in the connectivity handler, woken up early when it is
+   * stopped
+   *
+   * @return true : if the handler has to stop
+   * @return false : otherwise
+   */
+    bool WaitForStop(unsigned long timeout_ms);
 };
 
 #endif
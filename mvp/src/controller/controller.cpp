@@ -15,193 +15,415 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include <algorithm>
 #include <chrono>
 #include <memory>
+#include <tuple>
 
 #include "../alexa_interaction/alexa_interaction.h"
 #include "../config/config.h"
 #include "../connectivity/connectivity.h"
+#include "../event_queue/event_queue.h"
 #include "../indicator/indicator.h"
+#include "../latency/latency.h"
 #include "../logging/logging.h"
 #include "../manual_interaction/manual_interaction.h"
+#include "../monotonic_clock/monotonic_clock.h"
 #include "../motor_driver/motor_driver.h"
+#include "../percent_map/percent_map.h"
+#include "../power_manager/power_manager.h"
 #include "../storage/storage.h"
+#include "../telemetry/telemetry.h"
 
 Controller::Controller()
-    : logger_(new Logging(true)),
+    : last_blind_percentage_(0),
+      long_press_enabled_(false),
+      logger_(new Logging(true)),
+      event_queue_(new EventQueue(CONFIG_SET::CONTROLLER_EVENT_QUEUE_SIZE)),
       store_(new Storage(logger_)),
       indicator_(new Indicator(logger_)),
-      manual_interaction_(new ManualInteraction(CONFIG_SET::DEQUE_ANALYZER_FREQ, logger_)),
+      telemetry_(new TelemetryRecorder()),
       connectivity_{nullptr},
-      motor_driver_{nullptr},
       alexa_interaction_{nullptr},
-      long_press_enabled_(false),
-      last_blind_percentage_(0),
-      last_motor_status_(CONFIG_SET::DRIVER_STATUS::AVAILABLE) {
+      motor_driver_{nullptr},
+      manual_interaction_(new ManualInteraction(logger_, event_queue_)) {
     using namespace CONFIG_SET;
+    Latency::SetCpuFrequencyMhz(getCpuFrequencyMhz());
+    last_latency_report_ms_ = MonotonicClock::NowMs();
     calib_params_ = CALIB_PARAMS();
     device_cred_ = DEVICE_CRED();
     store_->PopulateOperationMode(&operation_mode_);
+    EnterMode();
+    logger_->Log(LOG_TYPE::INFO, LOG_CLASS::CONTROLLER, LOG_FORMAT("Initialization Finished"));
+}
+
+Controller::~Controller() {
+    // its web server calls into Alexa interaction, which is destroyed first
+    connectivity_.reset();
+}
+
+void Controller::Handle() {
+    using namespace CONFIG_SET;
+    indicator_->UpdateStatus(indicator_status_);
+    CONTROLLER_EVENT event;
+    unsigned long wait_time_ms = GetWaitTime();
+    int64_t wait_start_us = MonotonicClock::NowUs();
+    bool is_event_available = event_queue_->Wait(event, wait_time_ms);
+    Latency::AddLateness(LATENCY_PROBE::CONTROLLER_LATENESS,
+                         is_event_available ? event.POST_TIME_US : wait_start_us + int64_t(wait_time_ms) * 1000);
+    LatencyTimer handle_timer(LATENCY_PROBE::CONTROLLER_HANDLE);
+    const CONTROLLER_EVENT* current_event = is_event_available ? &event : nullptr;
     switch (operation_mode_) {
         case OPERATION_MODE::RESET:
-            indicator_status_ = DEVICE_STATUS::RESET_MODE;
-            InitializeResetMode();
+            HandleResetMode(current_event);
             break;
         case OPERATION_MODE::MAINTENANCE:
-            indicator_status_ = DEVICE_STATUS::MAINTENANCE_MODE;
-            InitializeMaintenanceMode();
+            HandleMaintenanceMode(current_event);
             break;
         case OPERATION_MODE::USER:
-            indicator_status_ = DEVICE_STATUS::OPERATION_MODE;
-            InitializeOperationMode();
+            HandleOperationMode(current_event);
             break;
         default:
             break;
     }
-    logger_->Log(LOG_TYPE::INFO, LOG_CLASS::CONTROLLER, "Initialization Finished");
+    handle_timer.Stop();
+    ReportDroppedEvents();
+    ReportLatency();
 }
 
-Controller::~Controller() {}
+void Controller::ReportDroppedEvents() {
+    using namespace CONFIG_SET;
+    uint32_t dropped_event_count = event_queue_->GetDroppedCount();
+    if (dropped_event_count != dropped_event_count_) {
+        logger_->Log(LOG_TYPE::WARN, LOG_CLASS::CONTROLLER, LOG_FORMAT("Event queue full, dropped %u events"),
+                     dropped_event_count - dropped_event_count_);
+        dropped_event_count_ = dropped_event_count;
+    }
+}
 
-void Controller::Handle() {
+void Controller::ReportLatency() {
+    using namespace CONFIG_SET;
+    int64_t now_ms = MonotonicClock::NowMs();
+    if (LATENCY_REPORT_INTERVAL_MS <= 0 || now_ms - last_latency_report_ms_ < LATENCY_REPORT_INTERVAL_MS) {
+        return;
+    }
+    last_latency_report_ms_ = now_ms;
+    for (int probe = 0; probe < int(LATENCY_PROBE::COUNT); probe++) {
+        if (Latency::GetHistogram(LATENCY_PROBE(probe)).GetCount() > 0) {
+            const LatencyHistogram& histogram = Latency::GetHistogram(LATENCY_PROBE(probe));
+            logger_->Log(LOG_TYPE::INFO, LOG_CLASS::LATENCY, LOG_FORMAT("%s n=%u p50<%u p90<%u p99<%u max=%u us"),
+                         Latency::GetName(LATENCY_PROBE(probe)), histogram.GetCount(),
+                         histogram.GetQuantileBound(0.50f), histogram.GetQuantileBound(0.90f),
+                         histogram.GetQuantileBound(0.99f), histogram.GetMax());
+        }
+    }
+}
+
+void Controller::SwitchMode(CONFIG_SET::OPERATION_MODE mode) {
     using namespace CONFIG_SET;
-    indicator_->UpdateStatus(indicator_status_);
     switch (operation_mode_) {
         case OPERATION_MODE::RESET:
-            HandleResetMode();
+            StopResetMode();
             break;
         case OPERATION_MODE::MAINTENANCE:
-            HandleMaintenanceMode();
+            StopMaintenanceMode();
+            break;
+        case OPERATION_MODE::USER:
+            StopOperationMode(mode);
+            break;
+        default:
+            break;
+    }
+    operation_mode_ = mode;
+    EnterMode();
+}
+
+void Controller::EnterMode() {
+    using namespace CONFIG_SET;
+    switch (operation_mode_) {
+        case OPERATION_MODE::RESET:
+            indicator_status_ = DEVICE_STATUS::RESET_MODE;
+            InitializeResetMode();
+            break;
+        case OPERATION_MODE::MAINTENANCE:
+            indicator_status_ = DEVICE_STATUS::MAINTENANCE_MODE;
+            InitializeMaintenanceMode();
             break;
         case OPERATION_MODE::USER:
-            HandleOperationMode();
+            indicator_status_ = DEVICE_STATUS::OPERATION_MODE;
+            InitializeOperationMode();
             break;
         default:
             break;
     }
 }
 
+unsigned long Controller::GetWaitTime() {
+    using namespace CONFIG_SET;
+    switch (operation_mode_) {
+        case OPERATION_MODE::RESET: {
+            if (calibration_.STATE != CALIBRATION_STATE::IDLE) {
+                // a dropped feedback event must not stall the calibration
+                return CONTROLLER_POLL_INTERVAL_MS;
+            }
+            // nothing to poll, only the mode expiry
+            long exec_time_ms =
+                std::chrono::duration_cast<std::chrono::milliseconds>(current_time::now() - mode_start_time_).count();
+            long remaining_ms = long(MODE_EXPIRE_TIME_LIMIT) * 1000 - exec_time_ms;
+            return remaining_ms > 0 ? (unsigned long)(remaining_ms) + 1000 : 0;
+        }
+        case OPERATION_MODE::USER:
+            // fauxmo has to be polled for its UDP discovery
+            if (power_manager_ && power_manager_->IsIdle()) {
+                return POWER_IDLE_POLL_INTERVAL_MS;
+            }
+            return CONTROLLER_POLL_INTERVAL_MS;
+        default:
+            // OTA has to be polled for its UDP invitation
+            return CONTROLLER_POLL_INTERVAL_MS;
+    }
+}
+
 void Controller::InitializeResetMode() {
     using namespace CONFIG_SET;
-    logger_->Log(LOG_TYPE::INFO, LOG_CLASS::CONTROLLER, "Starting Reset Mode");
+    logger_->Log(LOG_TYPE::INFO, LOG_CLASS::CONTROLLER, LOG_FORMAT("Starting Reset Mode"));
     OPERATION_MODE op = OPERATION_MODE::USER;
     store_->SaveOperationMode(&op);
-    connectivity_.reset(new Connectivity(logger_, &device_cred_));
+    connectivity_.reset(new Connectivity(logger_, &device_cred_, event_queue_));
     connectivity_->StartWebpage();
     mode_start_time_ = current_time::now();
 }
 
-void Controller::HandleResetMode() {
+void Controller::HandleResetMode(const CONFIG_SET::CONTROLLER_EVENT* event) {
     using namespace CONFIG_SET;
     constexpr LOG_CLASS CONTROLLER = LOG_CLASS::CONTROLLER;
     constexpr LOG_TYPE INFO = LOG_TYPE::INFO;
-    auto webpage_submission = connectivity_->GetWebpageSubmission();
-    if (std::get<0>(webpage_submission)) {
-        device_cred_ = std::get<1>(webpage_submission);
-        logger_->Log(INFO, CONTROLLER, "Got the webpage submission");
-        connectivity_->StopWebpage();
-        connectivity_->StopWiFi();
-        Calibrate();
-        operation_mode_ = OPERATION_MODE::USER;
-        store_->Clear();
-        SaveParameters();
-        RestartDevice();
-    }
-    MANUAL_PUSH manual_action_test;
-    time_var manual_action_time_test;
-    std::tie(manual_action_test, manual_action_time_test) = manual_interaction_->GetManualActionAndTime();
-    if (manual_action_test == MANUAL_PUSH::DOUBLE_TAP_BOTH) {
-        operation_mode_ = OPERATION_MODE::MAINTENANCE;
-        indicator_status_ = DEVICE_STATUS::MAINTENANCE_MODE;
-        StopResetMode();
-        InitializeMaintenanceMode();
+    bool is_calibration_event = false;
+    if (event && event->TYPE == CONTROLLER_EVENT_TYPE::WEBPAGE_SUBMISSION) {
+        auto webpage_submission = connectivity_->GetWebpageSubmission();
+        if (std::get<0>(webpage_submission)) {
+            device_cred_ = std::get<1>(webpage_submission);
+            logger_->Log(INFO, CONTROLLER, LOG_FORMAT("Got the webpage submission"));
+            connectivity_->StopWebpage();
+            connectivity_->StopWiFi();
+            StartCalibration();
+            // a failed start has no feedback to wait for
+            is_calibration_event = true;
+        }
+    } else if (!event || event->TYPE == CONTROLLER_EVENT_TYPE::MOTION_FEEDBACK) {
+        // feedback is looked for on every poll too, its event may be dropped
+        is_calibration_event = true;
+    }
+    if (is_calibration_event && calibration_.STATE != CALIBRATION_STATE::IDLE) {
+        CALIBRATION_RESULT result = HandleCalibration();
+        if (result == CALIBRATION_RESULT::SUCCEEDED) {
+            OPERATION_MODE next_mode = OPERATION_MODE::USER;
+            store_->Clear();
+            SaveParameters();
+            store_->SaveOperationMode(&next_mode);
+            SwitchMode(next_mode);
+            return;
+        }
+        if (result == CALIBRATION_RESULT::FAILED) {
+            // the stored parameters stay, the webpage takes another submission
+            // until the mode expires
+            logger_->Log(INFO, CONTROLLER, LOG_FORMAT("Waiting for another webpage submission"));
+            connectivity_->StartWebpage();
+            mode_start_time_ = current_time::now();
+        }
+    }
+    if (event && event->TYPE == CONTROLLER_EVENT_TYPE::MANUAL_ACTION &&
+        event->MANUAL_ACTION == MANUAL_PUSH::DOUBLE_TAP_BOTH) {
+        SwitchMode(OPERATION_MODE::MAINTENANCE);
+        return;
+    }
+    if (calibration_.STATE != CALIBRATION_STATE::IDLE) {
+        // calibration keeps the mode alive
+        mode_start_time_ = current_time::now();
     }
     int exec_time = std::chrono::duration_cast<std::chrono::seconds>(current_time::now() - mode_start_time_).count();
     if (exec_time > MODE_EXPIRE_TIME_LIMIT) {
-        // restarting
-        logger_->Log(LOG_TYPE::INFO, LOG_CLASS::CONTROLLER, "Reset Mode Expired");
-        RestartDevice();
+        logger_->Log(LOG_TYPE::INFO, LOG_CLASS::CONTROLLER, LOG_FORMAT("Reset Mode Expired"));
+        SwitchMode(OPERATION_MODE::USER);
     }
 }
 
 void Controller::InitializeMaintenanceMode() {
     using namespace CONFIG_SET;
-    logger_->Log(LOG_TYPE::INFO, LOG_CLASS::CONTROLLER, "Starting Maintenance Mode");
-    connectivity_.reset(new Connectivity(logger_, &device_cred_));
+    logger_->Log(LOG_TYPE::INFO, LOG_CLASS::CONTROLLER, LOG_FORMAT("Starting Maintenance Mode"));
+    connectivity_.reset(new Connectivity(logger_, &device_cred_, event_queue_));
     connectivity_->StartOTA();
     mode_start_time_ = current_time::now();
 }
 
-void Controller::HandleMaintenanceMode() {
+void Controller::HandleMaintenanceMode(const CONFIG_SET::CONTROLLER_EVENT* event) {
     using namespace CONFIG_SET;
+    if (event && event->TYPE == CONTROLLER_EVENT_TYPE::MOTION_FEEDBACK) {
+        // the motor driver kept from operation mode reports its cancelled move
+        DrainMotionFeedback();
+    }
     connectivity_->HandleOTA();
     int exec_time = std::chrono::duration_cast<std::chrono::seconds>(current_time::now() - mode_start_time_).count();
     if (exec_time > MODE_EXPIRE_TIME_LIMIT) {
-        // restarting
-        logger_->Log(LOG_TYPE::INFO, LOG_CLASS::CONTROLLER, "Maintenance Mode Expired");
-        RestartDevice();
+        logger_->Log(LOG_TYPE::INFO, LOG_CLASS::CONTROLLER, LOG_FORMAT("Maintenance Mode Expired"));
+        SwitchMode(OPERATION_MODE::USER);
     }
 }
 
 void Controller::InitializeOperationMode() {
     using namespace CONFIG_SET;
-    logger_->Log(LOG_TYPE::INFO, LOG_CLASS::CONTROLLER, "Starting Operation Mode");
+    logger_->Log(LOG_TYPE::INFO, LOG_CLASS::CONTROLLER, LOG_FORMAT("Starting Operation Mode"));
     if (!LoadParameters()) {
-        logger_->Log(LOG_TYPE::INFO, LOG_CLASS::CONTROLLER, "Storage Reading Failed.");
+        logger_->Log(LOG_TYPE::INFO, LOG_CLASS::CONTROLLER, LOG_FORMAT("Storage Reading Failed."));
         indicator_status_ = DEVICE_STATUS::RESET_MODE;
         operation_mode_ = OPERATION_MODE::RESET;
         InitializeResetMode();
         return;
     }
-    connectivity_.reset(new Connectivity(logger_, &device_cred_));
-    connectivity_->StartEnsureConnectivity(device_cred_);
+    StartOperationConnectivity();
     delay(100);
-    motor_driver_.reset(new MotorDriver(logger_, calib_params_));
+    if (!motor_driver_) {
+        motor_driver_.reset(new MotorDriver(logger_, calib_params_, telemetry_, event_queue_));
+    }
+    power_manager_.reset(new PowerManager(logger_));
 }
 
-void Controller::HandleOperationMode() {
+void Controller::StartOperationConnectivity() {
     using namespace CONFIG_SET;
-    if (!alexa_interaction_ && connectivity_->IsConnected()) {
-        alexa_interaction_.reset(new AlexaInteraction(logger_, device_cred_.DEVICE_ID));
-    } else if (alexa_interaction_) {
-        alexa_interaction_->HandleFauxmo();
+    if (alexa_interaction_) {
+        // enabled again once connected
+        alexa_interaction_->Enable(false);
+    }
+    connectivity_.reset();
+    connectivity_.reset(new Connectivity(logger_, &device_cred_, event_queue_));
+    // the new handler reports the connection again
+    is_connected_ = false;
+    connectivity_->StartEnsureConnectivity(device_cred_);
+    connectivity_->StartTelemetryServer(telemetry_);
+    ServeAlexa();
+}
 
-        auto alexa_request_sub = alexa_interaction_->GetAlexaRequest();
-        if (std::get<0>(alexa_request_sub)) {
-            MOTION_REQUEST submitted_alexa_request = std::get<1>(alexa_request_sub);
-            logger_->Log(LOG_TYPE::INFO, LOG_CLASS::CONTROLLER, "Got the Alexa Submission");
-            motor_driver_->FulfillRequest(submitted_alexa_request);
-        }
+void Controller::ServeAlexa() {
+    if (!connectivity_ || !alexa_interaction_) {
+        return;
+    }
+    // kept for the lifetime of the controller, i.e. outlives connectivity
+    AlexaInteraction* alexa_interaction = alexa_interaction_.get();
+    connectivity_->ServeAlexa([alexa_interaction](AsyncWebServerRequest* request, const String& body) {
+        return alexa_interaction->Process(request, body);
+    });
+}
 
-        DRIVER_STATUS current_status = motor_driver_->GetStatus();
-        if (last_motor_status_ != current_status && current_status == DRIVER_STATUS::AVAILABLE) {
-            int current_percentage = motor_driver_->GetPercentage();
-            if (current_percentage != last_blind_percentage_) {
-                MOTION_REQUEST motion_request;
-                motion_request.PERCENTAGE = current_percentage;
-                logger_->Log(LOG_TYPE::INFO, LOG_CLASS::CONTROLLER, "Updating Alexa Percentage");
-                alexa_interaction_->SetState(motion_request);
-                last_blind_percentage_ = current_percentage;
-            }
+void Controller::HandleOperationMode(const CONFIG_SET::CONTROLLER_EVENT* event) {
+    using namespace CONFIG_SET;
+    bool busy = event != nullptr;
+    if (event) {
+        switch (event->TYPE) {
+            case CONTROLLER_EVENT_TYPE::ALEXA_REQUEST:
+                logger_->Log(LOG_TYPE::INFO, LOG_CLASS::CONTROLLER, LOG_FORMAT("Got the Alexa Submission"));
+                if (!motor_driver_->FulfillRequest(event->REQUEST)) {
+                    logger_->Log(LOG_TYPE::WARN, LOG_CLASS::CONTROLLER, LOG_FORMAT("Alexa Submission Rejected"));
+                }
+                break;
+            case CONTROLLER_EVENT_TYPE::MOTOR_STATE:
+                if (event->VALUE == 0 && alexa_interaction_) {
+                    int current_percentage = motor_driver_->GetPercentage();
+                    if (current_percentage != last_blind_percentage_) {
+                        MOTION_REQUEST motion_request;
+                        motion_request.PERCENTAGE = current_percentage;
+                        logger_->Log(LOG_TYPE::INFO, LOG_CLASS::CONTROLLER, LOG_FORMAT("Updating Alexa Percentage"));
+                        alexa_interaction_->SetState(motion_request);
+                        last_blind_percentage_ = current_percentage;
+                    }
+                }
+                break;
+            case CONTROLLER_EVENT_TYPE::MOTION_FEEDBACK:
+                DrainMotionFeedback();
+                break;
+            case CONTROLLER_EVENT_TYPE::PERCENT_MARK:
+                HandlePercentMark(event->VALUE);
+                break;
+            case CONTROLLER_EVENT_TYPE::CONNECTIVITY:
+                HandleConnectivityChange(event->VALUE);
+                break;
+            case CONTROLLER_EVENT_TYPE::MANUAL_ACTION:
+                HandleManualAction(event->MANUAL_ACTION);
+                break;
+            default:
+                break;
+        }
+        if (operation_mode_ != OPERATION_MODE::USER) {
+            // the manual action left operation mode
+            return;
         }
-        last_motor_status_ = current_status;
+    } else {
+        ResyncOperationMode();
+    }
+    if (alexa_interaction_) {
+        alexa_interaction_->HandleFauxmo();
+    }
+
+    bool is_motor_busy = motor_driver_->GetStatus() == DRIVER_STATUS::BUSY;
+    indicator_->UpdateProgress(is_motor_busy ? motor_driver_->GetPercentage() : -1);
+    if (power_manager_) {
+        // nothing to do for a while, idle until the next command
+        power_manager_->Update(busy || is_motor_busy);
+    }
+}
+
+void Controller::ResyncOperationMode() {
+    using namespace CONFIG_SET;
+    // the handler's view, the WiFi status itself runs ahead of its events
+    if (connectivity_ && connectivity_->IsReportedConnected() != is_connected_) {
+        logger_->Log(LOG_TYPE::WARN, LOG_CLASS::CONTROLLER, LOG_FORMAT("Missed a connectivity change"));
+        HandleConnectivityChange(!is_connected_);
     }
+    DrainMotionFeedback();
+}
 
-    if (connectivity_->GetSecLostConnection() > MAX_SECONDS_LOST_WIFI) {
-        logger_->Log(LOG_TYPE::INFO, LOG_CLASS::CONTROLLER, "WiFi Lost");
-        RestartDevice();
+void Controller::HandleConnectivityChange(bool is_connected) {
+    using namespace CONFIG_SET;
+    if (is_connected == is_connected_) {
+        // already caught up on the poll
+        return;
+    }
+    is_connected_ = is_connected;
+    if (!is_connected) {
+        // offline, buttons and the motor keep working while WiFi reconnects
+        logger_->Log(LOG_TYPE::WARN, LOG_CLASS::CONTROLLER, LOG_FORMAT("Offline, Manual Control Only"));
+        indicator_status_ = DEVICE_STATUS::OFFLINE_MODE;
+        if (alexa_interaction_) {
+            alexa_interaction_->Enable(false);
+        }
+        return;
+    }
+    logger_->Log(LOG_TYPE::INFO, LOG_CLASS::CONTROLLER, LOG_FORMAT("Online"));
+    indicator_status_ = DEVICE_STATUS::OPERATION_MODE;
+    if (!alexa_interaction_) {
+        alexa_interaction_.reset(new AlexaInteraction(logger_, device_cred_.DEVICE_ID, event_queue_));
+        ServeAlexa();
+    } else {
+        // joins the discovery multicast group again
+        alexa_interaction_->Enable(true);
     }
+    // moves while offline are reported now
+    MOTION_REQUEST motion_request;
+    motion_request.PERCENTAGE = motor_driver_->GetPercentage();
+    alexa_interaction_->SetState(motion_request);
+    last_blind_percentage_ = motion_request.PERCENTAGE;
+}
 
-    MANUAL_PUSH manual_action_test;
-    time_var manual_action_time_test;
-    std::tie(manual_action_test, manual_action_time_test) = manual_interaction_->GetManualActionAndTime();
-    String out = "";
-    switch (manual_action_test) {
+void Controller::HandleManualAction(CONFIG_SET::MANUAL_PUSH manual_action) {
+    using namespace CONFIG_SET;
+    const char* out = nullptr;
+    switch (manual_action) {
         case MANUAL_PUSH::LONG_PRESS_UP:
             if (!long_press_enabled_) {
-                MOTION_REQUEST motion_request_down;
-                motion_request_down.PERCENTAGE = 100;
-                motor_driver_->FulfillRequest(motion_request_down);
+                // jogs until the button is released
+                MOTION_REQUEST motion_request_up;
+                motion_request_up.PERCENTAGE = 100;
+                motion_request_up.JOG = true;
+                motor_driver_->FulfillRequest(motion_request_up);
             }
             long_press_enabled_ = true;
             out = "LONG_PRESS_UP";
@@ -210,53 +432,130 @@ void Controller::HandleOperationMode() {
             if (!long_press_enabled_) {
                 MOTION_REQUEST motion_request_down;
                 motion_request_down.PERCENTAGE = 0;
+                motion_request_down.JOG = true;
                 motor_driver_->FulfillRequest(motion_request_down);
             }
             long_press_enabled_ = true;
             out = "LONG_PRESS_DOWN";
             break;
         case MANUAL_PUSH::LONG_PRESS_BOTH:
-            operation_mode_ = OPERATION_MODE::RESET;
-            indicator_status_ = DEVICE_STATUS::RESET_MODE;
-            StopOperationMode();
-            store_->SaveOperationMode(&operation_mode_);
-            RestartDevice();
+            logger_->Log(LOG_TYPE::INFO, LOG_CLASS::CONTROLLER, LOG_FORMAT("LONG_PRESS_BOTH"));
+            SwitchMode(OPERATION_MODE::RESET);
+            return;
+        case MANUAL_PUSH::SINGLE_TAP_UP: {
+            MOTION_REQUEST motion_request_nudge;
+            motion_request_nudge.RELATIVE_STEPS = MANUAL_NUDGE_STEPS;
+            motor_driver_->FulfillRequest(motion_request_nudge);
+            out = "SINGLE_TAP_UP";
             break;
-            out = "LONG_PRESS_BOTH";
+        }
+        case MANUAL_PUSH::SINGLE_TAP_DOWN: {
+            MOTION_REQUEST motion_request_nudge;
+            motion_request_nudge.RELATIVE_STEPS = -MANUAL_NUDGE_STEPS;
+            motor_driver_->FulfillRequest(motion_request_nudge);
+            out = "SINGLE_TAP_DOWN";
             break;
-        case MANUAL_PUSH::DOUBLE_TAP_UP:
+        }
+        case MANUAL_PUSH::DOUBLE_TAP_UP: {
             MOTION_REQUEST motion_request_up_1;
             motion_request_up_1.PERCENTAGE = 100;
             motor_driver_->FulfillRequest(motion_request_up_1);
             out = "DOUBLE_TAP_UP";
             break;
-        case MANUAL_PUSH::DOUBLE_TAP_DOWN:
+        }
+        case MANUAL_PUSH::DOUBLE_TAP_DOWN: {
             MOTION_REQUEST motion_request_down_1;
             motion_request_down_1.PERCENTAGE = 0;
             motor_driver_->FulfillRequest(motion_request_down_1);
             out = "DOUBLE_TAP_DOWN";
             break;
+        }
         case MANUAL_PUSH::DOUBLE_TAP_BOTH:
-            operation_mode_ = OPERATION_MODE::MAINTENANCE;
-            indicator_status_ = DEVICE_STATUS::MAINTENANCE_MODE;
-            StopOperationMode();
-            InitializeMaintenanceMode();
-            out = "DOUBLE_TAP_BOTH";
-            break;
+            logger_->Log(LOG_TYPE::INFO, LOG_CLASS::CONTROLLER, LOG_FORMAT("DOUBLE_TAP_BOTH"));
+            SwitchMode(OPERATION_MODE::MAINTENANCE);
+            return;
         case MANUAL_PUSH::NO_PUSH:
             // out = "NO_PUSH";
             break;
         default:
             break;
     }
-    if (out != "") {
-        logger_->Log(LOG_TYPE::INFO, LOG_CLASS::CONTROLLER, out);
+    if (out != nullptr) {
+        logger_->Log(LOG_TYPE::INFO, LOG_CLASS::CONTROLLER, LOG_FORMAT("%s"), out);
     }
-    if ((manual_action_test != MANUAL_PUSH::LONG_PRESS_DOWN && manual_action_test != MANUAL_PUSH::LONG_PRESS_UP) &&
+    if ((manual_action != MANUAL_PUSH::LONG_PRESS_DOWN && manual_action != MANUAL_PUSH::LONG_PRESS_UP) &&
         long_press_enabled_) {
         long_press_enabled_ = false;
-        motor_driver_->CancelCurrentRequest();
+        // usually stopped already by the button analyser on release, this
+        // catches a jog which was not picked by the motor driver back then
+        MotorDriver::StopJog();
+    }
+}
+
+std::tuple<bool, CONFIG_SET::MOTION_FEEDBACK> Controller::HandleMotionFeedback() {
+    using namespace CONFIG_SET;
+    if (!motor_driver_) {
+        return std::make_tuple(false, MOTION_FEEDBACK());
+    }
+    auto motion_feedback = motor_driver_->GetMotionFeedback();
+    if (!std::get<0>(motion_feedback)) {
+        return motion_feedback;
+    }
+    const MOTION_FEEDBACK& feedback = std::get<1>(motion_feedback);
+    switch (feedback.RESULT) {
+        case MOTION_RESULT::COMPLETED:
+            logger_->Log(LOG_TYPE::INFO, LOG_CLASS::CONTROLLER, LOG_FORMAT("Motion Request Completed"));
+            break;
+        case MOTION_RESULT::SUPERSEDED:
+            logger_->Log(LOG_TYPE::INFO, LOG_CLASS::CONTROLLER, LOG_FORMAT("Motion Request Superseded"));
+            break;
+        case MOTION_RESULT::CANCELLED:
+            logger_->Log(LOG_TYPE::INFO, LOG_CLASS::CONTROLLER, LOG_FORMAT("Motion Request Cancelled"));
+            break;
+        case MOTION_RESULT::STALLED:
+            logger_->Log(LOG_TYPE::WARN, LOG_CLASS::CONTROLLER, LOG_FORMAT("Motion Request Stalled"));
+            break;
+        case MOTION_RESULT::TIMED_OUT:
+            logger_->Log(LOG_TYPE::WARN, LOG_CLASS::CONTROLLER, LOG_FORMAT("Motion Request Timed Out"));
+            break;
+        default:
+            break;
+    }
+    if (feedback.TOTAL_STEP_COUNT != 0 && calibration_.STATE == CALIBRATION_STATE::IDLE) {
+        // incremental re-calibration, only the travel changed
+        calib_params_.TOTAL_STEP_COUNT = feedback.TOTAL_STEP_COUNT;
+        if (!store_->SaveCalibParam(&calib_params_)) {
+            logger_->Log(LOG_TYPE::ERROR, LOG_CLASS::CONTROLLER, LOG_FORMAT("Saving Total Step Count Failed"));
+        }
+    }
+    return motion_feedback;
+}
+
+void Controller::DrainMotionFeedback() {
+    while (std::get<0>(HandleMotionFeedback())) {
+    }
+}
+
+void Controller::HandlePercentMark(int percent) {
+    using namespace CONFIG_SET;
+    if (!motor_driver_) {
+        return;
+    }
+    if (motor_driver_->GetStatus() != DRIVER_STATUS::AVAILABLE || calib_params_.TOTAL_STEP_COUNT <= 0) {
+        logger_->Log(LOG_TYPE::WARN, LOG_CLASS::CONTROLLER, LOG_FORMAT("Percent mark ignored, blind not at rest"));
+        return;
     }
+    int step = std::max(0, std::min(calib_params_.TOTAL_STEP_COUNT, motor_driver_->GetSteps()));
+    uint16_t step_fraction = (int64_t(step) * PercentMap::FULL_SCALE) / calib_params_.TOTAL_STEP_COUNT;
+    if (!PercentMap::ApplyMark(calib_params_.PERCENT_MAP, PERCENT_MAP_KNOTS, calib_params_.PERCENT_MARKS, percent,
+                               step_fraction)) {
+        logger_->Log(LOG_TYPE::WARN, LOG_CLASS::CONTROLLER,
+                     LOG_FORMAT("Percent mark rejected, conflicts with earlier marks: %d"), percent);
+        return;
+    }
+    store_->SaveCalibParam(&calib_params_);
+    motor_driver_->UpdatePercentMap(calib_params_.PERCENT_MAP);
+    logger_->Log(LOG_TYPE::INFO, LOG_CLASS::CONTROLLER, LOG_FORMAT("Percent map marked at %d"), percent);
 }
 
 bool Controller::LoadParameters() {
@@ -267,90 +566,167 @@ bool Controller::LoadParameters() {
 }
 
 bool Controller::SaveParameters() {
-    return store_->SaveDeviceCred(&device_cred_) && store_->SaveCalibParam(&calib_params_) &&
-           store_->SaveOperationMode(&operation_mode_);
+    return store_->SaveDeviceCred(&device_cred_) && store_->SaveCalibParam(&calib_params_);
 }
 
-bool Controller::Calibrate() {
+void Controller::StartCalibration() {
     using namespace CONFIG_SET;
-    logger_->Log(LOG_TYPE::INFO, LOG_CLASS::CONTROLLER, "Calibrating");
+    logger_->Log(LOG_TYPE::INFO, LOG_CLASS::CONTROLLER, LOG_FORMAT("Calibrating"));
+    calibration_ = CALIBRATION();
+    calibration_.PARAMS.DIRECTION = true;
+    StartCalibrationLeg();
+}
 
-    delay(3000);
-    CALIB_PARAMS calib_params;
+void Controller::StartCalibrationLeg() {
+    using namespace CONFIG_SET;
+    // a fresh driver per leg counts from 0 at the current end, the direction
+    // parameter selects the physical direction of the leg, the previous driver
+    // goes first as it detaches the pin interrupts and ends the profile timer
+    motor_driver_.reset();
+    motor_driver_.reset(new MotorDriver(logger_, calibration_.PARAMS, telemetry_, event_queue_));
+    motor_driver_->StartStallGuardSampling();
+    MOTION_REQUEST seek_request;
+    seek_request.PERCENTAGE = 100;
+    SubmitCalibrationRequest(CALIBRATION_STATE::SEEK, seek_request);
+}
 
-    auto find_end = [&]() -> std::tuple<int, int> {
-        MOTION_REQUEST motion_request_up;
-        motor_driver_.reset(new MotorDriver(logger_, calib_params));
-        motion_request_up.PERCENTAGE = 100;
-        motor_driver_->FulfillRequest(motion_request_up);
-
-        time_var start_time = current_time::now();
-        int execution_time = 0;
-        while (motor_driver_->GetStatus() != DRIVER_STATUS::BUSY) {
-            execution_time = std::chrono::duration_cast<std::chrono::seconds>(current_time::now() - start_time).count();
-            if (execution_time > MOTOR_STOP_TIME_SEC) {
-                logger_->Log(LOG_TYPE::INFO, LOG_CLASS::CONTROLLER,
-                             "Stopping Motor, reached time limit for calibration");
-                break;
-            }
-        }
+void Controller::SubmitCalibrationRequest(CONFIG_SET::CALIBRATION_STATE state, CONFIG_SET::MOTION_REQUEST request) {
+    calibration_.STATE = state;
+    calibration_.REQUEST_ID = motor_driver_->FulfillRequest(request);
+    if (calibration_.REQUEST_ID == 0) {
+        calibration_.STATE = CONFIG_SET::CALIBRATION_STATE::FAILED;
+    }
+}
 
-        while (motor_driver_->GetStatus() != DRIVER_STATUS::AVAILABLE) {
-            execution_time = std::chrono::duration_cast<std::chrono::seconds>(current_time::now() - start_time).count();
-            if (execution_time > MOTOR_STOP_TIME_SEC) {
-                logger_->Log(LOG_TYPE::INFO, LOG_CLASS::CONTROLLER,
-                             "Stopping Motor, reached time limit for calibration");
-                break;
-            }
+CONFIG_SET::CALIBRATION_RESULT Controller::HandleCalibration() {
+    using namespace CONFIG_SET;
+    if (calibration_.STATE == CALIBRATION_STATE::FAILED) {
+        return FailCalibration();
+    }
+    MOTION_FEEDBACK feedback;
+    bool feedback_available;
+    // feedback of earlier requests is skipped, several may be queued
+    do {
+        std::tie(feedback_available, feedback) = HandleMotionFeedback();
+        if (!feedback_available) {
+            return CALIBRATION_RESULT::PENDING;
         }
-        logger_->Log(LOG_TYPE::INFO, LOG_CLASS::CONTROLLER, "Loop Ended");
+    } while (feedback.ID != calibration_.REQUEST_ID);
+    // a traversal reports completion when it stalled into the end stop
+    if (feedback.RESULT != MOTION_RESULT::COMPLETED) {
+        logger_->Log(LOG_TYPE::ERROR, LOG_CLASS::CONTROLLER, LOG_FORMAT("Not found an end, calibration aborted"));
+        return FailCalibration();
+    }
 
-        if (motor_driver_->GetStatus() != DRIVER_STATUS::AVAILABLE) {
-            motor_driver_->CancelCurrentRequest();
+    switch (calibration_.STATE) {
+        case CALIBRATION_STATE::SEEK: {
+            calibration_.STALLGUARD_TUNINGS[calibration_.LEG] = motor_driver_->GetStallGuardTuning();
+            MOTION_REQUEST back_off_request;
+            back_off_request.RELATIVE_STEPS = -CALIBRATION_BACKOFF_STEPS;
+            SubmitCalibrationRequest(CALIBRATION_STATE::BACK_OFF, back_off_request);
+            break;
         }
-        return std::make_tuple(execution_time, motor_driver_->GetSteps());
-    };
-
-    calib_params.DIRECTION = true;
-    int first_dir_exec_time, first_dir_stps;
-    std::tie(first_dir_exec_time, first_dir_stps) = find_end();
-    if (first_dir_exec_time >= MOTOR_STOP_TIME_SEC) {
-        logger_->Log(LOG_TYPE::INFO, LOG_CLASS::CONTROLLER, "Not found an end, returning from first dir");
-        return false;
+        case CALIBRATION_STATE::BACK_OFF: {
+            MOTION_REQUEST approach_request;
+            approach_request.PERCENTAGE = 100;
+            approach_request.CREEP = true;
+            SubmitCalibrationRequest(CALIBRATION_STATE::APPROACH, approach_request);
+            break;
+        }
+        case CALIBRATION_STATE::APPROACH:
+            logger_->Log(LOG_TYPE::INFO, LOG_CLASS::CONTROLLER, LOG_FORMAT("Found end %d at %d"),
+                         calibration_.LEG + 1, motor_driver_->GetSteps());
+            if (calibration_.LEG == 0) {
+                calibration_.LEG = 1;
+                calibration_.PARAMS.DIRECTION = false;
+                StartCalibrationLeg();
+            } else {
+                FinishCalibration(motor_driver_->GetSteps());
+            }
+            break;
+        default:
+            break;
     }
-    delay(3000);
-
-    calib_params.DIRECTION = false;
-    int sec_dir_exec_time, sec_dir_stps;
-    std::tie(sec_dir_exec_time, sec_dir_stps) = find_end();
-    if (sec_dir_exec_time >= MOTOR_STOP_TIME_SEC) {
-        logger_->Log(LOG_TYPE::INFO, LOG_CLASS::CONTROLLER, "Not found an end, returning from second dir");
-        return false;
+    if (calibration_.STATE == CALIBRATION_STATE::FAILED) {
+        // the next request was refused
+        return FailCalibration();
     }
+    return calibration_.STATE == CALIBRATION_STATE::IDLE ? CALIBRATION_RESULT::SUCCEEDED : CALIBRATION_RESULT::PENDING;
+}
 
-    calib_params.DIRECTION = (first_dir_exec_time < (sec_dir_exec_time * 0.3));
-    calib_params.TOTAL_STEP_COUNT = std::max(first_dir_stps, sec_dir_stps);
-    calib_params_ = calib_params;
-    logger_->Log(LOG_TYPE::INFO, LOG_CLASS::CONTROLLER, "Calibration Successful");
-    return true;
+CONFIG_SET::CALIBRATION_RESULT Controller::FailCalibration() {
+    using namespace CONFIG_SET;
+    logger_->Log(LOG_TYPE::ERROR, LOG_CLASS::CONTROLLER, LOG_FORMAT("Calibration Failed"));
+    calibration_.STATE = CALIBRATION_STATE::IDLE;
+    motor_driver_.reset();
+    return CALIBRATION_RESULT::FAILED;
 }
 
-void Controller::StopOperationMode() {
+void Controller::FinishCalibration(int total_step_count) {
     using namespace CONFIG_SET;
-    logger_->Log(LOG_TYPE::INFO, LOG_CLASS::CONTROLLER, "Stopping Operation Mode");
+    CALIB_PARAMS calib_params;
+    // the operation driver starts at step 0 at the end the last leg ran into,
+    // stepping up has to run the other way
+    calib_params.DIRECTION = !calibration_.PARAMS.DIRECTION;
+    calib_params.TOTAL_STEP_COUNT = total_step_count;
+    PercentMap::FromWrapRatio(ROLLER_WRAP_RATIO, calib_params.PERCENT_MAP, PERCENT_MAP_KNOTS);
+
+    // the direction with more load (lower SG_RESULT) decides the threshold, so
+    // that neither direction reports false stalls
+    for (const STALLGUARD_TUNING& tuning : calibration_.STALLGUARD_TUNINGS) {
+        if (!tuning.VALID) {
+            logger_->Log(LOG_TYPE::WARN, LOG_CLASS::CONTROLLER, LOG_FORMAT("Not enough StallGuard samples: %d"),
+                         tuning.SAMPLE_COUNT);
+            continue;
+        }
+        if (tuning.THRESHOLD < calib_params.SG_THRESHOLD || calib_params.SG_MARGIN == 0) {
+            calib_params.SG_THRESHOLD = tuning.THRESHOLD;
+            calib_params.SG_MARGIN = tuning.MARGIN;
+        }
+    }
+    logger_->Log(LOG_TYPE::INFO, LOG_CLASS::CONTROLLER, LOG_FORMAT("StallGuard Threshold: %d, Margin: %d"),
+                 calib_params.SG_THRESHOLD, calib_params.SG_MARGIN);
+    calib_params_ = calib_params;
+    calibration_.STATE = CALIBRATION_STATE::IDLE;
     motor_driver_.reset();
-    alexa_interaction_.reset();
+    logger_->Log(LOG_TYPE::INFO, LOG_CLASS::CONTROLLER, LOG_FORMAT("Calibration Successful"));
+}
+
+void Controller::StopOperationMode(CONFIG_SET::OPERATION_MODE next_mode) {
+    using namespace CONFIG_SET;
+    logger_->Log(LOG_TYPE::INFO, LOG_CLASS::CONTROLLER, LOG_FORMAT("Stopping Operation Mode"));
+    power_manager_.reset();
+    if (alexa_interaction_) {
+        alexa_interaction_->Enable(false);
+    }
+    connectivity_.reset();
+    if (next_mode == OPERATION_MODE::MAINTENANCE && motor_driver_) {
+        // kept for the way back, stopped meanwhile
+        motor_driver_->CancelCurrentRequest();
+    } else {
+        motor_driver_.reset();
+    }
+    long_press_enabled_ = false;
+    indicator_->UpdateProgress(-1);
+}
+
+void Controller::StopMaintenanceMode() {
+    using namespace CONFIG_SET;
+    logger_->Log(LOG_TYPE::INFO, LOG_CLASS::CONTROLLER, LOG_FORMAT("Stopping Maintenance Mode"));
     connectivity_.reset();
 }
 
 void Controller::StopResetMode() {
     using namespace CONFIG_SET;
-    logger_->Log(LOG_TYPE::INFO, LOG_CLASS::CONTROLLER, "Stopping Reset Mode");
+    logger_->Log(LOG_TYPE::INFO, LOG_CLASS::CONTROLLER, LOG_FORMAT("Stopping Reset Mode"));
+    calibration_.STATE = CALIBRATION_STATE::IDLE;
+    motor_driver_.reset();
     connectivity_.reset();
 }
 
 void Controller::RestartDevice() {
     using namespace CONFIG_SET;
-    logger_->Log(LOG_TYPE::INFO, LOG_CLASS::CONTROLLER, "Restarting Device");
+    logger_->Log(LOG_TYPE::INFO, LOG_CLASS::CONTROLLER, LOG_FORMAT("Restarting Device"));
+    logger_->Flush();
     ESP.restart();
 }
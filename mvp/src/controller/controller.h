@@ -17,11 +17,16 @@
 #include "../alexa_interaction/alexa_interaction.h"
 #include "../config/config.h"
 #include "../connectivity/connectivity.h"
+#include "../event_queue/event_queue.h"
 #include "../indicator/indicator.h"
+#include "../latency/latency.h"
 #include "../logging/logging.h"
 #include "../manual_interaction/manual_interaction.h"
 #include "../motor_driver/motor_driver.h"
+#include "../percent_map/percent_map.h"
+#include "../power_manager/power_manager.h"
 #include "../storage/storage.h"
+#include "../telemetry/telemetry.h"
 
 class Controller {
    public:
@@ -39,11 +44,11 @@ class Controller {
 
     /**
    * @brief Continous loop after initialization, handles the controlling of the
-   * device
+   * device, blocks until the next event or deadline (see GetWaitTime())
    * Performs following functions:
    * 1. Updates the device status on indicator
-   * 2. Fetches commands from alexa
-   * 3. Fetches commands from manual control
+   * 2. Handles commands from alexa
+   * 3. Handles commands from manual control
    * 4. Gives instructions to motor driver
    * 5. Ensure connectivity to internet
    * 6. Controls OTA enable
@@ -58,18 +63,37 @@ class Controller {
     CONFIG_SET::OPERATION_MODE operation_mode_;
     CONFIG_SET::DEVICE_STATUS indicator_status_;
     CONFIG_SET::time_var mode_start_time_;
-    CONFIG_SET::DRIVER_STATUS last_motor_status_;
     int last_blind_percentage_;
     bool long_press_enabled_;
+    int64_t last_latency_report_ms_ = 0;
+    // last state reported by connectivity, compared with it on every poll
+    bool is_connected_ = false;
+    uint32_t dropped_event_count_ = 0;
+
+    /**
+   * @brief Progress of the calibration, two legs, one per end
+   *
+   */
+    struct CALIBRATION {
+        CONFIG_SET::CALIBRATION_STATE STATE = CONFIG_SET::CALIBRATION_STATE::IDLE;
+        int LEG = 0;
+        uint32_t REQUEST_ID = 0;
+        CONFIG_SET::CALIB_PARAMS PARAMS;
+        CONFIG_SET::STALLGUARD_TUNING STALLGUARD_TUNINGS[2];
+    };
+    CALIBRATION calibration_;
 
     // Device class objects initialization
     std::shared_ptr<Logging> logger_{nullptr};
+    std::shared_ptr<EventQueue> event_queue_{nullptr};
     std::unique_ptr<Storage> store_{nullptr};
     std::unique_ptr<Indicator> indicator_{nullptr};
+    std::shared_ptr<TelemetryRecorder> telemetry_{nullptr};
     std::unique_ptr<Connectivity> connectivity_{nullptr};
     std::unique_ptr<AlexaInteraction> alexa_interaction_{nullptr};
     std::unique_ptr<MotorDriver> motor_driver_{nullptr};
     std::unique_ptr<ManualInteraction> manual_interaction_{nullptr};
+    std::unique_ptr<PowerManager> power_manager_{nullptr};
 
     /**
    * @brief Mounts all the parameters from the storage
@@ -78,11 +102,27 @@ class Controller {
     bool LoadParameters();
 
     /**
-   * @brief Save all the parameters to storage
+   * @brief Save device credentials and calibration parameters to storage
    *
    */
     bool SaveParameters();
 
+    /**
+   * @brief Switches the mode without restarting the device, the exit hook of
+   * the current mode and the enter hook of the next one only tear down and
+   * build up what differs between the two
+   *
+   * @param mode: mode to switch to
+   */
+    void SwitchMode(CONFIG_SET::OPERATION_MODE mode);
+
+    /**
+   * @brief Enter hook of operation_mode_, sets the indicator and initializes
+   * the mode
+   *
+   */
+    void EnterMode();
+
     /**
    * @brief Initialize reset mode
    *
@@ -92,8 +132,9 @@ class Controller {
     /**
    * @brief Handle reset mode
    *
+   * @param event: the event woken up for, nullptr on a deadline
    */
-    void HandleResetMode();
+    void HandleResetMode(const CONFIG_SET::CONTROLLER_EVENT* event);
 
     /**
    * @brief Initialize maintenance mode
@@ -102,10 +143,11 @@ class Controller {
     void InitializeMaintenanceMode();
 
     /**
-   * @brief Handle reset mode
+   * @brief Handle maintenance mode
    *
+   * @param event: the event woken up for, nullptr on a deadline
    */
-    void HandleMaintenanceMode();
+    void HandleMaintenanceMode(const CONFIG_SET::CONTROLLER_EVENT* event);
 
     /**
    * @brief Initialize operation mode
@@ -116,8 +158,76 @@ class Controller {
     /**
    * @brief Handle operation mode
    *
+   * @param event: the event woken up for, nullptr on a deadline
+   */
+    void HandleOperationMode(const CONFIG_SET::CONTROLLER_EVENT* event);
+
+    /**
+   * @brief Goes offline (manual control only, Alexa disabled) when WiFi is
+   * lost and re-arms Alexa in place when it is back
+   *
+   */
+    void HandleConnectivityChange(bool is_connected);
+
+    /**
+   * @brief Lets connectivity hand the Alexa requests on port 80 to Alexa
+   * interaction, once both exist
+   *
+   */
+    void ServeAlexa();
+
+    /**
+   * @brief Catches up on the events of operation mode which were dropped on a
+   * full event queue, by comparing the last known state with the sources
+   *
+   */
+    void ResyncOperationMode();
+
+    /**
+   * @brief Logs the number of events dropped on a full event queue since the
+   * last call
+   *
+   */
+    void ReportDroppedEvents();
+
+    /**
+   * @brief Acts on a manual action, called for every gesture reported
+   *
+   * @param manual_action: gesture as posted by ManualInteraction
+   */
+    void HandleManualAction(CONFIG_SET::MANUAL_PUSH manual_action);
+
+    /**
+   * @brief Returns how long Handle() may block on the event queue, i.e. until
+   * the next poll of fauxmo or OTA, or the mode expiry
+   *
+   */
+    unsigned long GetWaitTime();
+
+    /**
+   * @brief Reads back the result of motion requests from motor driver and
+   * reports them, stores the re-measured travel if an end stop moved
+   *
+   * @return std::tuple<bool, CONFIG_SET::MOTION_FEEDBACK>: bool returning if
+   * there was a feedback, the feedback itself
    */
-    void HandleOperationMode();
+    std::tuple<bool, CONFIG_SET::MOTION_FEEDBACK> HandleMotionFeedback();
+
+    /**
+   * @brief Reports every queued motion feedback, one MOTION_FEEDBACK event
+   * may stand for several
+   *
+   */
+    void DrainMotionFeedback();
+
+    /**
+   * @brief Applies a percent map mark from the telemetry server, i.e. the
+   * resting blind is at the marked percentage, stores the refined map and
+   * hands it to motor driver
+   *
+   * @param percent: the marked percentage
+   */
+    void HandlePercentMark(int percent);
 
     /**
    * @brief Restarts device
@@ -126,10 +236,25 @@ class Controller {
     void RestartDevice();
 
     /**
-   * @brief Call when exiting operation mode
+   * @brief (Re)starts WiFi, the telemetry server and Alexa once connected, for
+   * operation mode
+   *
+   */
+    void StartOperationConnectivity();
+
+    /**
+   * @brief Call when exiting operation mode, the motor driver is kept when
+   * going to maintenance mode
+   *
+   * @param next_mode: mode to switch to
+   */
+    void StopOperationMode(CONFIG_SET::OPERATION_MODE next_mode);
+
+    /**
+   * @brief Call when exiting maintenance mode
    *
    */
-    void StopOperationMode();
+    void StopMaintenanceMode();
 
     /**
    * @brief Call when exiting reset mode
@@ -138,12 +263,54 @@ class Controller {
     void StopResetMode();
 
     /**
-   * @brief Calibrate the motor driver, determine the stall value and total step
-   * count, updates internal calib_params_ with new params if successful
+   * @brief Starts calibrating the motor driver, i.e. determining the stall
+   * value and total step count. Calibration runs without blocking, driven by
+   * HandleCalibration()
+   *
+   */
+    void StartCalibration();
+
+    /**
+   * @brief Recreates the motor driver for the next leg and starts seeking its
+   * end
+   *
+   */
+    void StartCalibrationLeg();
+
+    /**
+   * @brief Submits the request of the next calibration step
+   *
+   */
+    void SubmitCalibrationRequest(CONFIG_SET::CALIBRATION_STATE state, CONFIG_SET::MOTION_REQUEST request);
+
+    /**
+   * @brief Advances the calibration on the feedback of its motion requests,
+   * per end: fast seek, back off, slow approach. Updates calib_params_ if
+   * successful
+   *
+   * @return CALIBRATION_RESULT: PENDING until the calibration finished
+   */
+    CONFIG_SET::CALIBRATION_RESULT HandleCalibration();
+
+    /**
+   * @brief Ends a failed calibration, calib_params_ stay as they were
+   *
+   * @return CALIBRATION_RESULT: FAILED
+   */
+    CONFIG_SET::CALIBRATION_RESULT FailCalibration();
+
+    /**
+   * @brief Derives direction, total step count and StallGuard threshold from
+   * both legs
+   *
+   */
+    void FinishCalibration(int total_step_count);
+
+    /**
+   * @brief Logs the latency histograms every LATENCY_REPORT_INTERVAL_MS
    *
-   * @return successful (true) or not (false)
    */
-    bool Calibrate();
+    void ReportLatency();
 };
 
 #endif
@@ -0,0 +1,99 @@
+/**
+ * @file debouncer.h
+ * @author Mahimana Bhatt (mahimanabhatt@gmail.com)
+ * @brief Defines an integrating debouncer for a periodically sampled input
+ *
+ * Every sample moves an integrator one step towards the sampled level, between
+ * 0 and the given number of samples, and the debounced level only follows once
+ * the integrator reaches that end. Bounces and glitches shorter than that
+ * never show, a real change shows after that many samples. The edge carries
+ * the time of the sample at which the integrator last left the other end, i.e.
+ * where the change which went through began.
+ *
+ * Everything is inline and the time comes with the sample, so the same code
+ * runs in a timer interrupt on the device and over recorded traces on the
+ * host.
+ *
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef _DEBOUNCER_INCLUDE_GUARD
+#define _DEBOUNCER_INCLUDE_GUARD
+
+#include <cstdint>
+
+class Debouncer {
+   public:
+    /**
+     * @brief Construct a new Debouncer object
+     *
+     * @param samples: net samples at a level before it is taken, at least 1
+     * @param level: debounced level to start with
+     */
+    explicit Debouncer(uint8_t samples = 1, bool level = false)
+        : samples_(samples ? samples : 1),
+          integrator_(level ? samples_ : 0),
+          level_(level),
+          departure_time_us_(0),
+          edge_time_us_(0) {}
+
+    /**
+     * @brief Feeds the next sample
+     *
+     * @param level: sampled level
+     * @param time_us: time of the sample, wraps around
+     * @return true : if the debounced level changed, see GetLevel() and
+     * GetEdgeTime()
+     * @return false : otherwise
+     */
+    bool Sample(bool level, uint32_t time_us) {
+        uint8_t rest = level_ ? samples_ : 0;
+        if (integrator_ == rest && level != level_) {
+            // leaving the end of the debounced level, a change may begin here
+            departure_time_us_ = time_us;
+        }
+        if (level && integrator_ < samples_) {
+            integrator_++;
+        } else if (!level && integrator_ > 0) {
+            integrator_--;
+        }
+        bool has_changed = level_ ? integrator_ == 0 : integrator_ == samples_;
+        if (has_changed) {
+            level_ = !level_;
+            edge_time_us_ = departure_time_us_;
+        }
+        return has_changed;
+    }
+
+    /**
+     * @brief Returns the debounced level
+     *
+     */
+    bool GetLevel() const { return level_; }
+
+    /**
+     * @brief Returns the time the last change of the debounced level began
+     *
+     */
+    uint32_t GetEdgeTime() const { return edge_time_us_; }
+
+    /**
+     * @brief Returns true if the integrator rests at the debounced level, i.e.
+     * no change is underway and sampling may pause
+     *
+     */
+    bool IsSettled() const { return integrator_ == (level_ ? samples_ : 0); }
+
+   private:
+    uint8_t samples_;
+    uint8_t integrator_;
+    bool level_;
+    uint32_t departure_time_us_;
+    uint32_t edge_time_us_;
+};
+
+#endif
@@ -0,0 +1,41 @@
+/**
+ * @file event_queue.cpp
+ * @author Dhiraj Deshmukh (deshmukhdhiraj15@gmail.com)
+ * @brief Contains the controller event queue on top of a FreeRTOS queue
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include "event_queue.h"
+
+#include <Arduino.h>
+
+#include "../config/config.h"
+#include "../monotonic_clock/monotonic_clock.h"
+
+EventQueue::EventQueue(int size) : queue_(xQueueCreate(size, sizeof(CONFIG_SET::CONTROLLER_EVENT))) {}
+
+EventQueue::~EventQueue() {
+    vQueueDelete(queue_);
+}
+
+bool EventQueue::Post(const CONFIG_SET::CONTROLLER_EVENT& event) {
+    CONFIG_SET::CONTROLLER_EVENT posted_event = event;
+    posted_event.POST_TIME_US = MonotonicClock::NowUs();
+    if (xQueueSend(queue_, &posted_event, 0) != pdTRUE) {
+        dropped_count_++;
+        return false;
+    }
+    return true;
+}
+
+bool EventQueue::Wait(CONFIG_SET::CONTROLLER_EVENT& event, unsigned long timeout_ms) {
+    return xQueueReceive(queue_, &event, pdMS_TO_TICKS(timeout_ms)) == pdTRUE;
+}
+
+uint32_t EventQueue::GetDroppedCount() const {
+    return dropped_count_;
+}
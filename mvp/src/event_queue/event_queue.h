@@ -0,0 +1,69 @@
+/**
+ * @file event_queue.h
+ * @author Mahimana Bhatt (mahimanabhatt@gmail.com)
+ * @brief Defines the queue of controller events, posted by the Alexa callback,
+ * button analyser, connectivity handler and motor driver, and consumed by the
+ * controller which blocks on it instead of polling every source
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef _EVENT_QUEUE_INCLUDE_GUARD
+#define _EVENT_QUEUE_INCLUDE_GUARD
+
+#include <Arduino.h>
+
+#include <atomic>
+#include <cstdint>
+
+#include "../config/config.h"
+
+class EventQueue {
+   public:
+    /**
+     * @brief Construct a new Event Queue object
+     *
+     * @param size: number of events it holds
+     */
+    EventQueue(int size);
+
+    /**
+     * @brief Destroy the Event Queue object
+     *
+     */
+    ~EventQueue();
+
+    /**
+     * @brief Posts an event from task context, never blocks, stamps its
+     * POST_TIME_US
+     *
+     * @return true : if posted
+     * @return false : if the queue is full, the event is dropped and counted
+     */
+    bool Post(const CONFIG_SET::CONTROLLER_EVENT& event);
+
+    /**
+     * @brief Blocks until an event is available or the timeout expires
+     *
+     * @param event: filled with the oldest event
+     * @param timeout_ms: maximum time to block
+     * @return true : if an event was taken
+     * @return false : on timeout
+     */
+    bool Wait(CONFIG_SET::CONTROLLER_EVENT& event, unsigned long timeout_ms);
+
+    /**
+     * @brief Returns the number of events dropped because the queue was full
+     *
+     */
+    uint32_t GetDroppedCount() const;
+
+   private:
+    QueueHandle_t queue_;
+    std::atomic<uint32_t> dropped_count_{0};
+};
+
+#endif
@@ -11,38 +11,209 @@
 
 #include "indicator.h"
 
+#include <Arduino.h>
 #include <FastLED.h>
+#include <esp_timer.h>
+
+#include <mutex>
 
 #include "../config/config.h"
+#include "../latency/latency.h"
 #include "../logging/logging.h"
+#include "../monotonic_clock/monotonic_clock.h"
+
+namespace {
+// WS2812 bit timings
+const uint32_t WS2812_T0H_NS = 400;
+const uint32_t WS2812_T0L_NS = 850;
+const uint32_t WS2812_T1H_NS = 800;
+const uint32_t WS2812_T1L_NS = 450;
+}  // namespace
 
-Indicator::~Indicator() {}
+Indicator::~Indicator() {
+    if (frame_timer_) {
+        esp_timer_stop(frame_timer_);
+        esp_timer_delete(frame_timer_);
+    }
+    if (rmt_) {
+        rmtDeinit(rmt_);
+    }
+}
 
 Indicator::Indicator(std::shared_ptr<Logging>& logging) : logger_(logging) {
     InitializeLED();
 }
 
 void Indicator::InitializeLED() {
-    FastLED.addLeds<WS2812, CONFIG_SET::PIN_RGB_LED, GRB>(leds_, CONFIG_SET::NUMBER_OF_LEDS);
-    FastLED.setBrightness(CONFIG_SET::LED_BRIGHTNESS);
-    leds_[0] = CRGB::Green;
-    FastLED.show();
+    using namespace CONFIG_SET;
+    // the RMT peripheral generates the bit timing, interrupts stay enabled
+    rmt_ = rmtInit(PIN_RGB_LED, RMT_TX_MODE, RMT_MEM_64);
+    if (!rmt_) {
+        logger_->Log(LOG_TYPE::ERROR, LOG_CLASS::INDICATOR, LOG_FORMAT("RMT Initialization Failed"));
+        return;
+    }
+    rmtSetTick(rmt_, INDICATOR_RMT_TICK_NS);
+
+    esp_timer_create_args_t timer_args = {};
+    timer_args.callback = &Indicator::s_FrameTimerCallback;
+    timer_args.arg = this;
+    timer_args.dispatch_method = ESP_TIMER_TASK;
+    timer_args.name = "indicator";
+    if (esp_timer_create(&timer_args, &frame_timer_) != ESP_OK) {
+        frame_timer_ = NULL;
+        logger_->Log(LOG_TYPE::ERROR, LOG_CLASS::INDICATOR, LOG_FORMAT("Frame Timer Initialization Failed"));
+    }
+
+    std::lock_guard<std::mutex> lock(effect_mutex_);
+    color_ = CRGB::Green;
+    StartEffect();
 }
 
 bool Indicator::UpdateStatus(CONFIG_SET::DEVICE_STATUS status) {
     using namespace CONFIG_SET;
-    switch (status) {
-        case DEVICE_STATUS::OPERATION_MODE:
-            leds_[0] = CRGB::Green;
+    if (!rmt_) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(effect_mutex_);
+    if (is_status_set_ && status == status_) {
+        return true;
+    }
+    is_status_set_ = true;
+    status_ = status;
+    StartEffect();
+    return true;
+}
+
+void Indicator::UpdateProgress(int percentage) {
+    if (!rmt_) {
+        return;
+    }
+    percentage = percentage < 0 ? -1 : (percentage > 100 ? 100 : percentage);
+    std::lock_guard<std::mutex> lock(effect_mutex_);
+    if (percentage == progress_) {
+        return;
+    }
+    progress_ = percentage;
+    StartEffect();
+}
+
+void Indicator::StartEffect() {
+    using namespace CONFIG_SET;
+    effect_ = INDICATOR_EFFECT::SOLID;
+    if (is_status_set_) {
+        switch (status_) {
+            case DEVICE_STATUS::OPERATION_MODE:
+                color_ = CRGB::Green;
+                effect_ = progress_ >= 0 ? INDICATOR_EFFECT::PROGRESS : INDICATOR_EFFECT::SOLID;
+                break;
+            case DEVICE_STATUS::OFFLINE_MODE:
+                color_ = CRGB::Orange;
+                effect_ = progress_ >= 0 ? INDICATOR_EFFECT::PROGRESS : INDICATOR_EFFECT::SOLID;
+                break;
+            case DEVICE_STATUS::RESET_MODE:
+                color_ = CRGB::White;
+                effect_ = INDICATOR_EFFECT::BREATHE;
+                break;
+            case DEVICE_STATUS::MAINTENANCE_MODE:
+                color_ = CRGB::Purple;
+                effect_ = INDICATOR_EFFECT::BREATHE;
+                break;
+            default:
+                color_ = CRGB::Red;
+                effect_ = INDICATOR_EFFECT::BLINK_CODE;
+                blink_count_ = INDICATOR_FAULT_BLINKS;
+        }
+    }
+    effect_start_ms_ = MonotonicClock::NowMs();
+
+    bool is_animated = effect_ == INDICATOR_EFFECT::BREATHE || effect_ == INDICATOR_EFFECT::BLINK_CODE;
+    if (frame_timer_ && is_animated && !is_frame_timer_running_) {
+        is_frame_timer_running_ = esp_timer_start_periodic(frame_timer_, 1000000 / INDICATOR_FRAME_RATE_HZ) == ESP_OK;
+    } else if (frame_timer_ && !is_animated && is_frame_timer_running_) {
+        esp_timer_stop(frame_timer_);
+        is_frame_timer_running_ = false;
+    }
+    Render();
+}
+
+void Indicator::Render() {
+    using namespace CONFIG_SET;
+    unsigned long elapsed_ms = MonotonicClock::NowMs() - effect_start_ms_;
+    switch (effect_) {
+        case INDICATOR_EFFECT::BREATHE: {
+            uint8_t phase = (elapsed_ms % INDICATOR_BREATHE_PERIOD_MS) * 256 / INDICATOR_BREATHE_PERIOD_MS;
+            uint8_t level = INDICATOR_DIM_LEVEL + scale8(quadwave8(phase), 255 - INDICATOR_DIM_LEVEL);
+            for (CRGB& led : leds_) {
+                led = color_;
+                led.nscale8_video(level);
+            }
             break;
-        case DEVICE_STATUS::RESET_MODE:
-            leds_[0] = CRGB::White;
+        }
+        case INDICATOR_EFFECT::BLINK_CODE: {
+            unsigned long blinks_ms = 2 * INDICATOR_BLINK_MS * blink_count_;
+            unsigned long cycle_ms = elapsed_ms % (blinks_ms + INDICATOR_BLINK_PAUSE_MS);
+            bool is_on = cycle_ms < blinks_ms && (cycle_ms / INDICATOR_BLINK_MS) % 2 == 0;
+            for (CRGB& led : leds_) {
+                led = is_on ? color_ : CRGB(CRGB::Black);
+            }
             break;
-        case DEVICE_STATUS::MAINTENANCE_MODE:
-            leds_[0] = CRGB::Purple;
+        }
+        case INDICATOR_EFFECT::PROGRESS: {
+            // lit part in 1/256 of a LED, the boundary LED is partially lit
+            int lit = progress_ * NUMBER_OF_LEDS * 256 / 100;
+            for (int i = 0; i < NUMBER_OF_LEDS; i++) {
+                int fill = lit - i * 256;
+                fill = fill < 0 ? 0 : (fill > 255 ? 255 : fill);
+                leds_[i] = color_;
+                leds_[i].nscale8_video(INDICATOR_DIM_LEVEL + scale8(fill, 255 - INDICATOR_DIM_LEVEL));
+            }
             break;
+        }
         default:
-            leds_[0] = CRGB::Red;
+            for (CRGB& led : leds_) {
+                led = color_;
+            }
+    }
+    Show();
+}
+
+void Indicator::Show() {
+    using namespace CONFIG_SET;
+    bool is_changed = !is_frame_shown_;
+    for (int i = 0; i < NUMBER_OF_LEDS; i++) {
+        is_changed = is_changed || leds_[i] != shown_leds_[i];
+    }
+    if (!is_changed) {
+        return;
+    }
+    LatencyTimer timer(LATENCY_PROBE::LED_SHOW);
+    rmt_data_t bits[2];
+    for (int bit = 0; bit < 2; bit++) {
+        bits[bit].level0 = 1;
+        bits[bit].duration0 = (bit ? WS2812_T1H_NS : WS2812_T0H_NS) / INDICATOR_RMT_TICK_NS;
+        bits[bit].level1 = 0;
+        bits[bit].duration1 = (bit ? WS2812_T1L_NS : WS2812_T0L_NS) / INDICATOR_RMT_TICK_NS;
+    }
+    int item = 0;
+    for (int i = 0; i < NUMBER_OF_LEDS; i++) {
+        // GRB order, most significant bit first
+        const uint8_t channels[3] = {scale8(leds_[i].g, LED_BRIGHTNESS), scale8(leds_[i].r, LED_BRIGHTNESS),
+                                     scale8(leds_[i].b, LED_BRIGHTNESS)};
+        for (uint8_t channel : channels) {
+            for (int bit = 7; bit >= 0; bit--) {
+                frame_[item++] = bits[(channel >> bit) & 1];
+            }
+        }
+        shown_leds_[i] = leds_[i];
     }
-    FastLED.show();
-}
\ No newline at end of file
+    rmtWrite(rmt_, frame_, item);
+    is_frame_shown_ = true;
+}
+
+void Indicator::s_FrameTimerCallback(void* arg) {
+    Indicator* indicator = static_cast<Indicator*>(arg);
+    std::lock_guard<std::mutex> lock(indicator->effect_mutex_);
+    if (indicator->is_frame_timer_running_) {
+        indicator->Render();
+    }
+}
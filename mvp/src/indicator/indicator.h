@@ -1,8 +1,8 @@
 /**
  * @file indicator.h
  * @author Mahimana Bhatt (mahimanabhatt@gmail.com)
- * @brief Contains structure for RGB LED (COM 11821), uses FASTLed library for
- * controlling the LED
+ * @brief Contains structure for RGB LED (COM 11821), frames are sent by the
+ * RMT peripheral, FASTLed library is used for colors
  * @version 0.1
  * @date 2022-07-19
  *
@@ -13,9 +13,12 @@
 #ifndef _INDICATOR_INCLUDE_GUARD
 #define _INDICATOR_INCLUDE_GUARD
 
+#include <Arduino.h>
 #include <FastLED.h>
+#include <esp_timer.h>
 
 #include <memory>
+#include <mutex>
 
 #include "../config/config.h"
 #include "../logging/logging.h"
@@ -23,8 +26,8 @@
 class Indicator {
    public:
     /**
-   * @brief Fetches the LED pin from config, setups pin mode, setup WS2812
-   * RGBLED, initializes logger
+   * @brief Fetches the LED pin from config, setups the RMT channel for the
+   * WS2812 RGBLED and the frame timer, initializes logger
    *
    */
     Indicator(std::shared_ptr<Logging>& logging);
@@ -36,8 +39,8 @@ class Indicator {
     ~Indicator();
 
     /**
-   * @brief Updates the color of LED by using mapping from status to color of
-   * LED
+   * @brief Updates the effect of LED by using mapping from status to color and
+   * effect of LED, does nothing if the status did not change
    *
    * @param status: Device Status to be used for updation
    * @return true: if the updation was successful
@@ -45,15 +48,67 @@ class Indicator {
    */
     bool UpdateStatus(CONFIG_SET::DEVICE_STATUS status);
 
+    /**
+   * @brief Shows the blind position as progress bar in the operation or offline
+   * color, does nothing if the percentage did not change
+   *
+   * @param percentage: position to show, negative to show the status again
+   */
+    void UpdateProgress(int percentage);
+
    private:
     std::shared_ptr<Logging> logger_;
     CRGB leds_[CONFIG_SET::NUMBER_OF_LEDS];
+    CRGB shown_leds_[CONFIG_SET::NUMBER_OF_LEDS];
+    rmt_data_t frame_[CONFIG_SET::NUMBER_OF_LEDS * 24];
+    rmt_obj_t* rmt_ = NULL;
+    esp_timer_handle_t frame_timer_ = NULL;
+    bool is_frame_timer_running_ = false;
+    bool is_frame_shown_ = false;
+
+    // effect shared with the frame timer
+    std::mutex effect_mutex_;
+    bool is_status_set_ = false;
+    CONFIG_SET::DEVICE_STATUS status_;
+    int progress_ = -1;
+    CONFIG_SET::INDICATOR_EFFECT effect_ = CONFIG_SET::INDICATOR_EFFECT::SOLID;
+    CRGB color_;
+    int blink_count_ = 0;
+    int64_t effect_start_ms_ = 0;
 
     /**
    * @brief Initializes RGB LED
    *
    */
     void InitializeLED();
+
+    /**
+   * @brief Derives the effect from status and progress, runs the frame timer
+   * only for animated effects and renders the first frame, call with
+   * effect_mutex_ held
+   *
+   */
+    void StartEffect();
+
+    /**
+   * @brief Renders the current effect into leds_ and shows it, call with
+   * effect_mutex_ held
+   *
+   */
+    void Render();
+
+    /**
+   * @brief Sends leds_ to the LED through RMT if they differ from the shown
+   * frame
+   *
+   */
+    void Show();
+
+    /**
+   * @brief Frame timer callback, renders animated effects
+   *
+   */
+    static void s_FrameTimerCallback(void* arg);
 };
 
 #endif
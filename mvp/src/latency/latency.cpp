@@ -0,0 +1,155 @@
+/**
+ * @file latency.cpp
+ * @author Dhiraj Deshmukh (deshmukhdhiraj15@gmail.com)
+ * @brief Contains the latency histograms and their text format
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include "latency.h"
+
+#include <Arduino.h>
+
+#include <cstdio>
+
+#include "../config/config.h"
+#include "../monotonic_clock/monotonic_clock.h"
+
+LatencyHistogram Latency::s_histograms_[int(CONFIG_SET::LATENCY_PROBE::COUNT)];
+std::atomic<uint32_t> Latency::s_cpu_freq_mhz_{CONFIG_SET::POWER_ACTIVE_CPU_FREQ_MHZ};
+
+void LatencyHistogram::Add(uint32_t time_us) {
+    using namespace CONFIG_SET;
+    // 32 - leading zeros is the bit length, i.e. the power of two bucket
+    int bucket = time_us ? 32 - __builtin_clz(time_us) : 0;
+    bucket = bucket < LATENCY_BUCKET_COUNT ? bucket : LATENCY_BUCKET_COUNT - 1;
+    buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    uint32_t max_us = max_us_.load(std::memory_order_relaxed);
+    while (time_us > max_us && !max_us_.compare_exchange_weak(max_us, time_us, std::memory_order_relaxed)) {
+    }
+}
+
+void LatencyHistogram::Clear() {
+    for (std::atomic<uint32_t>& bucket : buckets_) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    count_.store(0, std::memory_order_relaxed);
+    max_us_.store(0, std::memory_order_relaxed);
+}
+
+uint32_t LatencyHistogram::GetCount() const {
+    return count_.load(std::memory_order_relaxed);
+}
+
+uint32_t LatencyHistogram::GetMax() const {
+    return max_us_.load(std::memory_order_relaxed);
+}
+
+uint32_t LatencyHistogram::GetBucket(int bucket) const {
+    return buckets_[bucket].load(std::memory_order_relaxed);
+}
+
+uint32_t LatencyHistogram::GetQuantileBound(float quantile) const {
+    using namespace CONFIG_SET;
+    // buckets are read one by one while samples come in, their sum is the
+    // consistent count here
+    uint32_t counts[LATENCY_BUCKET_COUNT];
+    uint32_t total = 0;
+    for (int i = 0; i < LATENCY_BUCKET_COUNT; i++) {
+        counts[i] = GetBucket(i);
+        total += counts[i];
+    }
+    if (total == 0) {
+        return 0;
+    }
+    uint32_t rank = uint32_t(quantile * total);
+    uint32_t seen = 0;
+    for (int i = 0; i < LATENCY_BUCKET_COUNT - 1; i++) {
+        seen += counts[i];
+        if (seen > rank) {
+            return uint32_t(1) << i;
+        }
+    }
+    return GetMax();
+}
+
+void Latency::Add(CONFIG_SET::LATENCY_PROBE probe, uint32_t time_us) {
+    s_histograms_[int(probe)].Add(time_us);
+}
+
+void Latency::AddCycles(CONFIG_SET::LATENCY_PROBE probe, uint32_t cycles) {
+    Add(probe, cycles / s_cpu_freq_mhz_.load(std::memory_order_relaxed));
+}
+
+void Latency::AddLateness(CONFIG_SET::LATENCY_PROBE probe, int64_t due_us) {
+    int64_t lateness_us = MonotonicClock::NowUs() - due_us;
+    if (lateness_us < 0) {
+        return;
+    }
+    Add(probe, lateness_us > INT32_MAX ? INT32_MAX : uint32_t(lateness_us));
+}
+
+void Latency::SetCpuFrequencyMhz(uint32_t cpu_freq_mhz) {
+    if (cpu_freq_mhz > 0) {
+        s_cpu_freq_mhz_.store(cpu_freq_mhz, std::memory_order_relaxed);
+    }
+}
+
+void Latency::Clear() {
+    for (LatencyHistogram& histogram : s_histograms_) {
+        histogram.Clear();
+    }
+}
+
+const LatencyHistogram& Latency::GetHistogram(CONFIG_SET::LATENCY_PROBE probe) {
+    return s_histograms_[int(probe)];
+}
+
+const char* Latency::GetName(CONFIG_SET::LATENCY_PROBE probe) {
+    using namespace CONFIG_SET;
+    switch (probe) {
+        case LATENCY_PROBE::CONTROLLER_HANDLE:
+            return "CONTROLLER_HANDLE";
+        case LATENCY_PROBE::CONTROLLER_LATENESS:
+            return "CONTROLLER_LATENESS";
+        case LATENCY_PROBE::MOTOR_HANDLER:
+            return "MOTOR_HANDLER";
+        case LATENCY_PROBE::MOTOR_LATENESS:
+            return "MOTOR_LATENESS";
+        case LATENCY_PROBE::BUTTON_ANALYSER:
+            return "BUTTON_ANALYSER";
+        case LATENCY_PROBE::BUTTON_LATENESS:
+            return "BUTTON_LATENESS";
+        case LATENCY_PROBE::CONNECTIVITY_RECONNECT:
+            return "CONNECTIVITY_RECONNECT";
+        case LATENCY_PROBE::CONNECTIVITY_LATENESS:
+            return "CONNECTIVITY_LATENESS";
+        case LATENCY_PROBE::FAUXMO_HANDLE:
+            return "FAUXMO_HANDLE";
+        case LATENCY_PROBE::LED_SHOW:
+            return "LED_SHOW";
+        case LATENCY_PROBE::UART_TRANSACTION:
+            return "UART_TRANSACTION";
+        default:
+            return "UNKNOWN";
+    }
+}
+
+std::string Latency::Format(CONFIG_SET::LATENCY_PROBE probe) {
+    using namespace CONFIG_SET;
+    const LatencyHistogram& histogram = GetHistogram(probe);
+    char line[96];
+    std::snprintf(line, sizeof(line), "%s n=%u p50<%u p90<%u p99<%u max=%u us |", GetName(probe),
+                  unsigned(histogram.GetCount()), unsigned(histogram.GetQuantileBound(0.50f)),
+                  unsigned(histogram.GetQuantileBound(0.90f)), unsigned(histogram.GetQuantileBound(0.99f)),
+                  unsigned(histogram.GetMax()));
+    std::string formatted(line);
+    for (int i = 0; i < LATENCY_BUCKET_COUNT; i++) {
+        formatted += " " + std::to_string(histogram.GetBucket(i));
+    }
+    return formatted;
+}
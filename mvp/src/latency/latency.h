@@ -0,0 +1,176 @@
+/**
+ * @file latency.h
+ * @author Mahimana Bhatt (mahimanabhatt@gmail.com)
+ * @brief Defines latency histograms of task iterations and sections, timed
+ * with the CPU cycle counter
+ *
+ * Every LATENCY_PROBE owns a histogram of LATENCY_BUCKET_COUNT power of two
+ * buckets in microseconds: bucket 0 counts samples below 1 us, bucket i
+ * samples from 2^(i-1) us up to 2^i us, the last bucket everything above.
+ * Recording is a few relaxed atomic increments without lock or allocation, so
+ * it is safe from any task and from interrupts and stays enabled in
+ * production.
+ *
+ * The *_LATENESS probes measure how late a task ran, i.e. from its deadline,
+ * the event it was woken for or the interrupt which woke it until it runs.
+ *
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef _LATENCY_INCLUDE_GUARD
+#define _LATENCY_INCLUDE_GUARD
+
+#include <Arduino.h>
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "../config/config.h"
+
+class LatencyHistogram {
+   public:
+    /**
+     * @brief Counts a sample
+     *
+     * @param time_us: sample in microseconds
+     */
+    void Add(uint32_t time_us);
+
+    /**
+     * @brief Drops all samples
+     *
+     */
+    void Clear();
+
+    /**
+     * @brief Returns the number of samples
+     *
+     */
+    uint32_t GetCount() const;
+
+    /**
+     * @brief Returns the largest sample in microseconds
+     *
+     */
+    uint32_t GetMax() const;
+
+    /**
+     * @brief Returns the number of samples in a bucket
+     *
+     */
+    uint32_t GetBucket(int bucket) const;
+
+    /**
+     * @brief Returns the upper bound of the bucket holding the given quantile
+     * of the samples, in microseconds, 0 if empty
+     *
+     * @param quantile: 0.0 - 1.0
+     */
+    uint32_t GetQuantileBound(float quantile) const;
+
+   private:
+    std::atomic<uint32_t> buckets_[CONFIG_SET::LATENCY_BUCKET_COUNT];
+    std::atomic<uint32_t> count_{0};
+    std::atomic<uint32_t> max_us_{0};
+};
+
+class Latency {
+   public:
+    /**
+     * @brief Counts a sample in microseconds
+     *
+     */
+    static void Add(CONFIG_SET::LATENCY_PROBE probe, uint32_t time_us);
+
+    /**
+     * @brief Counts a sample in CPU cycles
+     *
+     */
+    static void AddCycles(CONFIG_SET::LATENCY_PROBE probe, uint32_t cycles);
+
+    /**
+     * @brief Counts how late a task ran, nothing if it ran early
+     *
+     * @param due_us: MonotonicClock time the task should have run at
+     */
+    static void AddLateness(CONFIG_SET::LATENCY_PROBE probe, int64_t due_us);
+
+    /**
+     * @brief Sets the CPU frequency cycles are converted with, to be called
+     * whenever it is changed
+     *
+     */
+    static void SetCpuFrequencyMhz(uint32_t cpu_freq_mhz);
+
+    /**
+     * @brief Drops the samples of all probes
+     *
+     */
+    static void Clear();
+
+    /**
+     * @brief Returns the histogram of a probe
+     *
+     */
+    static const LatencyHistogram& GetHistogram(CONFIG_SET::LATENCY_PROBE probe);
+
+    /**
+     * @brief Returns the name of a probe
+     *
+     */
+    static const char* GetName(CONFIG_SET::LATENCY_PROBE probe);
+
+    /**
+     * @brief Formats one line for a probe: count, 50 / 90 / 99 percent bounds
+     * and maximum in microseconds, then the bucket counts
+     *
+     */
+    static std::string Format(CONFIG_SET::LATENCY_PROBE probe);
+
+   private:
+    static LatencyHistogram s_histograms_[int(CONFIG_SET::LATENCY_PROBE::COUNT)];
+    static std::atomic<uint32_t> s_cpu_freq_mhz_;
+};
+
+/**
+ * @brief Times its scope, or until Stop(), with the cycle counter
+ *
+ * A task may move to the other core, whose cycle counter is not in sync, such
+ * a sample is dropped.
+ *
+ */
+class LatencyTimer {
+   public:
+    explicit LatencyTimer(CONFIG_SET::LATENCY_PROBE probe)
+        : probe_(probe), core_(xPortGetCoreID()), start_cycles_(ESP.getCycleCount()) {}
+
+    ~LatencyTimer() { Stop(); }
+
+    /**
+     * @brief Records the time so far, once
+     *
+     */
+    void Stop() {
+        if (is_stopped_) {
+            return;
+        }
+        is_stopped_ = true;
+        uint32_t cycles = ESP.getCycleCount() - start_cycles_;
+        if (xPortGetCoreID() == core_) {
+            Latency::AddCycles(probe_, cycles);
+        }
+    }
+
+   private:
+    CONFIG_SET::LATENCY_PROBE probe_;
+    BaseType_t core_;
+    uint32_t start_cycles_;
+    bool is_stopped_ = false;
+};
+
+#endif
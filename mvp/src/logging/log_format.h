@@ -0,0 +1,109 @@
+/**
+ * @file log_format.h
+ * @author Mahimana Bhatt (mahimanabhatt@gmail.com)
+ * @brief Defines the compile-time ids of log format strings and the binary
+ * layout of log records, shared by the device and the decoder on the host
+ *
+ * LOG_FORMAT("...") stands for a format string at a log call. The compiler
+ * hashes the string into a 32 bit id and counts its conversions, only these
+ * two numbers reach the firmware, the string itself never does. The
+ * arguments are stored as raw binary, each one a LOG_ARG tag and its bytes,
+ * so nothing is formatted or allocated on the device.
+ *
+ * The drain task writes one record per line, LOG_FRAME_MARKER and the
+ * base64 of
+ *   type (1) | class (1) | id (4) | arguments | checksum (1)
+ * with numbers little endian and the checksum the XOR of all bytes before
+ * it. The decoder (host/decoder) finds the LOG_FORMAT literals in the
+ * sources, hashes them the same way and renders the lines, every other line
+ * passes through unchanged. Ids therefore only decode against the sources
+ * the firmware was built from.
+ *
+ * Format strings follow printf, without length modifiers, %s takes a
+ * character string.
+ *
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef _LOG_FORMAT_INCLUDE_GUARD
+#define _LOG_FORMAT_INCLUDE_GUARD
+
+#include <cstdint>
+
+namespace CONFIG_SET {
+
+// kept here rather than in config.h, so that the decoder builds without the
+// Arduino core
+enum class LOG_TYPE {
+    INFO,
+    ERROR,
+    WARN,
+};
+
+enum class LOG_CLASS {
+    CONTROLLER,
+    CONNECTIVITY,
+    INDICATOR,
+    LOGGING,
+    MANUAL_INTERACTION,
+    MOTOR_DRIVER,
+    STORAGE,
+    ALEXA_INTERACTION,
+    POWER_MANAGER,
+    LATENCY,
+};
+}  // namespace CONFIG_SET
+
+/**
+ * @brief Returns the 32 bit FNV-1a hash of a format string, the id of the
+ * format on the wire
+ *
+ */
+constexpr uint32_t LogFormatId(const char* format, uint32_t hash = 2166136261u) {
+    return *format ? LogFormatId(format + 1, (hash ^ uint8_t(*format)) * 16777619u) : hash;
+}
+
+/**
+ * @brief Returns the number of arguments a format string takes, i.e. its
+ * conversions without "%%"
+ *
+ */
+constexpr uint8_t LogFormatArgCount(const char* format) {
+    return !*format           ? 0
+           : *format != '%'   ? LogFormatArgCount(format + 1)
+           : format[1] == '%' ? LogFormatArgCount(format + 2)
+                              : 1 + LogFormatArgCount(format + 1);
+}
+
+/**
+ * @brief A format string reduced to its id and argument count, see
+ * LOG_FORMAT()
+ *
+ */
+template <uint32_t ID, uint8_t ARG_COUNT>
+struct LogFormat {};
+
+// the template arguments force both to be computed while compiling
+#define LOG_FORMAT(format) LogFormat<LogFormatId(format), LogFormatArgCount(format)>()
+
+/**
+ * @brief Tag in front of every argument of a record
+ *
+ */
+enum class LOG_ARG : uint8_t {
+    INT32,   // 4 bytes
+    UINT32,  // 4 bytes, also bool
+    INT64,   // 8 bytes
+    UINT64,  // 8 bytes
+    FLOAT,   // 4 bytes
+    DOUBLE,  // 8 bytes
+    STRING,  // length (1), then the characters without terminator
+};
+
+const char LOG_FRAME_MARKER = '#';  // first character of a record line
+
+#endif
@@ -13,79 +13,140 @@
 
 #include <Arduino.h>
 
-#include <mutex>
+#include <algorithm>
+#include <cstring>
 
 #include "../config/config.h"
-
-// mutex for locking access to status, to prevent updation and use of the
-// variable at the same time
+#include "../monotonic_clock/monotonic_clock.h"
 
 Logging::Logging(bool logging_status) : logging_status_(logging_status) {
     Serial.begin(CONFIG_SET::LOGGING_BAUD_RATE);
-    std::lock_guard<std::mutex> lock(status_mutex);
+    keep_draining_ = true;
+    drain_thread_.reset(new std::thread(&Logging::Drain, this));
 }
 
 Logging::~Logging() {
+    keep_draining_ = false;
+    WakeDrain();
+    drain_thread_->join();
     Serial.end();
 }
 
-bool Logging::Log(CONFIG_SET::LOG_TYPE log_type, CONFIG_SET::LOG_CLASS log_class, const char* message) {
-    std::lock_guard<std::mutex> lock(status_mutex);
-    if (logging_status_) {
-        switch (log_type) {
-            case CONFIG_SET::LOG_TYPE::INFO:
-                Serial.print("[INFO] ");
-                break;
-            case CONFIG_SET::LOG_TYPE::WARN:
-                Serial.print("[WARN] ");
-                break;
-            case CONFIG_SET::LOG_TYPE::ERROR:
-                Serial.print("[ERROR] ");
-                break;
-            default:
-                Serial.print("[INFO] ");
+bool Logging::s_PutArg(LOG_RECORD& record, const char* value) {
+    if (size_t(record.LENGTH) + 2 > sizeof(record.ARGS)) {
+        return false;
+    }
+    // cut to what is left of the record
+    size_t length = strnlen(value, std::min<size_t>(UINT8_MAX, sizeof(record.ARGS) - record.LENGTH - 2));
+    record.ARGS[record.LENGTH] = uint8_t(LOG_ARG::STRING);
+    record.ARGS[record.LENGTH + 1] = uint8_t(length);
+    memcpy(&record.ARGS[record.LENGTH + 2], value, length);
+    record.LENGTH += 2 + length;
+    return true;
+}
+
+void Logging::WakeDrain() {
+    // woken even when full, so that the drop is reported soon
+    TaskHandle_t drain_task = drain_task_;
+    if (drain_task != NULL) {
+        xTaskNotifyGive(drain_task);
+    }
+}
+
+void Logging::Drain() {
+    using namespace CONFIG_SET;
+    vTaskPrioritySet(NULL, LOG_DRAIN_TASK_PRIORITY);
+    // records queued before the handle is set are written by the first pass
+    drain_task_ = xTaskGetCurrentTaskHandle();
+    uint32_t reported_dropped_count = 0;
+    while (true) {
+        LOG_RECORD record;
+        while (records_.Pop(record)) {
+            Write(record);
+            written_count_.fetch_add(1, std::memory_order_release);
+        }
+        uint32_t dropped_count = records_.GetDroppedCount();
+        if (dropped_count != reported_dropped_count) {
+            s_FillRecord(record, LOG_TYPE::WARN, LOG_CLASS::LOGGING,
+                         LOG_FORMAT("Dropped %u messages, the log ring was full"),
+                         dropped_count - reported_dropped_count);
+            Write(record);
+            reported_dropped_count = dropped_count;
+        }
+        TaskHandle_t flush_task = flush_task_;
+        if (flush_task != NULL) {
+            xTaskNotifyGive(flush_task);
         }
-        switch (log_class) {
-            case CONFIG_SET::LOG_CLASS::CONTROLLER:
-                Serial.print("[CONTROLLER] ");
-                break;
-            case CONFIG_SET::LOG_CLASS::CONNECTIVITY:
-                Serial.print("[CONNECTIVITY] ");
-                break;
-            case CONFIG_SET::LOG_CLASS::INDICATOR:
-                Serial.print("[INDICATOR] ");
-                break;
-            case CONFIG_SET::LOG_CLASS::LOGGING:
-                Serial.print("[LOGGING] ");
-                break;
-            case CONFIG_SET::LOG_CLASS::MANUAL_INTERACTION:
-                Serial.print("[MANUAL_INTERACTION] ");
-                break;
-            case CONFIG_SET::LOG_CLASS::MOTOR_DRIVER:
-                Serial.print("[MOTOR_DRIVER] ");
-                break;
-            case CONFIG_SET::LOG_CLASS::STORAGE:
-                Serial.print("[STORAGE] ");
-                break;
-            case CONFIG_SET::LOG_CLASS::ALEXA_INTERACTION:
-                Serial.print("[ALEXA_INTERACTION] ");
-                break;
-            default:
-                Serial.print("[LOGGING] ");
+        // checked after the pass, so that everything queued before the stop
+        // is written
+        if (!keep_draining_) {
+            break;
         }
-        Serial.println(message);
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
     }
+    drain_task_ = NULL;
 }
 
-bool Logging::Log(CONFIG_SET::LOG_TYPE log_type, CONFIG_SET::LOG_CLASS log_class, String message) {
-    Log(log_type, log_class, message.c_str());
+void Logging::Flush() {
+    uint32_t pushed_count = records_.GetPushedCount();
+    int64_t deadline_ms = MonotonicClock::NowMs() + CONFIG_SET::LOG_FLUSH_TIMEOUT_MS;
+    // set before the count is checked, so that a pass finishing in between
+    // still leaves a notification to take
+    flush_task_ = xTaskGetCurrentTaskHandle();
+    WakeDrain();
+    while (int32_t(written_count_.load(std::memory_order_acquire) - pushed_count) < 0) {
+        int64_t remaining_ms = deadline_ms - MonotonicClock::NowMs();
+        if (remaining_ms <= 0) {
+            break;
+        }
+        // woken by the drain task after every pass
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(remaining_ms));
+    }
+    flush_task_ = NULL;
+}
+
+void Logging::Write(const LOG_RECORD& record) {
+    static const char s_base64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    // type, class, id, arguments, checksum
+    uint8_t frame[2 + sizeof(record.ID) + sizeof(record.ARGS) + 1];
+    size_t frame_length = 0;
+    frame[frame_length++] = uint8_t(record.TYPE);
+    frame[frame_length++] = uint8_t(record.CLASS);
+    memcpy(&frame[frame_length], &record.ID, sizeof(record.ID));
+    frame_length += sizeof(record.ID);
+    memcpy(&frame[frame_length], record.ARGS, record.LENGTH);
+    frame_length += record.LENGTH;
+    uint8_t checksum = 0;
+    for (size_t i = 0; i < frame_length; i++) {
+        checksum ^= frame[i];
+    }
+    frame[frame_length++] = checksum;
+
+    // marker, 4 characters per 3 bytes, new line
+    char line[1 + (sizeof(frame) + 2) / 3 * 4 + 1];
+    size_t line_length = 0;
+    line[line_length++] = LOG_FRAME_MARKER;
+    for (size_t i = 0; i < frame_length; i += 3) {
+        uint32_t bits = uint32_t(frame[i]) << 16;
+        bits |= i + 1 < frame_length ? uint32_t(frame[i + 1]) << 8 : 0;
+        bits |= i + 2 < frame_length ? uint32_t(frame[i + 2]) : 0;
+        line[line_length++] = s_base64[(bits >> 18) & 0x3F];
+        line[line_length++] = s_base64[(bits >> 12) & 0x3F];
+        line[line_length++] = i + 1 < frame_length ? s_base64[(bits >> 6) & 0x3F] : '=';
+        line[line_length++] = i + 2 < frame_length ? s_base64[bits & 0x3F] : '=';
+    }
+    line[line_length++] = '\n';
+    Serial.write(reinterpret_cast<const uint8_t*>(line), line_length);
 }
 
 void Logging::SetLoggingStatus(bool status) {
-    std::lock_guard<std::mutex> lock(status_mutex);
     logging_status_ = status;
 }
 
 bool Logging::GetLoggingStatus() {
     return logging_status_;
 }
+
+uint32_t Logging::GetDroppedCount() {
+    return records_.GetDroppedCount();
+}
@@ -2,6 +2,14 @@
  * @file logging.h
  * @author Mahimana Bhatt (mahimanabhatt@gmail.com)
  * @brief Defines code structure for logging of device
+ *
+ * Log() only stores the id of its LOG_FORMAT() and the raw arguments into a
+ * preallocated record of a lock-free ring and wakes the drain task, which
+ * writes the records to the serial port at a priority below every other
+ * task, see log_format.h for the format on the wire. A full ring drops the
+ * record and the drain task reports how many were dropped, so a log call
+ * never formats, allocates or waits for the serial port or another task.
+ *
  * @version 0.1
  * @date 2022-07-19
  *
@@ -14,43 +22,76 @@
 
 #include <Arduino.h>
 
-#include <mutex>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <type_traits>
 
 #include "../config/config.h"
+#include "../mpsc_ring/mpsc_ring.h"
+#include "log_format.h"
+
+/**
+ * @brief One queued log message, the arguments which do not fit into ARGS
+ * are left out
+ *
+ */
+struct LOG_RECORD {
+    CONFIG_SET::LOG_TYPE TYPE;
+    CONFIG_SET::LOG_CLASS CLASS;
+    uint32_t ID;
+    uint8_t LENGTH;  // bytes of ARGS in use
+    uint8_t ARGS[CONFIG_SET::LOG_ARGS_LENGTH];
+};
 
 class Logging {
    public:
     /**
    * @brief Construct a new Logging object, initializes the serial connection
+   * and starts the drain task
    *
    */
     Logging(bool logging_status);
 
     /**
-   * @brief Destroy the Logging object
+   * @brief Destroy the Logging object, writes the queued records and stops the
+   * drain task
    *
    */
     ~Logging();
 
     /**
-   * @brief For now, the function will just print a message on serial, it can be
-   * over wifi or just hardware serial
+   * @brief Queues a message for the drain task, which writes it on serial, it
+   * can be over wifi or just hardware serial
+   *
+   * e.g. Log(LOG_TYPE::INFO, LOG_CLASS::CONTROLLER, LOG_FORMAT("At %d"), step)
    *
-   * @param message
-   * @return true : if the print is successful
-   * @return false : otherwise
+   * @param format: LOG_FORMAT() of a string literal
+   * @param args: integers, floating point numbers or strings, one per
+   * conversion of the format
+   * @return true : if the message is queued
+   * @return false : if logging is disabled or the ring is full
    */
-    bool Log(CONFIG_SET::LOG_TYPE log_type, CONFIG_SET::LOG_CLASS log_class, const char* message);
+    template <uint32_t ID, uint8_t ARG_COUNT, typename... ARGS>
+    bool Log(CONFIG_SET::LOG_TYPE log_type, CONFIG_SET::LOG_CLASS log_class, LogFormat<ID, ARG_COUNT> format,
+             const ARGS&... args) {
+        if (!logging_status_) {
+            return false;
+        }
+        bool is_queued =
+            records_.Push([&](LOG_RECORD& record) { s_FillRecord(record, log_type, log_class, format, args...); });
+        WakeDrain();
+        return is_queued;
+    }
 
     /**
-   * @brief For now, the function will just print a message on serial, it can be
-   * over wifi or just hardware serial
+   * @brief Waits, up to LOG_FLUSH_TIMEOUT_MS, until the drain task wrote every
+   * message queued so far, e.g. before a restart. Blocks on a notification of
+   * the drain task, only one task may flush at a time
    *
-   * @param message
-   * @return true : if the print is successful
-   * @return false : otherwise
    */
-    bool Log(CONFIG_SET::LOG_TYPE log_type, CONFIG_SET::LOG_CLASS log_class, String message);
+    void Flush();
 
     /**
    * @brief This function enables or disables logging
@@ -66,9 +107,104 @@ class Logging {
    */
     bool GetLoggingStatus();
 
+    /**
+   * @brief Returns the number of messages dropped because the ring was full
+   *
+   */
+    uint32_t GetDroppedCount();
+
    private:
-    bool logging_status_;
-    std::mutex status_mutex;
+    /**
+   * @brief Fills a record with a message
+   *
+   */
+    template <uint32_t ID, uint8_t ARG_COUNT, typename... ARGS>
+    static void s_FillRecord(LOG_RECORD& record, CONFIG_SET::LOG_TYPE log_type, CONFIG_SET::LOG_CLASS log_class,
+                             LogFormat<ID, ARG_COUNT>, const ARGS&... args) {
+        static_assert(sizeof...(ARGS) == ARG_COUNT, "Log arguments do not match the conversions of the format");
+        record.TYPE = log_type;
+        record.CLASS = log_class;
+        record.ID = ID;
+        record.LENGTH = 0;
+        s_PutArgs(record, args...);
+    }
+
+    /**
+   * @brief Appends the arguments to a record, up to the first which does not
+   * fit
+   *
+   */
+    static void s_PutArgs(LOG_RECORD&) {}
+
+    template <typename T, typename... REST>
+    static void s_PutArgs(LOG_RECORD& record, const T& value, const REST&... rest) {
+        if (s_PutArg(record, value)) {
+            s_PutArgs(record, rest...);
+        }
+    }
+
+    /**
+   * @brief Appends one argument to a record
+   *
+   * @return true : if it fits
+   * @return false : otherwise, the record is left as it was
+   */
+    template <typename T>
+    static typename std::enable_if<std::is_integral<T>::value, bool>::type s_PutArg(LOG_RECORD& record, T value) {
+        if (sizeof(T) > sizeof(uint32_t)) {
+            return std::is_signed<T>::value ? s_PutValue(record, LOG_ARG::INT64, int64_t(value))
+                                            : s_PutValue(record, LOG_ARG::UINT64, uint64_t(value));
+        }
+        return std::is_signed<T>::value ? s_PutValue(record, LOG_ARG::INT32, int32_t(value))
+                                        : s_PutValue(record, LOG_ARG::UINT32, uint32_t(value));
+    }
+
+    static bool s_PutArg(LOG_RECORD& record, float value) { return s_PutValue(record, LOG_ARG::FLOAT, value); }
+
+    static bool s_PutArg(LOG_RECORD& record, double value) { return s_PutValue(record, LOG_ARG::DOUBLE, value); }
+
+    static bool s_PutArg(LOG_RECORD& record, const char* value);
+
+    static bool s_PutArg(LOG_RECORD& record, const String& value) { return s_PutArg(record, value.c_str()); }
+
+    template <typename T>
+    static bool s_PutValue(LOG_RECORD& record, LOG_ARG tag, T value) {
+        if (record.LENGTH + 1 + sizeof(T) > sizeof(record.ARGS)) {
+            return false;
+        }
+        record.ARGS[record.LENGTH] = uint8_t(tag);
+        memcpy(&record.ARGS[record.LENGTH + 1], &value, sizeof(T));
+        record.LENGTH += 1 + sizeof(T);
+        return true;
+    }
+
+    /**
+   * @brief Wakes the drain task, if it runs
+   *
+   */
+    void WakeDrain();
+
+    /**
+   * @brief Drain task, writes the queued records whenever woken until
+   * keep_draining_ is cleared
+   *
+   */
+    void Drain();
+
+    /**
+   * @brief Writes one record on serial as a line of base64
+   *
+   */
+    void Write(const LOG_RECORD& record);
+
+    std::atomic<bool> logging_status_;
+    MpscRing<LOG_RECORD, CONFIG_SET::LOG_RING_CAPACITY> records_;
+    // records written by the drain task, compared with the pushed count
+    std::atomic<uint32_t> written_count_{0};
+    std::atomic<bool> keep_draining_{false};
+    std::atomic<TaskHandle_t> drain_task_{NULL};
+    std::atomic<TaskHandle_t> flush_task_{NULL};  // notified after every pass of the drain task
+    std::unique_ptr<std::thread> drain_thread_;
 };
 
 #endif
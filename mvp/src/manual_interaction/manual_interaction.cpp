@@ -13,42 +13,85 @@
 #include "manual_interaction.h"
 
 #include <Arduino.h>
+#include <driver/gpio.h>
 
+#include <algorithm>
 #include <chrono>
-#include <deque>
 #include <memory>
-#include <mutex>
 #include <new>
 #include <tuple>
 #include <utility>
 
 #include "../config/config.h"
+#include "../event_queue/event_queue.h"
+#include "../latency/latency.h"
 #include "../logging/logging.h"
+#include "../monotonic_clock/monotonic_clock.h"
+#include "../motor_driver/motor_driver.h"
 
 bool ManualInteraction::s_class_setup_flag_ = false;
-std::deque<std::pair<bool, CONFIG_SET::time_var>> ManualInteraction::s_button_state_deque_up_;
-std::deque<std::pair<bool, CONFIG_SET::time_var>> ManualInteraction::s_button_state_deque_down_;
-std::mutex ManualInteraction::s_deque_mutex_;
-
-ManualInteraction::ManualInteraction(int freq_to_run_deque_analyser, std::shared_ptr<Logging>& logging)
-    : freq_to_run_deque_analyser_(freq_to_run_deque_analyser), logger_(logging) {
+TaskHandle_t ManualInteraction::s_analyser_task_ = NULL;
+SpscRing<ManualInteraction::BUTTON_EDGE, CONFIG_SET::BUTTON_EDGE_RING_CAPACITY> ManualInteraction::s_button_edges_;
+Debouncer ManualInteraction::s_debouncers_[2];
+const int ManualInteraction::s_button_pins_[2] = {CONFIG_SET::PIN_BUTTON_UP, CONFIG_SET::PIN_BUTTON_DOWN};
+hw_timer_t* ManualInteraction::s_sample_timer_ = NULL;
+
+// rows are GESTURE_STATE, columns GESTURE_INPUT: PRESS, RELEASE, RELEASE_ALL, TIMEOUT
+const ManualInteraction::GESTURE_TRANSITION
+    ManualInteraction::s_gesture_transitions_[int(GESTURE_STATE::COUNT)][int(GESTURE_INPUT::COUNT)] = {
+        // IDLE
+        {{GESTURE_STATE::PRESSED, GESTURE_STEP::START},
+         {GESTURE_STATE::IDLE, GESTURE_STEP::NONE},
+         {GESTURE_STATE::IDLE, GESTURE_STEP::NONE},
+         {GESTURE_STATE::IDLE, GESTURE_STEP::NONE}},
+        // PRESSED
+        {{GESTURE_STATE::PRESSED, GESTURE_STEP::JOIN},
+         {GESTURE_STATE::PRESSED, GESTURE_STEP::NONE},
+         {GESTURE_STATE::RELEASED, GESTURE_STEP::TAP},
+         {GESTURE_STATE::HELD, GESTURE_STEP::HOLD}},
+        // RELEASED
+        {{GESTURE_STATE::PRESSED, GESTURE_STEP::NEXT_TAP},
+         {GESTURE_STATE::RELEASED, GESTURE_STEP::NONE},
+         {GESTURE_STATE::RELEASED, GESTURE_STEP::NONE},
+         {GESTURE_STATE::IDLE, GESTURE_STEP::END_TAPS}},
+        // HELD
+        {{GESTURE_STATE::PRESSED, GESTURE_STEP::REGRIP},
+         {GESTURE_STATE::HELD, GESTURE_STEP::NONE},
+         {GESTURE_STATE::IDLE, GESTURE_STEP::END_HOLD},
+         {GESTURE_STATE::HELD, GESTURE_STEP::NONE}},
+};
+
+ManualInteraction::ManualInteraction(std::shared_ptr<Logging>& logging, std::shared_ptr<EventQueue> event_queue)
+    : logger_(logging), event_queue_(event_queue) {
 
     // Importing namespace for config
     using namespace CONFIG_SET;
 
-    logger_->Log(LOG_TYPE::INFO, LOG_CLASS::MANUAL_INTERACTION, "Manual Interaction intilization started");
+    logger_->Log(LOG_TYPE::INFO, LOG_CLASS::MANUAL_INTERACTION, LOG_FORMAT("Manual Interaction intilization started"));
     if (s_class_setup_flag_ == false) {
         pinMode(PIN_BUTTON_UP, INPUT);
         pinMode(PIN_BUTTON_DOWN, INPUT);
-        attachInterrupt(digitalPinToInterrupt(PIN_BUTTON_UP), s_IntrAddToButtonDequeUp, CHANGE);
-        attachInterrupt(digitalPinToInterrupt(PIN_BUTTON_DOWN), s_IntrAddToButtonDequeDown, CHANGE);
+        // interrupts are not attached yet, nothing produces into the ring
+        BUTTON_EDGE edge;
+        while (s_button_edges_.Pop(edge)) {
+        }
+        for (Debouncer& debouncer : s_debouncers_) {
+            debouncer = Debouncer(BUTTON_DEBOUNCE_SAMPLES, false);
+        }
+        s_sample_timer_ = timerBegin(BUTTON_SAMPLE_TIMER_ID, BUTTON_SAMPLE_TIMER_PRESCALER, true);
+        timerAttachInterrupt(s_sample_timer_, &s_IntrSampleButtons, true);
+        timerAlarmWrite(s_sample_timer_, BUTTON_SAMPLE_INTERVAL_US, true);
+        attachInterrupt(digitalPinToInterrupt(PIN_BUTTON_UP), s_IntrButtonChange, CHANGE);
+        attachInterrupt(digitalPinToInterrupt(PIN_BUTTON_DOWN), s_IntrButtonChange, CHANGE);
+        // a button held since power on comes in as a press
+        s_StartSampling();
         StartButtonDequeAnalyserFn();
         s_class_setup_flag_ = true;
-        delay_to_run_deque_analyser_ = 1000 / 2;
-        logger_->Log(LOG_TYPE::INFO, LOG_CLASS::MANUAL_INTERACTION, "Manual Interaction intilization completed");
+        logger_->Log(LOG_TYPE::INFO, LOG_CLASS::MANUAL_INTERACTION,
+                     LOG_FORMAT("Manual Interaction intilization completed"));
     } else {
         logger_->Log(LOG_TYPE::INFO, LOG_CLASS::MANUAL_INTERACTION,
-                     "s_class_setup_flag_ = true did not initialize Manual Interaction");
+                     LOG_FORMAT("s_class_setup_flag_ = true did not initialize Manual Interaction"));
     }
 }
 
@@ -56,56 +99,100 @@ ManualInteraction::~ManualInteraction() {
     // Importing namespace for config
     using namespace CONFIG_SET;
 
-    logger_->Log(LOG_TYPE::INFO, LOG_CLASS::MANUAL_INTERACTION, "Manual Interaction object destroyed");
+    logger_->Log(LOG_TYPE::INFO, LOG_CLASS::MANUAL_INTERACTION, LOG_FORMAT("Manual Interaction object destroyed"));
     StopButtonDequeAnalyserFn();
+    if (!deque_analyser_) {
+        return;
+    }
+    // only the instance which did the setup owns the interrupts and the analyser
+    detachInterrupt(digitalPinToInterrupt(PIN_BUTTON_UP));
+    detachInterrupt(digitalPinToInterrupt(PIN_BUTTON_DOWN));
+    // after the buttons, which start the timer
+    timerAlarmDisable(s_sample_timer_);
+    timerDetachInterrupt(s_sample_timer_);
+    timerEnd(s_sample_timer_);
+    s_sample_timer_ = NULL;
+    deque_analyser_->join();
+    deque_analyser_.reset();
+    s_class_setup_flag_ = false;
+}
+
+void IRAM_ATTR ManualInteraction::s_IntrButtonChange() {
+    s_StartSampling();
 }
 
-void ManualInteraction::s_IntrAddToButtonDequeUp() {
+void IRAM_ATTR ManualInteraction::s_StartSampling() {
     // Importing namespace for config
     using namespace CONFIG_SET;
 
-    // setting a mutex lock and reading current button state
-    std::lock_guard<std::mutex> lock(s_deque_mutex_);
-    int state = digitalRead(PIN_BUTTON_UP);
-
-    if (s_button_state_deque_up_.empty()) {
-        // checking for condition of empty deque
-        s_button_state_deque_up_.push_back(std::make_pair(state, current_time::now()));
-    } else if ((std::chrono::duration_cast<std::chrono::milliseconds>(current_time::now() -
-                                                                      s_button_state_deque_up_.back().second)
-                    .count() > 50) &&
-               (s_button_state_deque_up_.back().first != state)) {
-        // current state is not same as previous state and for
-        // debouncing time
-        s_button_state_deque_up_.push_back(std::make_pair(state, current_time::now()));
+    for (int pin : s_button_pins_) {
+        gpio_intr_disable(static_cast<gpio_num_t>(pin));
     }
+    timerWrite(s_sample_timer_, 0);
+    timerAlarmEnable(s_sample_timer_);
 }
 
-void ManualInteraction::s_IntrAddToButtonDequeDown() {
+void IRAM_ATTR ManualInteraction::s_IntrSampleButtons() {
     // Importing namespace for config
     using namespace CONFIG_SET;
 
-    // setting a mutex lock and reading current button state
-    std::lock_guard<std::mutex> lock(s_deque_mutex_);
-    int state = digitalRead(PIN_BUTTON_DOWN);
-
-    if (s_button_state_deque_down_.empty()) {
-        s_button_state_deque_down_.push_back(
-            // checking for condition of empty deque
-            std::make_pair(state, current_time::now()));
-    } else if ((std::chrono::duration_cast<std::chrono::milliseconds>(current_time::now() -
-                                                                      s_button_state_deque_down_.back().second)
-                    .count() > 50) &&
-               (s_button_state_deque_down_.back().first != state)) {
-        s_button_state_deque_down_.push_back(
-            // current state is not same as previous state and for debouncing time
-            std::make_pair(state, current_time::now()));
+    // no lock and no allocation, the analyser drains the ring
+    uint32_t time_us = uint32_t(MonotonicClock::NowUs());
+    bool has_edges = false;
+    bool is_settled = true;
+    for (int button = 0; button < 2; button++) {
+        Debouncer& debouncer = s_debouncers_[button];
+        if (debouncer.Sample(digitalRead(s_button_pins_[button]), time_us)) {
+            BUTTON_EDGE edge;
+            edge.TIME_US = debouncer.GetEdgeTime();
+            edge.PIN = s_button_pins_[button];
+            edge.LEVEL = debouncer.GetLevel();
+            s_button_edges_.Push(edge);
+            has_edges = true;
+        }
+        is_settled = is_settled && debouncer.IsSettled();
+    }
+
+    if (is_settled) {
+        // back to the button interrupts, a change they missed while disabled
+        // keeps the timer sampling. The analyser re-arms their level for the
+        // edges of this run, a level it did not re-arm yet only fires another
+        // run of sampling without an edge
+        bool has_changed = false;
+        for (int button = 0; button < 2; button++) {
+            int pin = s_button_pins_[button];
+            gpio_intr_enable(static_cast<gpio_num_t>(pin));
+            has_changed = has_changed || bool(digitalRead(pin)) != s_debouncers_[button].GetLevel();
+        }
+        if (has_changed) {
+            s_StartSampling();
+        } else {
+            timerAlarmDisable(s_sample_timer_);
+        }
+    }
+
+    TaskHandle_t analyser_task = s_analyser_task_;
+    if (!has_edges || analyser_task == NULL) {
+        return;
+    }
+    BaseType_t higher_priority_task_woken = pdFALSE;
+    vTaskNotifyGiveFromISR(analyser_task, &higher_priority_task_woken);
+    if (higher_priority_task_woken) {
+        portYIELD_FROM_ISR();
     }
 }
 
+void ManualInteraction::s_ArmWakeUp(int pin, int state) {
+    gpio_wakeup_enable(static_cast<gpio_num_t>(pin), state ? GPIO_INTR_LOW_LEVEL : GPIO_INTR_HIGH_LEVEL);
+}
+
 void ManualInteraction::StopButtonDequeAnalyserFn() {
     // set the flag to stop the ButtonstateDequeAnalyser function
     stop_button_deque_analyser_ = false;
+    TaskHandle_t analyser_task = s_analyser_task_;
+    if (deque_analyser_ && analyser_task != NULL) {
+        xTaskNotifyGive(analyser_task);
+    }
 }
 
 void ManualInteraction::StartButtonDequeAnalyserFn() {
@@ -115,7 +202,7 @@ void ManualInteraction::StartButtonDequeAnalyserFn() {
     // starts the ButtonstateDequeAnalyser function in a thread
     deque_analyser_.reset(new std::thread(&ManualInteraction::ButtonstateDequeAnalyser, this));
     logger_->Log(LOG_TYPE::INFO, LOG_CLASS::MANUAL_INTERACTION,
-                 "Manual interaction class function to analyse button press started");
+                 LOG_FORMAT("Manual interaction class function to analyse button press started"));
 }
 
 std::tuple<CONFIG_SET::MANUAL_PUSH, CONFIG_SET::time_var> ManualInteraction::GetManualActionAndTime() {
@@ -135,117 +222,174 @@ std::tuple<CONFIG_SET::MANUAL_PUSH, CONFIG_SET::time_var> ManualInteraction::Get
     return return_manual_action_and_time;
 }
 
-void ManualInteraction::ButtonstateDequeAnalyser() {
+CONFIG_SET::MANUAL_PUSH ManualInteraction::s_FindGesture(uint8_t buttons, uint8_t taps) {
     // Importing namespace for config
     using namespace CONFIG_SET;
 
-    // Declaring variables to hold button states
-    // [0->NO_PUSH,1->LONG_PRESS,2->DOUBLE_TAP] and time the state was
-    // trigerred
-    BUTTON_PRESS button_1_state = BUTTON_PRESS::NO_PUSH;
-    BUTTON_PRESS button_2_state = BUTTON_PRESS::NO_PUSH;
-    time_var time_button_1 = current_time::now();
-    time_var time_button_2 = current_time::now();
+    for (const GESTURE& gesture : GESTURE_TABLE) {
+        if (gesture.BUTTONS == buttons && gesture.TAPS == taps) {
+            return gesture.ACTION;
+        }
+    }
+    return MANUAL_PUSH::NO_PUSH;
+}
 
-    // Continous loop until the deuqe analyser flag is true
-    while (stop_button_deque_analyser_) {
-        time_var function_start_time = current_time::now();
+bool ManualInteraction::s_HasMoreTaps(uint8_t buttons, uint8_t taps) {
+    // Importing namespace for config
+    using namespace CONFIG_SET;
 
-        // calling  function to queue for up button
-        if (!s_button_state_deque_up_.empty()) {
-            SetCurrentButtonState(s_button_state_deque_up_, button_1_state, time_button_1);
-        }
-        // calling  function to queue for down button
-        if (!s_button_state_deque_down_.empty()) {
-            SetCurrentButtonState(s_button_state_deque_down_, button_2_state, time_button_2);
+    for (const GESTURE& gesture : GESTURE_TABLE) {
+        if (gesture.BUTTONS == buttons && gesture.TAPS > taps) {
+            return true;
         }
+    }
+    return false;
+}
 
-        // calling function to set manual action based on button states
-        SetManualActionAndTime(button_1_state, button_2_state, time_button_1, time_button_2);
+void ManualInteraction::ButtonstateDequeAnalyser() {
+    // Importing namespace for config
+    using namespace CONFIG_SET;
 
-        time_var function_end_time = current_time::now();
+    // set before the flag is checked, so that a stop always wakes the loop
+    s_analyser_task_ = xTaskGetCurrentTaskHandle();
+    // released, as the debouncers start, a press since comes in as an edge
+    for (int pin : s_button_pins_) {
+        s_ArmWakeUp(pin, false);
+    }
 
-        int execution_time =
-            std::chrono::duration_cast<std::chrono::milliseconds>(function_end_time - function_start_time).count();
+    // Continous loop until the deuqe analyser flag is true
+    while (stop_button_deque_analyser_) {
+        {
+            LatencyTimer analyser_timer(LATENCY_PROBE::BUTTON_ANALYSER);
+            HandleButtonEdges();
+        }
 
-        // non-blocking delay for running loop 2HZ
-        if (execution_time < delay_to_run_deque_analyser_) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(delay_to_run_deque_analyser_ - execution_time));
+        // sleeps until the next edge, or the next gesture timeout
+        TickType_t ticks = portMAX_DELAY;
+        if (gesture_deadline_us_ >= 0) {
+            int64_t remaining_us = std::max<int64_t>(gesture_deadline_us_ - MonotonicClock::NowUs(), 0);
+            // rounded up, waking before the deadline would only sleep again
+            ticks = TickType_t((remaining_us + portTICK_PERIOD_MS * 1000 - 1) / (portTICK_PERIOD_MS * 1000));
         }
+        ulTaskNotifyTake(pdTRUE, ticks);
     }
+    s_analyser_task_ = NULL;
 }
 
-void ManualInteraction::SetCurrentButtonState(std::deque<std::pair<bool, CONFIG_SET::time_var>>& button_press_deque_,
-                                              CONFIG_SET::BUTTON_PRESS& button_state, CONFIG_SET::time_var& time) {
+void ManualInteraction::HandleButtonEdges() {
     // Importing namespace for config
     using namespace CONFIG_SET;
 
-    std::lock_guard<std::mutex> lock(s_deque_mutex_);
-    // check if button_1 long is pressed:
-    if (button_press_deque_.back().first == 1 &&
-        std::chrono::duration_cast<std::chrono::milliseconds>(current_time::now() - button_press_deque_.back().second)
-                .count() > 1100) {
-        button_state = BUTTON_PRESS::LONG_PRESS;
-        time = button_press_deque_.back().second;
-        button_press_deque_.clear();
-    }
-
-    // check if long press was cleared
-    if (button_state == BUTTON_PRESS::LONG_PRESS && button_press_deque_.size() > 0) {
-        time = button_press_deque_.front().second;
-        button_press_deque_.pop_front();
-        button_state = BUTTON_PRESS::NO_PUSH;
-    }
-
-    // Check if double press was in the queue
-    while (button_press_deque_.size() >= 4) {
-        if (std::chrono::duration_cast<std::chrono::milliseconds>(button_press_deque_[3].second -
-                                                                  button_press_deque_.front().second)
-                .count() < 1000) {
-            time = button_press_deque_.front().second;
-            button_press_deque_.erase(button_press_deque_.begin(), button_press_deque_.begin() + 4);
-            button_state = BUTTON_PRESS::DOUBLE_TAP;
+    int64_t now_us = MonotonicClock::NowUs();
+    BUTTON_EDGE edge;
+    while (s_button_edges_.Pop(edge)) {
+        // the 32 bit time wraps around every 71 minutes, edges are far younger
+        int64_t time_us = now_us - int64_t(uint32_t(now_us) - edge.TIME_US);
+        Latency::AddLateness(LATENCY_PROBE::BUTTON_LATENESS, time_us);
+        // a timeout which came before the edge happened first
+        while (gesture_deadline_us_ >= 0 && gesture_deadline_us_ <= time_us) {
+            RunGesture(GESTURE_INPUT::TIMEOUT, 0, gesture_deadline_us_);
+        }
+        // here rather than in the sampling interrupt, gpio_wakeup_enable() is
+        // not in IRAM, and this task runs before the idle task can sleep
+        s_ArmWakeUp(edge.PIN, edge.LEVEL);
+        uint8_t button = edge.PIN == PIN_BUTTON_UP ? GESTURE_BUTTON_UP : GESTURE_BUTTON_DOWN;
+        GESTURE_INPUT input = GESTURE_INPUT::PRESS;
+        if (edge.LEVEL) {
+            buttons_down_ |= button;
         } else {
-            button_press_deque_.erase(button_press_deque_.begin(), button_press_deque_.begin() + 2);
+            buttons_down_ &= ~button;
+            input = buttons_down_ ? GESTURE_INPUT::RELEASE : GESTURE_INPUT::RELEASE_ALL;
         }
+        RunGesture(input, button, time_us);
+    }
+    while (gesture_deadline_us_ >= 0 && gesture_deadline_us_ <= now_us) {
+        Latency::AddLateness(LATENCY_PROBE::BUTTON_LATENESS, gesture_deadline_us_);
+        RunGesture(GESTURE_INPUT::TIMEOUT, 0, gesture_deadline_us_);
+    }
+
+    uint32_t dropped_count = s_button_edges_.GetDroppedCount();
+    if (dropped_count != reported_dropped_count_) {
+        logger_->Log(LOG_TYPE::WARN, LOG_CLASS::MANUAL_INTERACTION, LOG_FORMAT("Button edges dropped: %u"),
+                     dropped_count - reported_dropped_count_);
+        reported_dropped_count_ = dropped_count;
     }
 }
 
-void ManualInteraction::SetManualActionAndTime(CONFIG_SET::BUTTON_PRESS& button_1_state,
-                                               CONFIG_SET::BUTTON_PRESS& button_2_state,
-                                               CONFIG_SET::time_var& time_button_1,
-                                               CONFIG_SET::time_var& time_button_2) {
+void ManualInteraction::RunGesture(GESTURE_INPUT input, uint8_t button, int64_t time_us) {
     // Importing namespace for config
     using namespace CONFIG_SET;
 
-    if (button_1_state == BUTTON_PRESS::LONG_PRESS && button_2_state == BUTTON_PRESS::LONG_PRESS) {
-        manual_action_ = MANUAL_PUSH::LONG_PRESS_BOTH;
-        manual_action_time_ = time_button_1 > time_button_2 ? time_button_1 : time_button_2;
-    } else if (button_1_state == BUTTON_PRESS::LONG_PRESS && button_2_state == BUTTON_PRESS::NO_PUSH) {
-        manual_action_ = MANUAL_PUSH::LONG_PRESS_UP;
-        manual_action_time_ = time_button_1;
-    } else if (button_1_state == BUTTON_PRESS::NO_PUSH && button_2_state == BUTTON_PRESS::LONG_PRESS) {
-        manual_action_ = MANUAL_PUSH::LONG_PRESS_DOWN;
-        manual_action_time_ = time_button_2;
-    } else if (button_1_state == BUTTON_PRESS::DOUBLE_TAP && button_2_state == BUTTON_PRESS::NO_PUSH) {
-        manual_action_ = MANUAL_PUSH::DOUBLE_TAP_UP;
-        manual_action_time_ = time_button_1;
-        button_1_state = BUTTON_PRESS::NO_PUSH;
-    } else if (button_1_state == BUTTON_PRESS::NO_PUSH && button_2_state == BUTTON_PRESS::DOUBLE_TAP) {
-        manual_action_ = MANUAL_PUSH::DOUBLE_TAP_DOWN;
-        manual_action_time_ = time_button_2;
-        button_2_state = BUTTON_PRESS::NO_PUSH;
-    } else if (button_1_state == BUTTON_PRESS::DOUBLE_TAP && button_2_state == BUTTON_PRESS::DOUBLE_TAP) {
-        manual_action_ = MANUAL_PUSH::DOUBLE_TAP_BOTH;
-        manual_action_time_ = time_button_1 > time_button_2 ? time_button_1 : time_button_2;
-        button_1_state = BUTTON_PRESS::NO_PUSH;
-        button_2_state = BUTTON_PRESS::NO_PUSH;
-    } else if (button_1_state == BUTTON_PRESS::NO_PUSH && button_2_state == BUTTON_PRESS::NO_PUSH &&
-               manual_action_ != MANUAL_PUSH::DOUBLE_TAP_BOTH && manual_action_ != MANUAL_PUSH::DOUBLE_TAP_UP &&
-               manual_action_ != MANUAL_PUSH::DOUBLE_TAP_DOWN) {
-        manual_action_ = MANUAL_PUSH::NO_PUSH;
-        manual_action_time_ = time_button_1 > time_button_2 ? time_button_1 : time_button_2;
-        button_1_state = BUTTON_PRESS::NO_PUSH;
-        button_2_state = BUTTON_PRESS::NO_PUSH;
+    const GESTURE_TRANSITION& transition = s_gesture_transitions_[int(gesture_state_)][int(input)];
+    GESTURE_STATE next_state = transition.NEXT;
+    switch (transition.STEP) {
+        case GESTURE_STEP::NEXT_TAP:
+            if (gesture_buttons_ & button) {
+                gesture_deadline_us_ = time_us + GESTURE_LONG_PRESS_MS * 1000;
+                break;
+            }
+            // another button, the taps so far are a gesture of their own
+            ReportGesture(s_FindGesture(gesture_buttons_, gesture_taps_), time_us);
+            // fall through
+        case GESTURE_STEP::START:
+            gesture_buttons_ = button;
+            gesture_taps_ = 0;
+            gesture_deadline_us_ = time_us + GESTURE_LONG_PRESS_MS * 1000;
+            break;
+        case GESTURE_STEP::REGRIP:
+            MotorDriver::StopJog();
+            ReportGesture(MANUAL_PUSH::NO_PUSH, time_us);
+            gesture_taps_ = 0;
+            // fall through
+        case GESTURE_STEP::JOIN:
+            gesture_buttons_ |= button;
+            gesture_deadline_us_ = time_us + GESTURE_LONG_PRESS_MS * 1000;
+            break;
+        case GESTURE_STEP::TAP:
+            gesture_taps_++;
+            if (s_HasMoreTaps(gesture_buttons_, gesture_taps_)) {
+                gesture_deadline_us_ = time_us + GESTURE_TAP_GAP_MS * 1000;
+                break;
+            }
+            // nothing to wait for, reported right at the release
+            ReportGesture(s_FindGesture(gesture_buttons_, gesture_taps_), time_us);
+            gesture_deadline_us_ = -1;
+            next_state = GESTURE_STATE::IDLE;
+            break;
+        case GESTURE_STEP::HOLD:
+            ReportGesture(s_FindGesture(gesture_buttons_, 0), time_us);
+            gesture_deadline_us_ = -1;
+            break;
+        case GESTURE_STEP::END_HOLD:
+            // fast path, the motor stops without waiting for the controller
+            MotorDriver::StopJog();
+            ReportGesture(MANUAL_PUSH::NO_PUSH, time_us);
+            gesture_deadline_us_ = -1;
+            break;
+        case GESTURE_STEP::END_TAPS:
+            ReportGesture(s_FindGesture(gesture_buttons_, gesture_taps_), time_us);
+            gesture_deadline_us_ = -1;
+            break;
+        default:
+            break;
+    }
+    gesture_state_ = next_state;
+}
+
+void ManualInteraction::ReportGesture(CONFIG_SET::MANUAL_PUSH action, int64_t time_us) {
+    // Importing namespace for config
+    using namespace CONFIG_SET;
+
+    if (action == MANUAL_PUSH::NO_PUSH && gesture_state_ != GESTURE_STATE::HELD) {
+        // taps without a gesture of their own, only the end of a hold is reported
+        return;
+    }
+    manual_action_ = action;
+    manual_action_time_ = time_var(std::chrono::microseconds(time_us));
+    if (event_queue_) {
+        CONTROLLER_EVENT event;
+        event.TYPE = CONTROLLER_EVENT_TYPE::MANUAL_ACTION;
+        event.MANUAL_ACTION = action;
+        event_queue_->Post(event);
     }
 }
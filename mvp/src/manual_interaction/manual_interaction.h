@@ -15,24 +15,26 @@
 #include <Arduino.h>
 
 #include <chrono>
-#include <deque>
 #include <memory>
-#include <mutex>
 #include <new>
 #include <thread>
 #include <tuple>
 #include <utility>
 
 #include "../config/config.h"
+#include "../debouncer/debouncer.h"
+#include "../event_queue/event_queue.h"
 #include "../logging/logging.h"
+#include "../spsc_ring/spsc_ring.h"
 
 class ManualInteraction {
    public:
     /**
    * @brief  ManualInteraction class constructor
-   * Setup pinmode and interrupt
+   * Setup pinmode and interrupt, changes of the manual action are posted to
+   * the event queue if given
    */
-    ManualInteraction(int freq_to_run_deque_analyser, std::shared_ptr<Logging>& logging);
+    ManualInteraction(std::shared_ptr<Logging>& logging, std::shared_ptr<EventQueue> event_queue = nullptr);
 
     /**
    * @brief  ManualInteraction class destructor
@@ -41,18 +43,21 @@ class ManualInteraction {
     ~ManualInteraction();
 
     /**
-   * @brief  Hardware Interrrupt for up [red colored] button
-   * check for valid interrupt by software debouncing,switch state cheking
-   * and adds it to the button deque up
+   * @brief  Hardware Interrrupt for the up [red colored] and down [black
+   * colored] buttons
+   * the first change of a button starts sampling both buttons on the sample
+   * timer, its interrupts stay disabled until the buttons settle, so that
+   * bounces do not interrupt
    */
-    static void s_IntrAddToButtonDequeUp();
+    static void s_IntrButtonChange();
 
     /**
-   * @brief  Hardware Interrrupt for down [black colored] button
-   * check for valid interrupt by software debouncing,switch state cheking
-   * and adds it to the button deque down
+   * @brief  Hardware Interrrupt of the sample timer
+   * feeds both buttons into their debouncers, adds debounced edges to the
+   * button edge ring, and goes back to the button interrupts once both
+   * buttons settled
    */
-    static void s_IntrAddToButtonDequeDown();
+    static void s_IntrSampleButtons();
 
     /**
    * @brief Stop button deque analyser function
@@ -76,49 +81,160 @@ class ManualInteraction {
 
    private:
     /**
-   * @brief thread function to check the deque status and identify the manual
-   * interaction mode
-   * Function will check state and time of occurance for objects in deque for
-   * determining mode
+   * @brief Debounced level change of a button as recorded by the sample timer
+   *
+   */
+    struct BUTTON_EDGE {
+        uint32_t TIME_US;  // lower 32 bit of MonotonicClock, when the change began
+        uint8_t PIN;
+        uint8_t LEVEL;
+    };
+
+    /**
+   * @brief States of the gesture recogniser
+   * PRESSED  -> buttons are down, a long press once GESTURE_LONG_PRESS_MS pass
+   * RELEASED -> all buttons up after a tap, waiting GESTURE_TAP_GAP_MS for
+   *             the next tap
+   * HELD     -> a long press is going on until the buttons are released
+   */
+    enum class GESTURE_STATE {
+        IDLE,
+        PRESSED,
+        RELEASED,
+        HELD,
+        COUNT,
+    };
+
+    /**
+   * @brief Inputs of the gesture recogniser, RELEASE is a button going up
+   * while another one of the chord is still down
+   *
+   */
+    enum class GESTURE_INPUT {
+        PRESS,
+        RELEASE,
+        RELEASE_ALL,
+        TIMEOUT,
+        COUNT,
+    };
+
+    /**
+   * @brief What a transition of the gesture recogniser does
+   * START    -> a new gesture of the pressed button
+   * JOIN     -> the pressed button joins the chord, the hold starts again
+   * NEXT_TAP -> the next tap of the chord, or a new gesture for another button
+   * REGRIP   -> a button joins a held chord, which is released
+   * TAP      -> counts a tap, reported at once if no gesture has more taps
+   * HOLD     -> reports the long press of the chord
+   * END_HOLD -> reports the end of a long press
+   * END_TAPS -> reports the taps of the chord
+   */
+    enum class GESTURE_STEP {
+        NONE,
+        START,
+        JOIN,
+        NEXT_TAP,
+        REGRIP,
+        TAP,
+        HOLD,
+        END_HOLD,
+        END_TAPS,
+    };
+
+    struct GESTURE_TRANSITION {
+        GESTURE_STATE NEXT;
+        GESTURE_STEP STEP;
+    };
+
+    /**
+   * @brief Disables the button interrupts and starts the sample timer, called
+   * from interrupts
+   *
+   */
+    static void s_StartSampling();
+
+    /**
+   * @brief Arms the button interrupt on the level opposite to the current one,
+   * it fires on every change like a CHANGE interrupt but can also wake the CPU
+   * from light sleep. Re-armed by the analyser task for every edge it drains,
+   * gpio_wakeup_enable() is not in IRAM and hence not called from interrupts
+   *
+   * @param[in] pin button pin
+   * @param[in] state current level of the pin
+   */
+    static void s_ArmWakeUp(int pin, int state);
+
+    /**
+   * @brief Returns the action of the gesture of the chord, NO_PUSH if the
+   * gesture table has none
+   *
+   * @param[in] buttons GESTURE_BUTTON_* mask of the chord
+   * @param[in] taps number of taps, 0 for a long press
+   */
+    static CONFIG_SET::MANUAL_PUSH s_FindGesture(uint8_t buttons, uint8_t taps);
+
+    /**
+   * @brief Returns whether the gesture table has a gesture of the chord with
+   * more taps
+   *
+   */
+    static bool s_HasMoreTaps(uint8_t buttons, uint8_t taps);
+
+    /**
+   * @brief thread function which runs the gesture recogniser, sleeps until a
+   * button interrupt or the next gesture timeout
+   *
    */
     void ButtonstateDequeAnalyser();
 
     /**
-   * @brief Set the CurrentButtonState object
-   * Function to sets the current buttonstate [0 ->NO_PUSH, 1->LONGPRESS,
-   * 2->DOUBLETAP]
+   * @brief Feeds the edges recorded by the interrupts and the timeouts due
+   * until now into the gesture recogniser, in time order, called by the
+   * analyser thread, the only consumer of the ring
    *
-   * @param[in] button_press_deque_ deque to analyse and set button_state
-   * @param[out] button_state refrence to button_state passed
-   * @param[out] time refrence to time variable for change of button_state
    */
-    void SetCurrentButtonState(std::deque<std::pair<bool, CONFIG_SET::time_var>>& button_press_deque_,
-                               CONFIG_SET::BUTTON_PRESS& button_state, CONFIG_SET::time_var& time);
+    void HandleButtonEdges();
 
     /**
-   * @brief Set the Manual Action And Time object
-   * sets manual_action_ and manual_action_time_
+   * @brief Runs one transition of the gesture recogniser
    *
-   * @param[in] button_1_state current button state 1 [red]
-   * @param[in] button_2_state current button state 2 [black]
-   * @param[in] time_button_1 time the current button state 1 was set
-   * @param[in] time_button_2 time the current button state 2 was set
+   * @param[in] input what happened
+   * @param[in] button GESTURE_BUTTON_* of the edge, 0 for a timeout
+   * @param[in] time_us MonotonicClock time it happened at
    */
-    void SetManualActionAndTime(CONFIG_SET::BUTTON_PRESS& button_1_state, CONFIG_SET::BUTTON_PRESS& button_2_state,
-                                CONFIG_SET::time_var& time_button_1, CONFIG_SET::time_var& time_button_2);
+    void RunGesture(GESTURE_INPUT input, uint8_t button, int64_t time_us);
+
+    /**
+   * @brief Sets manual_action_ and manual_action_time_ and posts the action to
+   * the event queue
+   *
+   */
+    void ReportGesture(CONFIG_SET::MANUAL_PUSH action, int64_t time_us);
 
     CONFIG_SET::MANUAL_PUSH manual_action_ = CONFIG_SET::MANUAL_PUSH::NO_PUSH;
     CONFIG_SET::time_var manual_action_time_;
     bool stop_button_deque_analyser_ = true;
     std::unique_ptr<std::thread> deque_analyser_{nullptr};
     std::shared_ptr<Logging> logger_{nullptr};
-    const int freq_to_run_deque_analyser_;
-    int delay_to_run_deque_analyser_;
-
-    static std::deque<std::pair<bool, CONFIG_SET::time_var>> s_button_state_deque_up_;
-    static std::deque<std::pair<bool, CONFIG_SET::time_var>> s_button_state_deque_down_;
+    std::shared_ptr<EventQueue> event_queue_{nullptr};
+    uint32_t reported_dropped_count_ = 0;
+
+    // gesture recogniser, owned by the analyser thread
+    GESTURE_STATE gesture_state_ = GESTURE_STATE::IDLE;
+    uint8_t buttons_down_ = 0;
+    uint8_t gesture_buttons_ = 0;
+    uint8_t gesture_taps_ = 0;
+    int64_t gesture_deadline_us_ = -1;  // TIMEOUT input, none if negative
+
+    static const GESTURE_TRANSITION s_gesture_transitions_[int(GESTURE_STATE::COUNT)][int(GESTURE_INPUT::COUNT)];
+    static TaskHandle_t s_analyser_task_;
+    // produced by the sample timer interrupt
+    static SpscRing<BUTTON_EDGE, CONFIG_SET::BUTTON_EDGE_RING_CAPACITY> s_button_edges_;
+    // up and down, only touched by the sample timer interrupt once set up
+    static Debouncer s_debouncers_[2];
+    static const int s_button_pins_[2];
+    static hw_timer_t* s_sample_timer_;
     static bool s_class_setup_flag_;
-    static std::mutex s_deque_mutex_;
 };
 
 #endif
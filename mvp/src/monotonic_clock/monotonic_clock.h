@@ -0,0 +1,54 @@
+/**
+ * @file monotonic_clock.h
+ * @author Mahimana Bhatt (mahimanabhatt@gmail.com)
+ * @brief Defines the single clock of the firmware, microseconds since boot
+ *
+ * The clock is monotonic, unlike std::chrono::system_clock it never jumps
+ * when the wall time is set (e.g. by NTP), so timeouts, debouncing and
+ * durations measured with it hold. It is a std::chrono clock, so it is used
+ * through CONFIG_SET::current_time as well as through NowUs() and NowMs().
+ *
+ * The time comes from esp_timer_get_time(), which is 64 bit (no wrap around
+ * like micros()) and safe to call from interrupts. The host build provides
+ * esp_timer_get_time() from its virtual time (see host/README.md), which is
+ * how the clock of the whole firmware is replaced in simulation.
+ *
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef _MONOTONIC_CLOCK_INCLUDE_GUARD
+#define _MONOTONIC_CLOCK_INCLUDE_GUARD
+
+#include <esp_timer.h>
+
+#include <chrono>
+#include <cstdint>
+
+class MonotonicClock {
+   public:
+    typedef std::chrono::microseconds duration;
+    typedef duration::rep rep;
+    typedef duration::period period;
+    typedef std::chrono::time_point<MonotonicClock> time_point;
+    static constexpr bool is_steady = true;
+
+    static time_point now() { return time_point(duration(NowUs())); }
+
+    /**
+     * @brief Returns microseconds since boot
+     *
+     */
+    static int64_t NowUs() { return esp_timer_get_time(); }
+
+    /**
+     * @brief Returns milliseconds since boot
+     *
+     */
+    static int64_t NowMs() { return esp_timer_get_time() / 1000; }
+};
+
+#endif
@@ -0,0 +1,188 @@
+/**
+ * @file motion_profile.cpp
+ * @author Dhiraj Deshmukh (deshmukhdhiraj15@gmail.com)
+ * @brief Contains algorithms for planning and sampling jerk limited motion
+ * profiles
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include "motion_profile.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+// number of bisection iterations while searching for the peak velocity, enough
+// to get well below a microstep/s of resolution for any practical cruise speed
+const int PEAK_VELOCITY_SEARCH_ITERATIONS = 24;
+}  // namespace
+
+MotionProfile::MotionProfile()
+    : segment_count_(0), duration_(0), distance_(0), peak_velocity_(0), end_velocity_(0) {}
+
+float MotionProfile::TransitionTime(float delta_velocity, const LIMITS& limits, float* jerk_time, float* accel_time) {
+    *jerk_time = 0;
+    *accel_time = 0;
+    if (delta_velocity <= 0 || limits.ACCELERATION <= 0 || limits.JERK <= 0) {
+        return 0;
+    }
+    // velocity gained while ramping acceleration from 0 to limit and back
+    float full_jerk_delta_velocity = (limits.ACCELERATION * limits.ACCELERATION) / limits.JERK;
+    if (delta_velocity >= full_jerk_delta_velocity) {
+        *jerk_time = limits.ACCELERATION / limits.JERK;
+        *accel_time = (delta_velocity - full_jerk_delta_velocity) / limits.ACCELERATION;
+    } else {
+        // acceleration limit is never reached, triangular acceleration
+        *jerk_time = std::sqrt(delta_velocity / limits.JERK);
+    }
+    return 2 * (*jerk_time) + *accel_time;
+}
+
+float MotionProfile::TransitionDistance(float start_velocity, float end_velocity, const LIMITS& limits) {
+    float jerk_time, accel_time;
+    float time = TransitionTime(std::fabs(end_velocity - start_velocity), limits, &jerk_time, &accel_time);
+    // symmetric S-curve, average velocity is the mean of both ends
+    return 0.5f * (start_velocity + end_velocity) * time;
+}
+
+void MotionProfile::AppendSegment(float duration, float jerk) {
+    if (duration <= 0 || segment_count_ >= MAX_SEGMENTS) {
+        return;
+    }
+    SEGMENT& segment = segments_[segment_count_];
+    if (segment_count_ == 0) {
+        segment.START_TIME = 0;
+        segment.START_POSITION = 0;
+        segment.START_VELOCITY = end_velocity_;
+        segment.START_ACCELERATION = 0;
+    } else {
+        const SEGMENT& last = segments_[segment_count_ - 1];
+        float dt = last.DURATION;
+        segment.START_TIME = last.START_TIME + dt;
+        segment.START_POSITION = last.START_POSITION + last.START_VELOCITY * dt +
+                                 last.START_ACCELERATION * dt * dt / 2 + last.JERK * dt * dt * dt / 6;
+        segment.START_VELOCITY = last.START_VELOCITY + last.START_ACCELERATION * dt + last.JERK * dt * dt / 2;
+        segment.START_ACCELERATION = last.START_ACCELERATION + last.JERK * dt;
+    }
+    segment.DURATION = duration;
+    segment.JERK = jerk;
+    segment_count_++;
+}
+
+void MotionProfile::AppendTransition(float start_velocity, float end_velocity, const LIMITS& limits) {
+    float jerk_time, accel_time;
+    TransitionTime(std::fabs(end_velocity - start_velocity), limits, &jerk_time, &accel_time);
+    float jerk = (end_velocity > start_velocity) ? limits.JERK : -limits.JERK;
+    AppendSegment(jerk_time, jerk);
+    AppendSegment(accel_time, 0);
+    AppendSegment(jerk_time, -jerk);
+}
+
+bool MotionProfile::Plan(float distance, float start_velocity, float end_velocity, const LIMITS& limits) {
+    segment_count_ = 0;
+    distance = std::max(distance, 0.0f);
+    start_velocity = std::max(start_velocity, 0.0f);
+    float max_velocity = std::max(limits.CRUISE_VELOCITY, 0.0f);
+    end_velocity = std::min(std::max(end_velocity, 0.0f), max_velocity);
+
+    // end_velocity_ doubles as the initial velocity while the segments are
+    // appended, it is overwritten with the real end velocity afterwards
+    end_velocity_ = start_velocity;
+
+    auto required_distance = [&](float peak_velocity) {
+        return TransitionDistance(start_velocity, peak_velocity, limits) +
+               TransitionDistance(peak_velocity, end_velocity, limits);
+    };
+
+    bool reachable = true;
+    float peak_velocity = max_velocity;
+    if (required_distance(max_velocity) > distance) {
+        float low = std::max(end_velocity, std::min(start_velocity, max_velocity));
+        if (start_velocity > max_velocity && required_distance(low) > distance &&
+            required_distance(start_velocity) <= distance) {
+            // too close for slowing down to cruise velocity first, hold the
+            // start velocity and slow down to end velocity only
+            peak_velocity = start_velocity;
+        } else if (required_distance(low) > distance) {
+            // can not stop in time, go to end velocity as fast as possible
+            reachable = false;
+            peak_velocity = start_velocity;
+        } else {
+            float high = max_velocity;
+            for (int i = 0; i < PEAK_VELOCITY_SEARCH_ITERATIONS; i++) {
+                float mid = 0.5f * (low + high);
+                if (required_distance(mid) > distance) {
+                    high = mid;
+                } else {
+                    low = mid;
+                }
+            }
+            peak_velocity = low;
+        }
+    }
+
+    AppendTransition(start_velocity, peak_velocity, limits);
+    if (reachable && peak_velocity > 0) {
+        AppendSegment((distance - required_distance(peak_velocity)) / peak_velocity, 0);
+    }
+    AppendTransition(peak_velocity, end_velocity, limits);
+
+    peak_velocity_ = std::max({peak_velocity, start_velocity, end_velocity});
+    end_velocity_ = end_velocity;
+    duration_ = 0;
+    distance_ = 0;
+    if (segment_count_ > 0) {
+        const SEGMENT& last = segments_[segment_count_ - 1];
+        float dt = last.DURATION;
+        duration_ = last.START_TIME + dt;
+        distance_ = last.START_POSITION + last.START_VELOCITY * dt + last.START_ACCELERATION * dt * dt / 2 +
+                    last.JERK * dt * dt * dt / 6;
+    }
+    if (reachable && end_velocity == 0) {
+        // absorb floating point drift so that the move lands exactly on target
+        distance_ = distance;
+    }
+    return reachable;
+}
+
+MotionProfile::SAMPLE MotionProfile::Sample(float time_sec) const {
+    SAMPLE sample;
+    if (segment_count_ == 0 || time_sec >= duration_) {
+        float extra_time = std::max(time_sec - duration_, 0.0f);
+        sample.POSITION = distance_ + end_velocity_ * extra_time;
+        sample.VELOCITY = end_velocity_;
+        sample.ACCELERATION = 0;
+        sample.FINISHED = true;
+        return sample;
+    }
+    time_sec = std::max(time_sec, 0.0f);
+    int index = segment_count_ - 1;
+    while (index > 0 && segments_[index].START_TIME > time_sec) {
+        index--;
+    }
+    const SEGMENT& segment = segments_[index];
+    float dt = time_sec - segment.START_TIME;
+    sample.POSITION = segment.START_POSITION + segment.START_VELOCITY * dt + segment.START_ACCELERATION * dt * dt / 2 +
+                      segment.JERK * dt * dt * dt / 6;
+    sample.VELOCITY =
+        std::max(segment.START_VELOCITY + segment.START_ACCELERATION * dt + segment.JERK * dt * dt / 2, 0.0f);
+    sample.ACCELERATION = segment.START_ACCELERATION + segment.JERK * dt;
+    sample.FINISHED = false;
+    return sample;
+}
+
+float MotionProfile::GetDuration() const {
+    return duration_;
+}
+
+float MotionProfile::GetDistance() const {
+    return distance_;
+}
+
+float MotionProfile::GetPeakVelocity() const {
+    return peak_velocity_;
+}
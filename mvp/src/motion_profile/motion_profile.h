@@ -0,0 +1,155 @@
+/**
+ * @file motion_profile.h
+ * @author Mahimana Bhatt (mahimanabhatt@gmail.com)
+ * @brief Defines a jerk limited (S-curve) motion profile generator. The
+ * generator is pure C++ without any Arduino dependency, so it can be compiled,
+ * unit tested and benchmarked on a host machine.
+ *
+ * A move is planned as (up to) seven constant jerk segments:
+ * accelerate from start velocity to peak velocity, cruise, decelerate to end
+ * velocity. Each velocity transition is made of a jerk up, constant
+ * acceleration and jerk down segment, the constant acceleration segment
+ * disappears if the velocity change is too small to reach the acceleration
+ * limit (which gives the S-curve its "triangular" acceleration shape).
+ *
+ * All quantities are in direction relative microsteps, i.e. position always
+ * increases from 0 to the move distance and velocities are never negative,
+ * the caller is responsible for mapping it onto the motor direction.
+ *
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef _MOTION_PROFILE_INCLUDE_GUARD
+#define _MOTION_PROFILE_INCLUDE_GUARD
+
+#include <cstdint>
+
+class MotionProfile {
+   public:
+    /**
+     * @brief Kinematic limits used for planning a move
+     *
+     */
+    struct LIMITS {
+        float CRUISE_VELOCITY;  // microsteps / s
+        float ACCELERATION;     // microsteps / s^2
+        float JERK;             // microsteps / s^3
+    };
+
+    /**
+     * @brief State of the profile at a given time since the start of the move
+     *
+     */
+    struct SAMPLE {
+        float POSITION;      // microsteps from the start of the move
+        float VELOCITY;      // microsteps / s
+        float ACCELERATION;  // microsteps / s^2
+        bool FINISHED;       // true once all segments have been played
+    };
+
+    /**
+     * @brief Construct an empty profile, sampling it returns a finished sample
+     * at standstill
+     *
+     */
+    MotionProfile();
+
+    /**
+     * @brief Plans a move over the given distance
+     *
+     * @param distance: distance to travel in microsteps, must be positive
+     * @param start_velocity: velocity at the start of the move
+     * @param end_velocity: velocity to hold once the distance is covered, 0 for
+     * landing on the distance, non-zero for creeping into an end stop
+     * @param limits: kinematic limits for the move
+     * @return true : the distance can be covered with the given limits
+     * @return false : the start velocity is too high to stop within the
+     * distance, or the distance is too short to reach the end velocity, the
+     * planned profile then only brings the motor to end velocity as fast as
+     * the limits allow (and hence overshoots or undershoots the distance)
+     */
+    bool Plan(float distance, float start_velocity, float end_velocity, const LIMITS& limits);
+
+    /**
+     * @brief Samples the profile
+     *
+     * @param time_sec: time since the start of the move in seconds
+     * @return SAMPLE : planned state of motion at the given time
+     */
+    SAMPLE Sample(float time_sec) const;
+
+    /**
+     * @brief Returns total duration of the planned profile in seconds
+     *
+     */
+    float GetDuration() const;
+
+    /**
+     * @brief Returns the distance covered by the planned profile
+     *
+     */
+    float GetDistance() const;
+
+    /**
+     * @brief Returns the peak velocity reached by the planned profile
+     *
+     */
+    float GetPeakVelocity() const;
+
+    /**
+     * @brief Returns the minimum distance needed to change velocity from
+     * start_velocity to end_velocity with the given limits
+     *
+     */
+    static float TransitionDistance(float start_velocity, float end_velocity, const LIMITS& limits);
+
+   private:
+    static const int MAX_SEGMENTS = 7;
+
+    /**
+     * @brief A constant jerk segment, start state is precomputed while planning
+     * so that sampling does not have to integrate the previous segments
+     *
+     */
+    struct SEGMENT {
+        float START_TIME;
+        float DURATION;
+        float JERK;
+        float START_POSITION;
+        float START_VELOCITY;
+        float START_ACCELERATION;
+    };
+
+    SEGMENT segments_[MAX_SEGMENTS];
+    int segment_count_;
+    float duration_;
+    float distance_;
+    float peak_velocity_;
+    float end_velocity_;
+
+    /**
+     * @brief Appends the jerk up, constant acceleration and jerk down segments
+     * needed for going from start_velocity to end_velocity
+     *
+     */
+    void AppendTransition(float start_velocity, float end_velocity, const LIMITS& limits);
+
+    /**
+     * @brief Appends a single constant jerk segment, skips zero length segments
+     *
+     */
+    void AppendSegment(float duration, float jerk);
+
+    /**
+     * @brief Returns the time taken by a velocity transition, along with the
+     * duration of its jerk and constant acceleration phases
+     *
+     */
+    static float TransitionTime(float delta_velocity, const LIMITS& limits, float* jerk_time, float* accel_time);
+};
+
+#endif
@@ -15,17 +15,46 @@
 #include <HardwareSerial.h>
 #include <TMCStepper.h>
 
+#include <algorithm>
+#include <cmath>
 #include <ctime>
+#include <iterator>
 
 #include "../config/config.h"
+#include "../event_queue/event_queue.h"
+#include "../latency/latency.h"
 #include "../logging/logging.h"
+#include "../monotonic_clock/monotonic_clock.h"
+#include "../motion_profile/motion_profile.h"
+#include "../percent_map/percent_map.h"
+#include "../position_estimator/position_estimator.h"
+#include "../telemetry/telemetry.h"
 
-bool MotorDriver::direction_ = false;
-int MotorDriver::current_step_ = 0;
-int MotorDriver::full_rot_step_count_ = (4 * CONFIG_SET::MOTOR_DRIVER_MICROSTEP);
+std::atomic<bool> MotorDriver::direction_{false};
+SeqLock<MotorDriver::INDEX_STATE> MotorDriver::index_state_;
+TaskHandle_t MotorDriver::handler_task_ = NULL;
+std::atomic<uint32_t> MotorDriver::profile_tick_time_us_{0};
+std::atomic<bool> MotorDriver::jog_stop_requested_{false};
 
-MotorDriver::MotorDriver(std::shared_ptr<Logging>& logging, CONFIG_SET::CALIB_PARAMS calib_param)
-    : logger_(logging), TMC2209Stepper(&Serial2, CONFIG_SET::MOTOR_DRIVER_R_SENSE, CONFIG_SET::MOTOR_DRIVER_ADDRESS) {
+namespace {
+/**
+ * @brief Runs one register access over the driver UART, timed
+ *
+ */
+template <typename ACCESS>
+auto s_TimeTransaction(ACCESS access) -> decltype(access()) {
+    LatencyTimer timer(CONFIG_SET::LATENCY_PROBE::UART_TRANSACTION);
+    return access();
+}
+}  // namespace
+
+MotorDriver::MotorDriver(std::shared_ptr<Logging>& logging, CONFIG_SET::CALIB_PARAMS calib_param,
+                         std::shared_ptr<TelemetryRecorder> telemetry, std::shared_ptr<EventQueue> event_queue)
+    : logger_(logging),
+      telemetry_(telemetry),
+      event_queue_(event_queue),
+      TMC2209Stepper(&Serial2, CONFIG_SET::MOTOR_DRIVER_R_SENSE, CONFIG_SET::MOTOR_DRIVER_ADDRESS),
+      position_estimator_(CONFIG_SET::MOTOR_DRIVER_MICROSTEP) {
     using namespace CONFIG_SET;
     pinMode(PIN_MD_DIAG, INPUT);
     pinMode(PIN_MD_ENABLE, OUTPUT);
@@ -39,155 +68,840 @@ MotorDriver::MotorDriver(std::shared_ptr<Logging>& logging, CONFIG_SET::CALIB_PA
     ResetSteps();
 
     Serial2.begin(MOTOR_DRIVER_BAUD_RATE, SERIAL_8N1, PIN_MD_RX, PIN_MD_TX);
+    SetupRegisterCache();
 
     UpdateCalibParams(calib_param);
     attachInterrupt(PIN_MD_INDEX, MotorDriver::InterruptForIndex, RISING);
+    attachInterrupt(PIN_MD_DIAG, MotorDriver::InterruptForStall, RISING);
+
+    profile_timer_ = timerBegin(MOTION_PROFILE_TIMER_ID, MOTION_PROFILE_TIMER_PRESCALER, true);
+    timerAttachInterrupt(profile_timer_, MotorDriver::InterruptForProfileTick, true);
+    timerAlarmWrite(profile_timer_, MOTION_PROFILE_TICK_US, true);
     StartHandler();
-    logger_->Log(LOG_TYPE::INFO, LOG_CLASS::MOTOR_DRIVER, "Motor Driver Setup Completed");
+    logger_->Log(LOG_TYPE::INFO, LOG_CLASS::MOTOR_DRIVER, LOG_FORMAT("Motor Driver Setup Completed"));
 }
 
 MotorDriver::~MotorDriver() {
     EnableDriver(false);
     StopHandler();
+    detachInterrupt(CONFIG_SET::PIN_MD_INDEX);
+    detachInterrupt(CONFIG_SET::PIN_MD_DIAG);
+    timerAlarmDisable(profile_timer_);
+    timerDetachInterrupt(profile_timer_);
+    timerEnd(profile_timer_);
 }
 
-bool MotorDriver::FulfillRequest(CONFIG_SET::MOTION_REQUEST request) {
+uint32_t MotorDriver::FulfillRequest(CONFIG_SET::MOTION_REQUEST request) {
     using namespace CONFIG_SET;
-    if (is_motor_running_) {
-        return false;
+    if (!keep_handler_running_ || request.PERCENTAGE < 0 || request.PERCENTAGE > 100) {
+        logger_->Log(LOG_TYPE::WARN, LOG_CLASS::MOTOR_DRIVER, LOG_FORMAT("Movement request rejected"));
+        return 0;
     }
-    expected_step_ = (float(request.PERCENTAGE) / 100) * calib_params_.TOTAL_STEP_COUNT;
-    // Handle 100, 0 for blinds traversals
-    blind_traversal_requested_ = request.PERCENTAGE >= 100 || request.PERCENTAGE <= 0;
-    if (blind_traversal_requested_) {
-        direction_ = request.PERCENTAGE == 100;
-    } else {
-        direction_ = expected_step_ > current_step_;
+    uint32_t request_id = ++last_request_id_;
+    {
+        std::lock_guard<std::mutex> lock(mailbox_mutex_);
+        if (mailbox_.AVAILABLE) {
+            // handler did not pick the previous one yet, latest wins
+            PushFeedback(mailbox_.ID, MOTION_RESULT::SUPERSEDED);
+        }
+        mailbox_.AVAILABLE = true;
+        mailbox_.REQUEST = request;
+        mailbox_.ID = request_id;
     }
-    logger_->Log(LOG_TYPE::INFO, LOG_CLASS::MOTOR_DRIVER, "Movement request received");
-    return true;
+    logger_->Log(LOG_TYPE::INFO, LOG_CLASS::MOTOR_DRIVER, LOG_FORMAT("Movement request received"));
+    // the handler sleeps while idle, the request has to wake it
+    NotifyHandler(EVENT_NEW_REQUEST);
+    return request_id;
+}
+
+std::tuple<bool, CONFIG_SET::MOTION_FEEDBACK> MotorDriver::GetMotionFeedback() {
+    std::lock_guard<std::mutex> lock(feedback_mutex_);
+    if (feedback_count_ == 0) {
+        return std::make_tuple(false, CONFIG_SET::MOTION_FEEDBACK());
+    }
+    int head = (feedback_tail_ + CONFIG_SET::MOTION_FEEDBACK_QUEUE_SIZE - feedback_count_) %
+               CONFIG_SET::MOTION_FEEDBACK_QUEUE_SIZE;
+    feedback_count_--;
+    return std::make_tuple(true, feedback_queue_[head]);
+}
+
+void MotorDriver::PushFeedback(uint32_t request_id, CONFIG_SET::MOTION_RESULT result, int total_step_count) {
+    using namespace CONFIG_SET;
+    if (request_id == 0) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(feedback_mutex_);
+        MOTION_FEEDBACK& feedback = feedback_queue_[feedback_tail_];
+        feedback.ID = request_id;
+        feedback.RESULT = result;
+        feedback.PERCENTAGE = GetPercentage();
+        feedback.TOTAL_STEP_COUNT = total_step_count;
+        feedback_tail_ = (feedback_tail_ + 1) % MOTION_FEEDBACK_QUEUE_SIZE;
+        // oldest feedback is dropped when the controller does not keep up
+        feedback_count_ = std::min(feedback_count_ + 1, MOTION_FEEDBACK_QUEUE_SIZE);
+    }
+    PostEvent(CONTROLLER_EVENT_TYPE::MOTION_FEEDBACK);
 }
 
 CONFIG_SET::DRIVER_STATUS MotorDriver::GetStatus() {
-    return (is_motor_running_) ? CONFIG_SET::DRIVER_STATUS::BUSY : CONFIG_SET::DRIVER_STATUS::AVAILABLE;
+    return (GetState().RUNNING) ? CONFIG_SET::DRIVER_STATUS::BUSY : CONFIG_SET::DRIVER_STATUS::AVAILABLE;
 }
 
 bool MotorDriver::EnableDriver(bool enable) {
     digitalWrite(CONFIG_SET::PIN_MD_ENABLE, !enable);
+    return true;
 }
 
 void MotorDriver::InitializeDriver() {
     using namespace CONFIG_SET;
-    logger_->Log(LOG_TYPE::INFO, LOG_CLASS::MOTOR_DRIVER, "Initializing driver");
-    this->begin();
-    this->toff(MOTOR_DRIVER_TOFF);
-    this->blank_time(MOTOR_DRIVER_BLANK_TIME);
-    this->rms_current(MOTOR_DRIVER_RMS_CURRENT);
-    this->microsteps(MOTOR_DRIVER_MICROSTEP);
-    this->TCOOLTHRS(MOTOR_DRIVER_TCOOL_THRS);  // 20bit max
-    this->semin(MOTOR_DRIVER_SE_MIN);
-    this->semax(MOTOR_DRIVER_SE_MAX);
-    this->shaft(false);
-    this->sedn(MOTOR_DRIVER_SEDN);
-    this->SGTHRS(MOTOR_DRIVER_SG_THRESH);
+    logger_->Log(LOG_TYPE::INFO, LOG_CLASS::MOTOR_DRIVER, LOG_FORMAT("Initializing driver"));
+    register_cache_.SetField(TMC2209_REGISTER::PDN_DISABLE, 1);
+    register_cache_.SetField(TMC2209_REGISTER::MSTEP_REG_SELECT, 1);
+    register_cache_.SetField(TMC2209_REGISTER::TOFF, MOTOR_DRIVER_TOFF);
+    register_cache_.SetField(TMC2209_REGISTER::TBL, (MOTOR_DRIVER_BLANK_TIME - 16) / 8);
+    SetRunCurrent(MOTOR_DRIVER_RMS_CURRENT);
+    // standstill current drops to IHOLD, only relevant when the driver stays
+    // enabled between moves
+    register_cache_.SetField(TMC2209_REGISTER::IHOLDDELAY, MOTOR_DRIVER_IHOLD_DELAY);
+    register_cache_.Set(TMC2209_REGISTER::TPOWERDOWN, MOTOR_DRIVER_TPOWERDOWN);
+    int mres = 8;
+    for (int microsteps = MOTOR_DRIVER_MICROSTEP; microsteps > 1 && mres > 0; microsteps >>= 1) {
+        mres--;
+    }
+    register_cache_.SetField(TMC2209_REGISTER::MRES, mres);
+    register_cache_.Set(TMC2209_REGISTER::TCOOLTHRS, MOTOR_DRIVER_TCOOL_THRS);  // 20bit max
+    register_cache_.SetField(TMC2209_REGISTER::SEMIN, MOTOR_DRIVER_SE_MIN);
+    register_cache_.SetField(TMC2209_REGISTER::SEMAX, MOTOR_DRIVER_SE_MAX);
+    register_cache_.SetField(TMC2209_REGISTER::SHAFT, 0);
+    register_cache_.SetField(TMC2209_REGISTER::SEDN, MOTOR_DRIVER_SEDN);
+    register_cache_.Set(TMC2209_REGISTER::SGTHRS, calib_params_.SG_THRESHOLD);
+    // on re-initialization only the changed registers are written
+    if (!FlushRegisters(MOTOR_DRIVER_VERIFY_WRITES)) {
+        logger_->Log(LOG_TYPE::ERROR, LOG_CLASS::MOTOR_DRIVER, LOG_FORMAT("Driver register verification failed"));
+    }
+}
+
+void MotorDriver::SetupRegisterCache() {
+    register_cache_.AddRegister(TMC2209_REGISTER::GCONF, TMC2209_REGISTER::GCONF_DEFAULT, true);
+    register_cache_.AddRegister(TMC2209_REGISTER::IHOLD_IRUN, TMC2209_REGISTER::IHOLD_IRUN_DEFAULT, false);
+    register_cache_.AddRegister(TMC2209_REGISTER::TPOWERDOWN, TMC2209_REGISTER::TPOWERDOWN_DEFAULT, false);
+    register_cache_.AddRegister(TMC2209_REGISTER::TCOOLTHRS, 0, false);
+    register_cache_.AddRegister(TMC2209_REGISTER::SGTHRS, 0, false);
+    register_cache_.AddRegister(TMC2209_REGISTER::COOLCONF, 0, false);
+    register_cache_.AddRegister(TMC2209_REGISTER::CHOPCONF, TMC2209_REGISTER::CHOPCONF_DEFAULT, true);
+    register_cache_.AddRegister(TMC2209_REGISTER::VACTUAL, 0, false);
+    expected_ifcnt_ = s_TimeTransaction([this]() { return this->IFCNT(); });
+}
+
+void MotorDriver::SetRunCurrent(uint16_t milliamps) {
+    using namespace CONFIG_SET;
+    // 0.02 ohm accounts for the internal resistance of the driver
+    float scale = 32.0f * 1.41421f * milliamps / 1000.0f * (MOTOR_DRIVER_R_SENSE + 0.02f);
+    int current_scale = int(scale / 0.325f) - 1;
+    bool vsense = current_scale < 16;
+    if (vsense) {
+        current_scale = int(scale / 0.180f) - 1;
+    }
+    current_scale = std::max(0, std::min(31, current_scale));
+    register_cache_.SetField(TMC2209_REGISTER::VSENSE, vsense);
+    register_cache_.SetField(TMC2209_REGISTER::IRUN, current_scale);
+    register_cache_.SetField(TMC2209_REGISTER::IHOLD, int(current_scale * MOTOR_DRIVER_HOLD_MULTIPLIER));
+}
+
+bool MotorDriver::FlushRegisters(bool verify) {
+    int written = register_cache_.Flush([this](uint8_t address, uint32_t value) {
+        s_TimeTransaction([this, address, value]() { this->write(address, value); });
+    });
+    // IFCNT counts the accepted write datagrams, modulo 256
+    expected_ifcnt_ += written;
+    if (!verify) {
+        return true;
+    }
+    uint8_t ifcnt = s_TimeTransaction([this]() { return this->IFCNT(); });
+    int mismatches = register_cache_.Verify(
+        [this](uint8_t address) { return s_TimeTransaction([this, address]() { return this->read(address); }); });
+    if (ifcnt == expected_ifcnt_ && mismatches == 0) {
+        return true;
+    }
+    // a write-only register may have been lost as well, write all again
+    register_cache_.Invalidate();
+    expected_ifcnt_ = ifcnt;
+    return false;
 }
 
 void MotorDriver::UpdateCalibParams(CONFIG_SET::CALIB_PARAMS calib_param) {
+    using namespace CONFIG_SET;
     calib_params_ = calib_param;
+    percent_map_.Build(calib_params_.PERCENT_MAP, PERCENT_MAP_KNOTS, calib_params_.TOTAL_STEP_COUNT);
     EnableDriver(true);
     InitializeDriver();
-    EnableDriver(false);
+    EnableDriver(MOTOR_DRIVER_IDLE_HOLD);
+
+    SpeedScheduler::LIMITS limits;
+    limits.MIN_VELOCITY = SPEED_SCHEDULER_MIN_VELOCITY;
+    limits.BASE_VELOCITY = MOTION_PROFILE_CRUISE_VELOCITY;
+    limits.MAX_VELOCITY = SPEED_SCHEDULER_MAX_VELOCITY;
+    limits.STEP_UP = SPEED_SCHEDULER_STEP_UP;
+    limits.BACK_OFF = SPEED_SCHEDULER_BACK_OFF;
+    limits.SG_LOW_MARGIN = SPEED_SCHEDULER_SG_LOW_MARGIN;
+    limits.SG_HIGH_MARGIN = SPEED_SCHEDULER_SG_HIGH_MARGIN;
+    limits.CS_HEADROOM = SPEED_SCHEDULER_CS_HEADROOM;
+    limits.THERMAL_HOLD_US = SPEED_SCHEDULER_THERMAL_HOLD_US;
+    speed_scheduler_.reset(new SpeedScheduler(limits, 2 * calib_params_.SG_THRESHOLD,
+                                              register_cache_.GetField(TMC2209_REGISTER::IRUN)));
+}
+
+void MotorDriver::UpdatePercentMap(const uint16_t* knots) {
+    {
+        std::lock_guard<std::mutex> lock(percent_map_mutex_);
+        std::copy(knots, knots + CONFIG_SET::PERCENT_MAP_KNOTS, pending_percent_map_);
+        percent_map_pending_ = true;
+    }
+    NotifyHandler(EVENT_PERCENT_MAP);
+}
+
+void MotorDriver::HandlePercentMapUpdate() {
+    using namespace CONFIG_SET;
+    if (!percent_map_pending_ || is_motor_running_) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(percent_map_mutex_);
+        std::copy(std::begin(pending_percent_map_), std::end(pending_percent_map_), calib_params_.PERCENT_MAP);
+        percent_map_pending_ = false;
+    }
+    if (!percent_map_.Build(calib_params_.PERCENT_MAP, PERCENT_MAP_KNOTS, calib_params_.TOTAL_STEP_COUNT)) {
+        logger_->Log(LOG_TYPE::WARN, LOG_CLASS::MOTOR_DRIVER, LOG_FORMAT("Invalid percent map, using linear"));
+    }
+    PublishState();
 }
 
 void MotorDriver::StopMotor() {
     using namespace CONFIG_SET;
-    logger_->Log(LOG_TYPE::INFO, LOG_CLASS::MOTOR_DRIVER, "Stopping Motor");
-    this->VACTUAL(0);
-    EnableDriver(false);
+    logger_->Log(LOG_TYPE::INFO, LOG_CLASS::MOTOR_DRIVER, LOG_FORMAT("Stopping Motor"));
+    timerAlarmDisable(profile_timer_);
+    float commanded_travel = GetCommandedTravel();
+    register_cache_.Set(TMC2209_REGISTER::VACTUAL, 0);
+    FlushRegisters(false);
+    // final fix of the position, motor stops as soon as VACTUAL is written
+    SyncPosition(true, commanded_travel);
+    EnableDriver(MOTOR_DRIVER_IDLE_HOLD);
     is_motor_running_ = false;
+    PublishState();
 }
 
 void MotorDriver::StartMotor() {
     using namespace CONFIG_SET;
-    logger_->Log(LOG_TYPE::INFO, LOG_CLASS::MOTOR_DRIVER, "Starting Motor");
+    logger_->Log(LOG_TYPE::INFO, LOG_CLASS::MOTOR_DRIVER, LOG_FORMAT("Starting Motor"));
     EnableDriver(true);
-    this->shaft(calib_params_.DIRECTION ^ direction_);
-    this->VACTUAL(MOTOR_DRIVER_MAX_SPEED);
+    // shaft goes out with the first VACTUAL write in the same batch
+    register_cache_.SetField(TMC2209_REGISTER::SHAFT, calib_params_.DIRECTION ^ direction_);
+    uint16_t mscnt = s_TimeTransaction([this]() { return this->MSCNT(); });
+    position_estimator_.StartMove(current_step_, direction_, index_state_.Read().PULSE_COUNT, mscnt);
+    commanded_travel_base_ = 0;
+    target_corrections_ = 0;
+    last_sg_result_cruising_ = false;
+    PlanMotion(0);
     is_motor_running_ = true;
-    last_motor_start_time_sec_ = std::time(nullptr);
+    PublishState();
+    move_start_time_us_ = MonotonicClock::NowUs();
+    profile_start_time_us_ = move_start_time_us_;
+    last_mscnt_read_us_ = move_start_time_us_;
+    timerWrite(profile_timer_, 0);
+    timerAlarmEnable(profile_timer_);
+    UpdateVelocity();
+    telemetry_move_id_++;
+    last_telemetry_us_ = move_start_time_us_;
+    RecordTelemetry(TELEMETRY_EVENT::MOVE_START, 0);
+}
+
+MotionProfile::LIMITS MotorDriver::GetMotionLimits(bool creep) {
+    using namespace CONFIG_SET;
+    MotionProfile::LIMITS limits;
+    limits.CRUISE_VELOCITY = MOTION_PROFILE_CRUISE_VELOCITY;
+    if (creep) {
+        limits.CRUISE_VELOCITY = MOTION_PROFILE_CREEP_VELOCITY;
+    } else if (speed_scheduler_) {
+        limits.CRUISE_VELOCITY = speed_scheduler_->GetVelocity();
+    }
+    limits.ACCELERATION = MOTION_PROFILE_ACCELERATION;
+    limits.JERK = MOTION_PROFILE_JERK;
+    return limits;
+}
+
+float MotorDriver::GetRemainingDistance(const MOTION_TARGET& target) {
+    // traversals are planned to the expected end and creep into the end stop
+    int end_step = target.TRAVERSAL ? (target.DIRECTION ? calib_params_.TOTAL_STEP_COUNT : 0) : target.EXPECTED_STEP;
+    return target.DIRECTION ? float(end_step) - current_step_ : float(current_step_) - end_step;
+}
+
+void MotorDriver::PlanMotion(float start_velocity) {
+    using namespace CONFIG_SET;
+    MOTION_TARGET target;
+    target.EXPECTED_STEP = expected_step_;
+    target.TRAVERSAL = blind_traversal_requested_;
+    target.DIRECTION = direction_;
+    float end_velocity = blind_traversal_requested_ ? MOTION_PROFILE_CREEP_VELOCITY : 0;
+    MotionProfile::LIMITS limits = GetMotionLimits(creep_requested_);
+    planned_cruise_velocity_ = limits.CRUISE_VELOCITY;
+    motion_profile_.Plan(std::abs(GetRemainingDistance(target)), start_velocity, end_velocity, limits);
+}
+
+MotorDriver::MOTION_TARGET MotorDriver::ComputeTarget(CONFIG_SET::MOTION_REQUEST request, uint32_t request_id) {
+    MOTION_TARGET target;
+    target.ID = request_id;
+    target.CREEP = request.CREEP;
+    target.JOG = request.JOG;
+    if (request.RELATIVE_STEPS != 0) {
+        long expected_step = long(current_step_) + request.RELATIVE_STEPS;
+        target.EXPECTED_STEP = std::max(0L, std::min(long(calib_params_.TOTAL_STEP_COUNT), expected_step));
+        target.DIRECTION = request.RELATIVE_STEPS > 0;
+        return target;
+    }
+    target.EXPECTED_STEP = percent_map_.StepFromPercent(request.PERCENTAGE);
+    // Handle 100, 0 for blinds traversals
+    target.TRAVERSAL = request.PERCENTAGE >= 100 || request.PERCENTAGE <= 0;
+    if (target.TRAVERSAL) {
+        target.DIRECTION = request.PERCENTAGE == 100;
+    } else {
+        target.DIRECTION = target.EXPECTED_STEP > current_step_;
+    }
+    return target;
+}
+
+void MotorDriver::ApplyTarget(const MOTION_TARGET& target) {
+    expected_step_ = target.EXPECTED_STEP;
+    blind_traversal_requested_ = target.TRAVERSAL;
+    creep_requested_ = target.CREEP;
+    jog_requested_ = target.JOG;
+    direction_ = target.DIRECTION;
+    active_request_id_ = target.ID;
+}
+
+void MotorDriver::HandleNewRequest() {
+    using namespace CONFIG_SET;
+    MOTION_REQUEST request;
+    uint32_t request_id;
+    {
+        std::lock_guard<std::mutex> lock(mailbox_mutex_);
+        if (!mailbox_.AVAILABLE) {
+            return;
+        }
+        request = mailbox_.REQUEST;
+        request_id = mailbox_.ID;
+        mailbox_.AVAILABLE = false;
+    }
+    MOTION_TARGET target = ComputeTarget(request, request_id);
+    if (!is_motor_running_) {
+        ApplyTarget(target);
+        return;
+    }
+    if (retarget_pending_) {
+        // already stopping for a reversal, only the target to go to changes
+        PushFeedback(pending_target_.ID, MOTION_RESULT::SUPERSEDED);
+        pending_target_ = target;
+        return;
+    }
+    PushFeedback(active_request_id_, MOTION_RESULT::SUPERSEDED);
+
+    MotionProfile::SAMPLE sample = motion_profile_.Sample((MonotonicClock::NowUs() - profile_start_time_us_) / 1000000.0f);
+    float end_velocity = target.TRAVERSAL ? MOTION_PROFILE_CREEP_VELOCITY : 0;
+    float stopping_distance = MotionProfile::TransitionDistance(sample.VELOCITY, end_velocity, GetMotionLimits());
+    commanded_travel_base_ += sample.POSITION;
+    profile_start_time_us_ = MonotonicClock::NowUs();
+    target_corrections_ = 0;
+    if (target.DIRECTION == direction_ && GetRemainingDistance(target) >= stopping_distance) {
+        // same direction and enough room, bend the running profile
+        logger_->Log(LOG_TYPE::INFO, LOG_CLASS::MOTOR_DRIVER, LOG_FORMAT("Retargeting Motion"));
+        ApplyTarget(target);
+        PlanMotion(sample.VELOCITY);
+    } else {
+        // decelerate to standstill, the new target is applied once stopped
+        logger_->Log(LOG_TYPE::INFO, LOG_CLASS::MOTOR_DRIVER, LOG_FORMAT("Stopping for Retarget"));
+        active_request_id_ = 0;
+        pending_target_ = target;
+        retarget_pending_ = true;
+        motion_profile_.Plan(MotionProfile::TransitionDistance(sample.VELOCITY, 0, GetMotionLimits()),
+                             sample.VELOCITY, 0, GetMotionLimits());
+    }
+    timerAlarmEnable(profile_timer_);
+    UpdateVelocity();
+}
+
+void MotorDriver::HandleJogStop() {
+    using namespace CONFIG_SET;
+    if (!jog_stop_requested_.exchange(false)) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mailbox_mutex_);
+        if (mailbox_.AVAILABLE && mailbox_.REQUEST.JOG) {
+            PushFeedback(mailbox_.ID, MOTION_RESULT::CANCELLED);
+            mailbox_.AVAILABLE = false;
+        }
+    }
+    if (!jog_requested_) {
+        return;
+    }
+    jog_requested_ = false;
+    if (!is_motor_running_ || retarget_pending_) {
+        // not started yet, or already stopping
+        expected_step_ = current_step_;
+        blind_traversal_requested_ = false;
+        return;
+    }
+    logger_->Log(LOG_TYPE::INFO, LOG_CLASS::MOTOR_DRIVER, LOG_FORMAT("Stopping Jog"));
+    MotionProfile::SAMPLE sample = motion_profile_.Sample((MonotonicClock::NowUs() - profile_start_time_us_) / 1000000.0f);
+    float stopping_distance = MotionProfile::TransitionDistance(sample.VELOCITY, 0, GetMotionLimits());
+    commanded_travel_base_ += sample.POSITION;
+    profile_start_time_us_ = MonotonicClock::NowUs();
+    target_corrections_ = 0;
+    // a move to where the deceleration ends, not into the end stop any more
+    long expected_step = long(current_step_) + (direction_ ? 1 : -1) * long(std::ceil(stopping_distance));
+    expected_step_ = std::max(0L, std::min(long(calib_params_.TOTAL_STEP_COUNT), expected_step));
+    blind_traversal_requested_ = false;
+    creep_requested_ = false;
+    PlanMotion(sample.VELOCITY);
+    timerAlarmEnable(profile_timer_);
+    UpdateVelocity();
+}
+
+MotionProfile::SAMPLE MotorDriver::UpdateVelocity() {
+    MotionProfile::SAMPLE sample = motion_profile_.Sample((MonotonicClock::NowUs() - profile_start_time_us_) / 1000000.0f);
+    register_cache_.Set(TMC2209_REGISTER::VACTUAL, VelocityToVactual(sample.VELOCITY));
+    FlushRegisters(false);
+    return sample;
+}
+
+uint32_t MotorDriver::VelocityToVactual(float velocity) {
+    using namespace CONFIG_SET;
+    float vactual = velocity * (float(1UL << 24) / MOTOR_DRIVER_CLOCK_HZ);
+    if (vactual >= MOTOR_DRIVER_MAX_SPEED) {
+        return MOTOR_DRIVER_MAX_SPEED;
+    }
+    return (vactual > 0) ? uint32_t(vactual) : 0;
 }
 
 void IRAM_ATTR MotorDriver::InterruptForIndex() {
-    current_step_ += (direction_) ? full_rot_step_count_ : -full_rot_step_count_;
+    // the interrupt is the only writer, reading back its own value never spins
+    INDEX_STATE index_state = index_state_.Read();
+    index_state.PULSE_COUNT += direction_.load(std::memory_order_relaxed) ? 1 : -1;
+    index_state.LAST_PULSE_TIME_US = uint32_t(MonotonicClock::NowUs());
+    index_state_.Write(index_state);
+    NotifyHandlerFromISR(EVENT_INDEX);
+}
+
+void IRAM_ATTR MotorDriver::InterruptForProfileTick() {
+    profile_tick_time_us_.store(uint32_t(MonotonicClock::NowUs()), std::memory_order_relaxed);
+    NotifyHandlerFromISR(EVENT_PROFILE_TICK);
+}
+
+void IRAM_ATTR MotorDriver::InterruptForStall() {
+    NotifyHandlerFromISR(EVENT_STALL);
+}
+
+void MotorDriver::StopJog() {
+    jog_stop_requested_ = true;
+    NotifyHandler(EVENT_CANCEL);
 }
 
 bool MotorDriver::CancelCurrentRequest() {
     using namespace CONFIG_SET;
-    logger_->Log(LOG_TYPE::INFO, LOG_CLASS::MOTOR_DRIVER, "Cancelling Request");
-    stop_requested_ = is_motor_running_;
+    logger_->Log(LOG_TYPE::INFO, LOG_CLASS::MOTOR_DRIVER, LOG_FORMAT("Cancelling Request"));
+    {
+        std::lock_guard<std::mutex> lock(mailbox_mutex_);
+        if (mailbox_.AVAILABLE) {
+            PushFeedback(mailbox_.ID, MOTION_RESULT::CANCELLED);
+            mailbox_.AVAILABLE = false;
+        }
+    }
+    stop_requested_ = is_motor_running_.load();
+    NotifyHandler(EVENT_CANCEL);
+    return stop_requested_;
 }
 
 void MotorDriver::StopHandler() {
     keep_handler_running_ = false;
+    NotifyHandler(EVENT_STOP_HANDLER);
     handler_thread_->join();
 }
 
 void MotorDriver::StartHandler() {
+    // set before the thread starts so that requests right after construction
+    // are not rejected
+    keep_handler_running_ = true;
     handler_thread_.reset(new std::thread(&MotorDriver::Handler, this));
 }
 
 void MotorDriver::Handler() {
     using namespace CONFIG_SET;
-    logger_->Log(LOG_TYPE::INFO, LOG_CLASS::MOTOR_DRIVER, "Starting handler");
+    logger_->Log(LOG_TYPE::INFO, LOG_CLASS::MOTOR_DRIVER, LOG_FORMAT("Starting handler"));
     keep_handler_running_ = true;
+    // a stop meant for the jog of a previous instance
+    jog_stop_requested_ = false;
+    handler_task_ = xTaskGetCurrentTaskHandle();
 
+    uint32_t events = 0;
     while (keep_handler_running_) {
         using namespace CONFIG_SET;
+        LatencyTimer iteration_timer(LATENCY_PROBE::MOTOR_HANDLER);
+        HandlePercentMapUpdate();
+        HandleNewRequest();
+        HandleJogStop();
         if (is_motor_running_) {
-            bool current_step_out_of_bound = (current_step_ < 0) || (current_step_ > calib_params_.TOTAL_STEP_COUNT);
+            MotionProfile::SAMPLE sample = UpdateVelocity();
+            bool read_driver =
+                sample.FINISHED || (MonotonicClock::NowUs() - last_mscnt_read_us_) >= POSITION_ESTIMATOR_READ_INTERVAL_US;
+            // the estimate holds from the first sign of a stall on, also during
+            // the blank time in which a stall does not stop the move yet
+            position_estimator_.SetStalled(digitalRead(PIN_MD_DIAG) ||
+                                           (last_sg_result_cruising_ &&
+                                            last_sg_result_ <= 2 * calib_params_.SG_THRESHOLD));
+            SyncPosition(read_driver, GetCommandedTravel());
+            if (read_driver && stallguard_sampling_ && !sample.FINISHED && std::fabs(sample.ACCELERATION) < 1.0f) {
+                // only cruise is sampled, load readings during ramps and creep
+                // are not representative
+                SampleStallGuard();
+            }
+            PollDriverLoad(sample);
+            SampleTelemetry(sample.VELOCITY);
+
+            // a traversal may run past the calibrated end, the end stop
+            // measured on stall corrects the calibration
+            bool current_step_out_of_bound =
+                (current_step_ < 0 && !(blind_traversal_requested_ && !direction_)) ||
+                (current_step_ > calib_params_.TOTAL_STEP_COUNT && !(blind_traversal_requested_ && direction_));
             if (current_step_out_of_bound) {
-                current_step_ = (current_step_ < 0) ? 0 : calib_params_.TOTAL_STEP_COUNT;
+                SetCurrentStep((current_step_ < 0) ? 0 : calib_params_.TOTAL_STEP_COUNT);
+            }
+
+            int remaining_steps = direction_ ? (expected_step_ - current_step_) : (current_step_ - expected_step_);
+            bool step_exceeded_bounds = remaining_steps < -STEP_STOP_WINDOW;
+            if (!retarget_pending_ && !blind_traversal_requested_ && sample.FINISHED &&
+                remaining_steps > STEP_STOP_WINDOW && target_corrections_ < MAX_TARGET_CORRECTIONS) {
+                // landed short (e.g. driver clock tolerance), plan the rest of
+                // the move right away instead of a separate corrective move
+                logger_->Log(LOG_TYPE::INFO, LOG_CLASS::MOTOR_DRIVER, LOG_FORMAT("Correcting Destination"));
+                target_corrections_++;
+                commanded_travel_base_ += motion_profile_.GetDistance();
+                PlanMotion(0);
+                profile_start_time_us_ = MonotonicClock::NowUs();
+                timerAlarmEnable(profile_timer_);
+                sample = UpdateVelocity();
+            } else if (sample.FINISHED) {
+                // velocity is constant from here on, no more profile ticks needed
+                timerAlarmDisable(profile_timer_);
             }
 
             bool reached_destination = false;
-            bool step_in_limit = (current_step_ < (1 + STEP_FRACTION_ALLOWANCE) * expected_step_ &&
-                                  (current_step_ > (1 - STEP_FRACTION_ALLOWANCE) * expected_step_));
-            bool step_exceeded_bounds =
-                (direction_ && current_step_ > (1 + STEP_FRACTION_ALLOWANCE) * expected_step_) ||
-                (!direction_ && current_step_ < (1 - STEP_FRACTION_ALLOWANCE) * expected_step_);
-
-            if (!blind_traversal_requested_ && (step_in_limit || step_exceeded_bounds)) {
-                logger_->Log(LOG_TYPE::INFO, LOG_CLASS::MOTOR_DRIVER, "Reached Destination");
+            if (retarget_pending_) {
+                // stopping for a reversal, the old target does not matter
+                reached_destination = sample.FINISHED;
+            } else if (!blind_traversal_requested_ && (sample.FINISHED || step_exceeded_bounds)) {
+                logger_->Log(LOG_TYPE::INFO, LOG_CLASS::MOTOR_DRIVER, LOG_FORMAT("Reached Destination"));
                 reached_destination = !blind_traversal_requested_;
             }
+            // DIAG is level triggered, an edge during blank time is caught by
+            // reading the pin on the blank time deadline
+            unsigned long running_time_ms = (MonotonicClock::NowUs() - move_start_time_us_) / 1000;
             bool stall_detected = false;
-            if ((std::time(nullptr) - last_motor_start_time_sec_) > 0.05) {
-                stall_detected = digitalRead(PIN_MD_DIAG);
+            if (running_time_ms >= MOTOR_STALL_BLANK_TIME_MS) {
+                stall_detected = (events & EVENT_STALL) || digitalRead(PIN_MD_DIAG);
             }
-            bool end_timer_reached = (std::time(nullptr) - last_motor_start_time_sec_) > MOTOR_STOP_TIME_SEC;
+            bool end_timer_reached = running_time_ms >= (unsigned long)MOTOR_STOP_TIME_SEC * 1000;
             if (stall_detected || reached_destination || end_timer_reached || stop_requested_) {
+                MOTION_RESULT result = MOTION_RESULT::COMPLETED;
+                if (stop_requested_) {
+                    result = MOTION_RESULT::CANCELLED;
+                } else if (stall_detected && !blind_traversal_requested_) {
+                    // traversals are meant to end on the end stop
+                    result = MOTION_RESULT::STALLED;
+                } else if (end_timer_reached && !stall_detected && !reached_destination) {
+                    result = MOTION_RESULT::TIMED_OUT;
+                }
                 StopMotor();
+                TELEMETRY_EVENT stop_reason = TELEMETRY_EVENT::STOP_DESTINATION;
+                if (stop_requested_) {
+                    stop_reason = TELEMETRY_EVENT::STOP_CANCEL;
+                } else if (stall_detected) {
+                    stop_reason = TELEMETRY_EVENT::STOP_STALL;
+                } else if (end_timer_reached && !reached_destination) {
+                    stop_reason = TELEMETRY_EVENT::STOP_TIMEOUT;
+                } else if (retarget_pending_) {
+                    stop_reason = TELEMETRY_EVENT::STOP_RETARGET;
+                }
+                RecordTelemetry(stop_reason, 0);
+                int total_step_count = 0;
+                if (stall_detected && blind_traversal_requested_ && !stop_requested_ && !retarget_pending_) {
+                    total_step_count = UpdateEndStop();
+                }
                 expected_step_ = current_step_;
-                stop_requested_ = false;
                 blind_traversal_requested_ = false;
+                creep_requested_ = false;
+                jog_requested_ = false;
+                PushFeedback(active_request_id_, result, total_step_count);
+                active_request_id_ = 0;
+                if (retarget_pending_) {
+                    if (stop_requested_ || stall_detected || end_timer_reached) {
+                        PushFeedback(pending_target_.ID,
+                                     (result == MOTION_RESULT::COMPLETED) ? MOTION_RESULT::STALLED : result);
+                    } else {
+                        MOTION_TARGET target = pending_target_;
+                        if (!target.TRAVERSAL) {
+                            target.DIRECTION = target.EXPECTED_STEP > current_step_;
+                        }
+                        ApplyTarget(target);
+                    }
+                    retarget_pending_ = false;
+                }
+                stop_requested_ = false;
             }
         }
         if (!is_motor_running_ && (expected_step_ != current_step_ || blind_traversal_requested_)) {
             StartMotor();
         }
-        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        if (!is_motor_running_ && active_request_id_ != 0) {
+            // already at the requested step
+            PushFeedback(active_request_id_, MOTION_RESULT::COMPLETED);
+            active_request_id_ = 0;
+        }
+        PublishState();
+        iteration_timer.Stop();
+        events = 0;
+        xTaskNotifyWait(0, 0xFFFFFFFF, &events, GetHandlerTimeout());
+        if (events & EVENT_PROFILE_TICK) {
+            // wrap around safe, ticks are far less than 71 minutes apart
+            Latency::Add(LATENCY_PROBE::MOTOR_LATENESS,
+                         uint32_t(MonotonicClock::NowUs()) - profile_tick_time_us_.load(std::memory_order_relaxed));
+        }
     }
-    logger_->Log(LOG_TYPE::INFO, LOG_CLASS::MOTOR_DRIVER, "Exiting handler");
+    handler_task_ = NULL;
+    logger_->Log(LOG_TYPE::INFO, LOG_CLASS::MOTOR_DRIVER, LOG_FORMAT("Exiting handler"));
+}
+
+TickType_t MotorDriver::GetHandlerTimeout() {
+    using namespace CONFIG_SET;
+    if (!is_motor_running_) {
+        return portMAX_DELAY;
+    }
+    unsigned long running_time_ms = (MonotonicClock::NowUs() - move_start_time_us_) / 1000;
+    unsigned long deadline_ms = (unsigned long)MOTOR_STOP_TIME_SEC * 1000;
+    if (running_time_ms < MOTOR_STALL_BLANK_TIME_MS) {
+        deadline_ms = MOTOR_STALL_BLANK_TIME_MS;
+    }
+    if (running_time_ms >= deadline_ms) {
+        return 0;
+    }
+    return pdMS_TO_TICKS(deadline_ms - running_time_ms) + 1;
+}
+
+void MotorDriver::NotifyHandler(uint32_t event) {
+    TaskHandle_t handler_task = handler_task_;
+    if (handler_task != NULL) {
+        xTaskNotify(handler_task, event, eSetBits);
+    }
+}
+
+void IRAM_ATTR MotorDriver::NotifyHandlerFromISR(uint32_t event) {
+    TaskHandle_t handler_task = handler_task_;
+    if (handler_task == NULL) {
+        return;
+    }
+    BaseType_t higher_priority_task_woken = pdFALSE;
+    xTaskNotifyFromISR(handler_task, event, eSetBits, &higher_priority_task_woken);
+    if (higher_priority_task_woken) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+void MotorDriver::StartStallGuardSampling() {
+    std::lock_guard<std::mutex> lock(stallguard_mutex_);
+    std::fill(std::begin(stallguard_histogram_), std::end(stallguard_histogram_), 0);
+    stallguard_sample_count_ = 0;
+    stallguard_sampling_ = true;
+}
+
+void MotorDriver::SampleStallGuard() {
+    using namespace CONFIG_SET;
+    uint16_t sg_result = s_TimeTransaction([this]() { return this->SG_RESULT(); });
+    last_sg_result_ = sg_result;
+    last_sg_result_cruising_ = true;
+    int bin = (int(sg_result) * STALLGUARD_HISTOGRAM_BINS) / (STALLGUARD_RESULT_MAX + 1);
+    std::lock_guard<std::mutex> lock(stallguard_mutex_);
+    stallguard_histogram_[std::min(bin, STALLGUARD_HISTOGRAM_BINS - 1)]++;
+    stallguard_sample_count_++;
+}
+
+CONFIG_SET::STALLGUARD_TUNING MotorDriver::GetStallGuardTuning() {
+    using namespace CONFIG_SET;
+    STALLGUARD_TUNING tuning;
+    std::lock_guard<std::mutex> lock(stallguard_mutex_);
+    tuning.SAMPLE_COUNT = stallguard_sample_count_;
+    if (stallguard_sample_count_ < STALLGUARD_MIN_SAMPLES) {
+        return tuning;
+    }
+    // low percentile instead of minimum, the few readings while running into
+    // the end stop must not drag the reference down
+    int percentile_count = int(stallguard_sample_count_ * STALLGUARD_PERCENTILE);
+    int bin = 0;
+    int accumulated = stallguard_histogram_[0];
+    while (accumulated <= percentile_count && bin < STALLGUARD_HISTOGRAM_BINS - 1) {
+        bin++;
+        accumulated += stallguard_histogram_[bin];
+    }
+    // lower edge of the bin, errs on the side of a lower (safer) threshold
+    tuning.REFERENCE = (bin * (STALLGUARD_RESULT_MAX + 1)) / STALLGUARD_HISTOGRAM_BINS;
+    tuning.THRESHOLD = std::max(1, std::min(255, int(tuning.REFERENCE * (1 - STALLGUARD_MARGIN_FRACTION) / 2)));
+    tuning.MARGIN = tuning.REFERENCE - 2 * tuning.THRESHOLD;
+    tuning.VALID = tuning.REFERENCE > 0;
+    return tuning;
+}
+
+int MotorDriver::UpdateEndStop() {
+    using namespace CONFIG_SET;
+    int total_step_count = calib_params_.TOTAL_STEP_COUNT;
+    if (total_step_count == INT_MAX) {
+        // not calibrated yet, e.g. while calibrating
+        return 0;
+    }
+    // positive if the end stop came early
+    int drift = direction_ ? (total_step_count - current_step_) : current_step_;
+    if (std::abs(drift) <= STEP_STOP_WINDOW) {
+        SetCurrentStep(direction_ ? total_step_count : 0);
+        return 0;
+    }
+    if (std::abs(drift) > total_step_count * END_STOP_MAX_DRIFT_FRACTION) {
+        logger_->Log(LOG_TYPE::WARN, LOG_CLASS::MOTOR_DRIVER,
+                     LOG_FORMAT("Stalled away from end stop, calibration kept"));
+        return 0;
+    }
+    calib_params_.TOTAL_STEP_COUNT = direction_ ? current_step_ : (total_step_count - current_step_);
+    percent_map_.Build(calib_params_.PERCENT_MAP, PERCENT_MAP_KNOTS, calib_params_.TOTAL_STEP_COUNT);
+    SetCurrentStep(direction_ ? calib_params_.TOTAL_STEP_COUNT : 0);
+    logger_->Log(LOG_TYPE::INFO, LOG_CLASS::MOTOR_DRIVER, LOG_FORMAT("End stop moved, total steps: %d"),
+                 calib_params_.TOTAL_STEP_COUNT);
+    return calib_params_.TOTAL_STEP_COUNT;
+}
+
+void MotorDriver::PollDriverLoad(const MotionProfile::SAMPLE& sample) {
+    using namespace CONFIG_SET;
+    if ((MonotonicClock::NowUs() - last_load_poll_us_) < SPEED_SCHEDULER_POLL_INTERVAL_US) {
+        return;
+    }
+    last_load_poll_us_ = MonotonicClock::NowUs();
+    uint32_t drv_status = s_TimeTransaction([this]() { return this->DRV_STATUS(); });
+    last_sg_result_ = s_TimeTransaction([this]() { return this->SG_RESULT(); });
+    last_cs_actual_ = RegisterCache::Extract(TMC2209_REGISTER::CS_ACTUAL, drv_status);
+
+    // load readings are only comparable at constant velocity
+    bool cruising = !sample.FINISHED && std::fabs(sample.ACCELERATION) < 1.0f && !creep_requested_ &&
+                    !retarget_pending_ && sample.VELOCITY >= planned_cruise_velocity_ - 1.0f;
+    last_sg_result_cruising_ = cruising;
+    SpeedScheduler::DRIVER_LOAD load;
+    load.OVERTEMP = RegisterCache::Extract(TMC2209_REGISTER::OT, drv_status);
+    load.OVERTEMP_PREWARNING = RegisterCache::Extract(TMC2209_REGISTER::OTPW, drv_status);
+    load.LOAD_VALID = cruising;
+    load.SG_RESULT = last_sg_result_;
+    load.CS_ACTUAL = last_cs_actual_;
+    if (load.OVERTEMP || load.OVERTEMP_PREWARNING) {
+        if (load.OVERTEMP) {
+            logger_->Log(LOG_TYPE::WARN, LOG_CLASS::MOTOR_DRIVER, LOG_FORMAT("Driver Overtemperature"));
+        } else {
+            logger_->Log(LOG_TYPE::WARN, LOG_CLASS::MOTOR_DRIVER, LOG_FORMAT("Driver Hot"));
+        }
+    }
+    float velocity = speed_scheduler_->Update(load, MonotonicClock::NowUs());
+    if (cruising && std::fabs(velocity - planned_cruise_velocity_) >= 1.0f) {
+        // bend the running profile onto the new cruise velocity, same target
+        commanded_travel_base_ += sample.POSITION;
+        profile_start_time_us_ = MonotonicClock::NowUs();
+        PlanMotion(sample.VELOCITY);
+    }
+}
+
+void MotorDriver::SampleTelemetry(float velocity) {
+    using namespace CONFIG_SET;
+    if (!telemetry_ || (MonotonicClock::NowUs() - last_telemetry_us_) < TELEMETRY_SAMPLE_INTERVAL_US) {
+        return;
+    }
+    last_telemetry_us_ = MonotonicClock::NowUs();
+    RecordTelemetry(TELEMETRY_EVENT::SAMPLE, velocity);
+}
+
+void MotorDriver::RecordTelemetry(TELEMETRY_EVENT event, float velocity) {
+    if (!telemetry_) {
+        return;
+    }
+    TELEMETRY_RECORD record;
+    record.TIME_US = uint32_t(MonotonicClock::NowUs());
+    record.STEP = current_step_;
+    record.VELOCITY = int16_t(direction_ ? velocity : -velocity);
+    record.SG_RESULT = last_sg_result_;
+    record.CS_ACTUAL = last_cs_actual_;
+    record.EVENT = event;
+    record.MOVE_ID = telemetry_move_id_;
+    telemetry_->Record(record);
+}
+
+CONFIG_SET::MOTOR_STATE MotorDriver::GetState() {
+    return state_.Read();
 }
 
 int MotorDriver::GetSteps() {
-    return current_step_;
+    return GetState().STEP;
 }
 
 void MotorDriver::ResetSteps() {
-    current_step_ = 0;
+    SetCurrentStep(0);
+    PublishState();
+}
+
+float MotorDriver::GetCommandedTravel() {
+    return commanded_travel_base_ + motion_profile_.Sample((MonotonicClock::NowUs() - profile_start_time_us_) / 1000000.0f).POSITION;
+}
+
+void MotorDriver::SyncPosition(bool read_driver, float commanded_travel) {
+    if (read_driver) {
+        // MSCNT first, the estimator expects the pulse count to be newer
+        uint16_t mscnt = s_TimeTransaction([this]() { return this->MSCNT(); });
+        current_step_ = position_estimator_.Update(index_state_.Read().PULSE_COUNT, mscnt, commanded_travel);
+        last_mscnt_read_us_ = MonotonicClock::NowUs();
+    } else {
+        current_step_ = position_estimator_.Predict(commanded_travel);
+    }
+}
+
+void MotorDriver::SetCurrentStep(int step) {
+    position_estimator_.SetStep(step);
+    current_step_ = step;
+}
+
+void MotorDriver::PublishState() {
+    CONFIG_SET::MOTOR_STATE state;
+    state.STEP = current_step_;
+    state.TOTAL_STEP_COUNT = calib_params_.TOTAL_STEP_COUNT;
+    state.PERCENTAGE = percent_map_.PercentFromStep(current_step_);
+    state.DIRECTION = direction_;
+    state.RUNNING = is_motor_running_;
+    state.LAST_PULSE_TIME_US = index_state_.Read().LAST_PULSE_TIME_US;
+    state_.Write(state);
+    if (state.RUNNING != published_running_) {
+        published_running_ = state.RUNNING;
+        PostEvent(CONFIG_SET::CONTROLLER_EVENT_TYPE::MOTOR_STATE, state.RUNNING);
+    }
+}
+
+void MotorDriver::PostEvent(CONFIG_SET::CONTROLLER_EVENT_TYPE type, int value) {
+    if (!event_queue_) {
+        return;
+    }
+    CONFIG_SET::CONTROLLER_EVENT event;
+    event.TYPE = type;
+    event.VALUE = value;
+    event_queue_->Post(event);
 }
 
 int MotorDriver::GetPercentage() {
-    return (float(current_step_) / calib_params_.TOTAL_STEP_COUNT) * 100;
+    return GetState().PERCENTAGE;
 }
@@ -21,12 +21,63 @@
 #include <HardwareSerial.h>
 #include <TMCStepper.h>
 
+#include <atomic>
 #include <ctime>
 #include <memory>
+#include <mutex>
 #include <thread>
+#include <tuple>
 
 #include "../config/config.h"
+#include "../event_queue/event_queue.h"
 #include "../logging/logging.h"
+#include "../motion_profile/motion_profile.h"
+#include "../percent_map/percent_map.h"
+#include "../position_estimator/position_estimator.h"
+#include "../register_cache/register_cache.h"
+#include "../seqlock/seqlock.h"
+#include "../speed_scheduler/speed_scheduler.h"
+#include "../telemetry/telemetry.h"
+
+/**
+ * @brief TMC2209 registers and fields written by the motor driver, see TMC2209
+ * datasheet
+ *
+ */
+namespace TMC2209_REGISTER {
+const uint8_t GCONF = 0x00;
+const uint8_t IHOLD_IRUN = 0x10;
+const uint8_t TPOWERDOWN = 0x11;
+const uint8_t TCOOLTHRS = 0x14;
+const uint8_t VACTUAL = 0x22;
+const uint8_t SGTHRS = 0x40;
+const uint8_t COOLCONF = 0x42;
+const uint8_t CHOPCONF = 0x6C;
+const uint8_t DRV_STATUS = 0x6F;
+
+// same power on defaults as TMCStepper
+const uint32_t GCONF_DEFAULT = 0x00000101;  // I_scale_analog, multistep_filt
+const uint32_t IHOLD_IRUN_DEFAULT = 0x00010000;
+const uint32_t TPOWERDOWN_DEFAULT = 20;
+const uint32_t CHOPCONF_DEFAULT = 0x10000053;
+
+const RegisterCache::FIELD SHAFT = {GCONF, 3, 1};
+const RegisterCache::FIELD PDN_DISABLE = {GCONF, 6, 1};
+const RegisterCache::FIELD MSTEP_REG_SELECT = {GCONF, 7, 1};
+const RegisterCache::FIELD IHOLD = {IHOLD_IRUN, 0, 5};
+const RegisterCache::FIELD IRUN = {IHOLD_IRUN, 8, 5};
+const RegisterCache::FIELD IHOLDDELAY = {IHOLD_IRUN, 16, 4};
+const RegisterCache::FIELD SEMIN = {COOLCONF, 0, 4};
+const RegisterCache::FIELD SEMAX = {COOLCONF, 8, 4};
+const RegisterCache::FIELD SEDN = {COOLCONF, 13, 2};
+const RegisterCache::FIELD TOFF = {CHOPCONF, 0, 4};
+const RegisterCache::FIELD TBL = {CHOPCONF, 15, 2};
+const RegisterCache::FIELD VSENSE = {CHOPCONF, 17, 1};
+const RegisterCache::FIELD MRES = {CHOPCONF, 24, 4};
+const RegisterCache::FIELD OTPW = {DRV_STATUS, 0, 1};
+const RegisterCache::FIELD OT = {DRV_STATUS, 1, 1};
+const RegisterCache::FIELD CS_ACTUAL = {DRV_STATUS, 16, 5};
+}  // namespace TMC2209_REGISTER
 
 class MotorDriver : private TMC2209Stepper {
    public:
@@ -37,10 +88,14 @@ class MotorDriver : private TMC2209Stepper {
     MotorDriver(std::shared_ptr<Logging>& logging);
 
     /**
-   * @brief Initializes motor drive TMC2209, and required pins
+   * @brief Initializes motor drive TMC2209, and required pins, moves are
+   * recorded into telemetry if given, motion feedback and motor start / stop
+   * are posted to the event queue if given
    *
    */
-    MotorDriver(std::shared_ptr<Logging>& logging, CONFIG_SET::CALIB_PARAMS calib_param);
+    MotorDriver(std::shared_ptr<Logging>& logging, CONFIG_SET::CALIB_PARAMS calib_param,
+                std::shared_ptr<TelemetryRecorder> telemetry = nullptr,
+                std::shared_ptr<EventQueue> event_queue = nullptr);
 
     /**
    * @brief Cleans and disables motor driver
@@ -57,6 +112,14 @@ class MotorDriver : private TMC2209Stepper {
    */
     CONFIG_SET::DRIVER_STATUS GetStatus();
 
+    /**
+   * @brief Returns one consistent snapshot of step, direction, running and
+   * last INDEX pulse time, never blocks
+   *
+   * @return CONFIG_SET::MOTOR_STATE
+   */
+    CONFIG_SET::MOTOR_STATE GetState();
+
     /**
    * @brief Returns the current steps of motor
    *
@@ -73,13 +136,23 @@ class MotorDriver : private TMC2209Stepper {
 
     /**
    * @brief This is the primary contact function for external requests, it will
-   * handle all requests from the controller or anywhere else, run the thread
-   * for supplying steps
+   * handle all requests from the controller or anywhere else. The request is
+   * posted to a single slot mailbox read by the handler, a request arriving
+   * while the motor is running retargets the running move, requests arriving
+   * faster than the handler picks them are coalesced (latest wins)
    *
-   * @return true : request accepted
-   * @return false : rejected
+   * @return uint32_t : id of the request, reported back by
+   * GetMotionFeedback(), 0 if rejected
    */
-    bool FulfillRequest(CONFIG_SET::MOTION_REQUEST request);
+    uint32_t FulfillRequest(CONFIG_SET::MOTION_REQUEST request);
+
+    /**
+   * @brief Get the oldest unread result of a request
+   *
+   * @return std::tuple<bool, CONFIG_SET::MOTION_FEEDBACK>: bool returning if
+   * there is a feedback available, the feedback itself
+   */
+    std::tuple<bool, CONFIG_SET::MOTION_FEEDBACK> GetMotionFeedback();
 
     /**
    * @brief Cancels current request
@@ -89,6 +162,31 @@ class MotorDriver : private TMC2209Stepper {
    */
     bool CancelCurrentRequest();
 
+    /**
+   * @brief Ends a jog, i.e. a move requested with JOG set: a running jog
+   * decelerates to standstill, a jog not yet picked by the handler is
+   * cancelled. Never blocks and needs no instance, so that a button release
+   * stops the motor straight from the button analyser
+   *
+   */
+    static void StopJog();
+
+    /**
+   * @brief Clears collected SG_RESULT samples and starts sampling SG_RESULT
+   * while the motor cruises
+   *
+   */
+    void StartStallGuardSampling();
+
+    /**
+   * @brief Derives a StallGuard threshold and margin from the SG_RESULT
+   * samples collected since StartStallGuardSampling()
+   *
+   * @return CONFIG_SET::STALLGUARD_TUNING : VALID is false if not enough
+   * samples were collected
+   */
+    CONFIG_SET::STALLGUARD_TUNING GetStallGuardTuning();
+
     /**
    * @brief Updates calibration parameters to be used by motor driver
    *
@@ -96,11 +194,34 @@ class MotorDriver : private TMC2209Stepper {
     void UpdateCalibParams(CONFIG_SET::CALIB_PARAMS calib_param);
 
     /**
-   * @brief Runs on a timer, supplies step and direction signal to motor driver
+   * @brief Replaces the percent map knots, e.g. after a user mark, picked up
+   * by the handler before the next request
+   *
+   * @param knots: CONFIG_SET::PERCENT_MAP_KNOTS step fractions, all zero for
+   * linear
+   */
+    void UpdatePercentMap(const uint16_t* knots);
+
+    /**
+   * @brief Runs on every INDEX pulse of the driver, updates the current step
    *
    */
     static void InterruptForIndex();
 
+    /**
+   * @brief Runs on the profile timer, wakes up the handler for the next
+   * velocity update of the motion profile
+   *
+   */
+    static void InterruptForProfileTick();
+
+    /**
+   * @brief Runs on the rising edge of DIAG pin, i.e. when the driver detects a
+   * stall, wakes up the handler
+   *
+   */
+    static void InterruptForStall();
+
     /**
    * @brief Stop handler thread
    *
@@ -112,17 +233,105 @@ class MotorDriver : private TMC2209Stepper {
     CONFIG_SET::CALIB_PARAMS calib_params_;
 
     std::shared_ptr<Logging> logger_;
+    std::shared_ptr<TelemetryRecorder> telemetry_;
+    std::shared_ptr<EventQueue> event_queue_;
+    bool published_running_ = false;
 
-    bool is_motor_running_ = false;
-    hw_timer_t* step_timer_ = NULL;
+    std::atomic<bool> is_motor_running_{false};
+    hw_timer_t* profile_timer_ = NULL;
+    static TaskHandle_t handler_task_;
+    MotionProfile motion_profile_;
+    PositionEstimator position_estimator_;
+    float commanded_travel_base_ = 0;
+    int target_corrections_ = 0;
+    int64_t move_start_time_us_ = 0;
+    int64_t profile_start_time_us_ = 0;
+    int64_t last_mscnt_read_us_ = 0;
+    RegisterCache register_cache_;
+    uint8_t expected_ifcnt_ = 0;
     int expected_step_ = 0;
     bool blind_traversal_requested_ = false;
-    bool stop_requested_ = false;
-    bool keep_handler_running_ = false;
-    static int full_rot_step_count_;
-    static int current_step_;
-    static bool direction_;
-    std::time_t last_motor_start_time_sec_ = std::time(nullptr);
+    bool creep_requested_ = false;
+    bool jog_requested_ = false;
+    std::atomic<bool> stop_requested_{false};
+    std::atomic<bool> keep_handler_running_{false};
+
+    /**
+   * @brief Resolved motion request, i.e. expected step and direction
+   *
+   */
+    struct MOTION_TARGET {
+        int EXPECTED_STEP = 0;
+        bool TRAVERSAL = false;
+        bool CREEP = false;
+        bool JOG = false;
+        bool DIRECTION = false;
+        uint32_t ID = 0;
+    };
+
+    /**
+   * @brief Single slot for the latest request not yet picked by the handler
+   *
+   */
+    struct MAILBOX {
+        bool AVAILABLE = false;
+        CONFIG_SET::MOTION_REQUEST REQUEST;
+        uint32_t ID = 0;
+    };
+    MAILBOX mailbox_;
+    std::mutex mailbox_mutex_;
+    std::atomic<uint32_t> last_request_id_{0};
+    uint32_t active_request_id_ = 0;
+    MOTION_TARGET pending_target_;
+    bool retarget_pending_ = false;
+
+    static const int STALLGUARD_RESULT_MAX = 510;
+    std::atomic<bool> stallguard_sampling_{false};
+    int stallguard_histogram_[CONFIG_SET::STALLGUARD_HISTOGRAM_BINS] = {0};
+    int stallguard_sample_count_ = 0;
+    std::mutex stallguard_mutex_;
+
+    int64_t last_telemetry_us_ = 0;
+    uint16_t telemetry_move_id_ = 0;
+
+    std::unique_ptr<SpeedScheduler> speed_scheduler_{nullptr};
+    float planned_cruise_velocity_ = 0;
+    int64_t last_load_poll_us_ = 0;
+    uint16_t last_sg_result_ = 0;
+    bool last_sg_result_cruising_ = false;  // only then SG_RESULT tells a stall
+    uint8_t last_cs_actual_ = 0;
+
+    // percent_map_ is owned by the handler thread, updates from other threads
+    // go through the pending knots
+    PercentMap percent_map_;
+    uint16_t pending_percent_map_[CONFIG_SET::PERCENT_MAP_KNOTS] = {0};
+    std::atomic<bool> percent_map_pending_{false};
+    std::mutex percent_map_mutex_;
+
+    CONFIG_SET::MOTION_FEEDBACK feedback_queue_[CONFIG_SET::MOTION_FEEDBACK_QUEUE_SIZE];
+    int feedback_tail_ = 0;
+    int feedback_count_ = 0;
+    std::mutex feedback_mutex_;
+
+    /**
+   * @brief INDEX pulses counted by the interrupt, published through a seqlock
+   * with the interrupt as its only writer
+   *
+   */
+    struct INDEX_STATE {
+        int32_t PULSE_COUNT;
+        uint32_t LAST_PULSE_TIME_US;
+    };
+    static SeqLock<INDEX_STATE> index_state_;
+    // time of the last profile tick interrupt, lower 32 bit of MonotonicClock
+    static std::atomic<uint32_t> profile_tick_time_us_;
+    static std::atomic<bool> direction_;
+    static std::atomic<bool> jog_stop_requested_;
+
+    // current_step_ is owned by the handler thread, other threads read the
+    // published state_ instead
+    int current_step_ = 0;
+    SeqLock<CONFIG_SET::MOTOR_STATE> state_;
     std::unique_ptr<std::thread> handler_thread_{nullptr};
 
     /**
@@ -135,6 +344,37 @@ class MotorDriver : private TMC2209Stepper {
    */
     void Handler();
 
+    // Handler wake up reasons, delivered as task notification bits
+    static const uint32_t EVENT_NEW_REQUEST = 1 << 0;
+    static const uint32_t EVENT_CANCEL = 1 << 1;
+    static const uint32_t EVENT_INDEX = 1 << 2;
+    static const uint32_t EVENT_STALL = 1 << 3;
+    static const uint32_t EVENT_PROFILE_TICK = 1 << 4;
+    static const uint32_t EVENT_STOP_HANDLER = 1 << 5;
+    static const uint32_t EVENT_PERCENT_MAP = 1 << 6;
+
+    /**
+   * @brief Wakes up the handler from task context
+   *
+   * @param event: one of the EVENT_* bits
+   */
+    static void NotifyHandler(uint32_t event);
+
+    /**
+   * @brief Wakes up the handler from an interrupt
+   *
+   * @param event: one of the EVENT_* bits
+   */
+    static void NotifyHandlerFromISR(uint32_t event);
+
+    /**
+   * @brief Returns how long the handler may block waiting for an event, i.e.
+   * forever when idle, otherwise until the next stall blank time or timer
+   * limit deadline of the running move
+   *
+   */
+    TickType_t GetHandlerTimeout();
+
     /**
    * @brief Enable Motor Driver
    * Give argument as true for enabling, false for disabling the driver
@@ -149,6 +389,30 @@ class MotorDriver : private TMC2209Stepper {
    */
     void InitializeDriver();
 
+    /**
+   * @brief Adds the written registers to register_cache_, VACTUAL is added
+   * last so that a batch always configures before it moves
+   *
+   */
+    void SetupRegisterCache();
+
+    /**
+   * @brief Stages IRUN, IHOLD and VSENSE for the given RMS current, same
+   * scaling as TMCStepper::rms_current()
+   *
+   */
+    void SetRunCurrent(uint16_t milliamps);
+
+    /**
+   * @brief Writes the staged registers which changed since the last flush
+   *
+   * @param verify: true for checking IFCNT and reading back the readable
+   * registers, mismatching registers are written again on the next flush
+   * @return true : if all writes were verified or verification was not asked
+   * @return false : otherwise
+   */
+    bool FlushRegisters(bool verify);
+
     /**
    * @brief Responsible for starting the motor, i.e. setups the driver and sets
    * required velocity of motor
@@ -163,6 +427,126 @@ class MotorDriver : private TMC2209Stepper {
    */
     void StopMotor();
 
+    /**
+   * @brief Plans the motion profile from the current step to the expected
+   * step, blind traversals are planned to creep into the end stop
+   *
+   * @param start_velocity: current velocity, non-zero when retargeting
+   */
+    void PlanMotion(float start_velocity);
+
+    /**
+   * @brief Returns the kinematic limits from config, with the cruise velocity
+   * from the speed scheduler
+   *
+   * @param creep: true for limiting the velocity to creep velocity
+   */
+    MotionProfile::LIMITS GetMotionLimits(bool creep = false);
+
+    /**
+   * @brief Returns the distance left from the current step to the target,
+   * negative if the target is behind with respect to its direction
+   *
+   */
+    float GetRemainingDistance(const MOTION_TARGET& target);
+
+    /**
+   * @brief Resolves a request into expected step and direction, from the
+   * current step
+   *
+   */
+    MOTION_TARGET ComputeTarget(CONFIG_SET::MOTION_REQUEST request, uint32_t request_id);
+
+    /**
+   * @brief Makes the target the active one
+   *
+   */
+    void ApplyTarget(const MOTION_TARGET& target);
+
+    /**
+   * @brief Picks the latest request from the mailbox, starts it if idle, bends
+   * the running profile onto it if possible, or decelerates to standstill
+   * before reversing
+   *
+   */
+    void HandleNewRequest();
+
+    /**
+   * @brief Acts on StopJog(), after HandleNewRequest() so that a jog picked in
+   * the same iteration is stopped as well: drops a jog waiting in the mailbox
+   * and plans the running jog down to standstill with the configured
+   * deceleration
+   *
+   */
+    void HandleJogStop();
+
+    /**
+   * @brief Reads SG_RESULT and adds it to the histogram
+   *
+   */
+    void SampleStallGuard();
+
+    /**
+   * @brief Reads DRV_STATUS and SG_RESULT at most every
+   * CONFIG_SET::SPEED_SCHEDULER_POLL_INTERVAL_US and feeds them to the speed
+   * scheduler, re-plans the running profile while cruising if the scheduled
+   * velocity changed
+   *
+   * @param sample: current sample of the motion profile
+   */
+    void PollDriverLoad(const MotionProfile::SAMPLE& sample);
+
+    /**
+   * @brief Records step and velocity with the last polled SG_RESULT and
+   * CS_ACTUAL, at most every CONFIG_SET::TELEMETRY_SAMPLE_INTERVAL_US
+   *
+   */
+    void SampleTelemetry(float velocity);
+
+    /**
+   * @brief Appends a record for the current move to telemetry, if any
+   *
+   */
+    void RecordTelemetry(TELEMETRY_EVENT event, float velocity);
+
+    /**
+   * @brief Queues the result of a request for the controller
+   *
+   * @param total_step_count: re-measured travel, 0 if unchanged
+   */
+    void PushFeedback(uint32_t request_id, CONFIG_SET::MOTION_RESULT result, int total_step_count = 0);
+
+    /**
+   * @brief Called when a traversal stalled, i.e. ran into the end stop. Re-zeroes
+   * on the lower end, and updates TOTAL_STEP_COUNT if the end stop is off from
+   * the calibrated one, within CONFIG_SET::END_STOP_MAX_DRIFT_FRACTION
+   *
+   * @return int : new TOTAL_STEP_COUNT, 0 if unchanged
+   */
+    int UpdateEndStop();
+
+    /**
+   * @brief Rebuilds percent_map_ from the pending knots if UpdatePercentMap()
+   * was called, deferred while the motor runs so that a move keeps its mapping
+   *
+   */
+    void HandlePercentMapUpdate();
+
+    /**
+   * @brief Samples the motion profile and writes the velocity to the driver,
+   * the driver is only written when the velocity changes
+   *
+   * @return MotionProfile::SAMPLE : sampled state of the profile
+   */
+    MotionProfile::SAMPLE UpdateVelocity();
+
+    /**
+   * @brief Converts velocity in microsteps per second to VACTUAL units,
+   * clamped to CONFIG_SET::MOTOR_DRIVER_MAX_SPEED
+   *
+   */
+    static uint32_t VelocityToVactual(float velocity);
+
     /**
    * @brief Starts handler thread
    *
@@ -174,6 +558,44 @@ class MotorDriver : private TMC2209Stepper {
    *
    */
     void ResetSteps();
+
+    /**
+   * @brief Updates current_step_ from the position estimator, combining INDEX
+   * pulses, MSCNT and the commanded travel
+   *
+   * @param read_driver: true for reading MSCNT over UART, false for only
+   * predicting from the last reading and the commanded travel
+   * @param commanded_travel: travel commanded since the start of the move
+   */
+    void SyncPosition(bool read_driver, float commanded_travel);
+
+    /**
+   * @brief Returns the travel commanded by the motion profile(s) since the
+   * start of the move, in microsteps
+   *
+   */
+    float GetCommandedTravel();
+
+    /**
+   * @brief Overrides current_step_, later estimates continue from the given
+   * step
+   *
+   */
+    void SetCurrentStep(int step);
+
+    /**
+   * @brief Publishes step, percentage, direction, running and last pulse time for readers
+   * in other threads, must only be called from the handler thread (or before
+   * it starts)
+   *
+   */
+    void PublishState();
+
+    /**
+   * @brief Posts an event to the event queue, if there is one
+   *
+   */
+    void PostEvent(CONFIG_SET::CONTROLLER_EVENT_TYPE type, int value = 0);
 };
 
 #endif
@@ -0,0 +1,122 @@
+/**
+ * @file mpsc_ring.h
+ * @author Mahimana Bhatt (mahimanabhatt@gmail.com)
+ * @brief Defines a fixed capacity multi producer / single consumer ring of
+ * preallocated slots, used for handing records from any task to one consumer
+ * thread without any mutex or allocation
+ *
+ * Every slot carries a sequence number telling whose turn it is. A producer
+ * claims the slot at the head with a compare and swap, fills it in place and
+ * then publishes it through its sequence, the consumer copies the record out
+ * and hands the slot to the producer one lap later. A push into a full ring
+ * drops the record and counts it, so producers never wait for the consumer.
+ *
+ * A producer preempted between claiming and publishing holds back the records
+ * behind its slot until it publishes, the consumer just finds the ring empty
+ * until then.
+ *
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef _MPSC_RING_INCLUDE_GUARD
+#define _MPSC_RING_INCLUDE_GUARD
+
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+template <typename T, uint32_t CAPACITY>
+class MpscRing {
+    static_assert(std::is_trivially_copyable<T>::value, "MpscRing needs a trivially copyable type");
+    static_assert(CAPACITY > 0 && (CAPACITY & (CAPACITY - 1)) == 0, "MpscRing capacity must be a power of two");
+
+   public:
+    MpscRing() : head_(0), tail_(0), dropped_count_(0) {
+        for (uint32_t i = 0; i < CAPACITY; i++) {
+            slots_[i].SEQUENCE.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief Appends a record, filled in place by the given function so that
+     * nothing is built and copied twice, safe to call from any number of tasks
+     *
+     * @param fill: called with the claimed record, must not block
+     * @return true : if appended
+     * @return false : if the ring is full, the record is dropped and counted
+     */
+    template <typename FILL>
+    bool Push(FILL fill) {
+        uint32_t head = head_.load(std::memory_order_relaxed);
+        SLOT* slot;
+        while (true) {
+            slot = &slots_[head & (CAPACITY - 1)];
+            int32_t lap = int32_t(slot->SEQUENCE.load(std::memory_order_acquire) - head);
+            if (lap == 0) {
+                // free for this head, a failed swap reloads head
+                if (head_.compare_exchange_weak(head, head + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (lap < 0) {
+                // still holds the record of the previous lap
+                dropped_count_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            } else {
+                // another producer took it
+                head = head_.load(std::memory_order_relaxed);
+            }
+        }
+        fill(slot->ITEM);
+        slot->SEQUENCE.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Takes the oldest record, must only be called by the single
+     * consumer
+     *
+     * @return true : if a record was taken
+     * @return false : if the ring is empty or the oldest record is not
+     * published yet
+     */
+    bool Pop(T& item) {
+        SLOT& slot = slots_[tail_ & (CAPACITY - 1)];
+        if (slot.SEQUENCE.load(std::memory_order_acquire) != tail_ + 1) {
+            return false;
+        }
+        item = slot.ITEM;
+        slot.SEQUENCE.store(tail_ + CAPACITY, std::memory_order_release);
+        tail_++;
+        return true;
+    }
+
+    /**
+     * @brief Returns the number of records claimed so far, wraps around
+     *
+     */
+    uint32_t GetPushedCount() const { return head_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Returns the number of records dropped because the ring was full
+     *
+     */
+    uint32_t GetDroppedCount() const { return dropped_count_.load(std::memory_order_relaxed); }
+
+   private:
+    struct SLOT {
+        std::atomic<uint32_t> SEQUENCE;
+        T ITEM;
+    };
+
+    // free running, only the consumer touches the tail
+    std::atomic<uint32_t> head_;
+    uint32_t tail_;
+    std::atomic<uint32_t> dropped_count_;
+    SLOT slots_[CAPACITY];
+};
+
+#endif
@@ -0,0 +1,176 @@
+/**
+ * @file percent_map.cpp
+ * @author Dhiraj Deshmukh (deshmukhdhiraj15@gmail.com)
+ * @brief Contains the nonlinear percent to step mapping and its construction
+ * from a roller model or user marked points
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include "percent_map.h"
+
+#include <cmath>
+
+PercentMap::PercentMap() : knot_count_(0), percent_per_knot_(100), total_step_count_(0), reverse_scale_q32_(0) {
+    uint16_t knots[2] = {0, FULL_SCALE};
+    Build(knots, 2, 0);
+}
+
+bool PercentMap::Build(const uint16_t* knots, int knot_count, int total_step_count) {
+    uint16_t valid_knots[MAX_KNOTS];
+    bool valid = knot_count >= 2 && knot_count <= MAX_KNOTS && (100 % (knot_count - 1)) == 0;
+    bool all_zero = true;
+    for (int i = 0; valid && i < knot_count; i++) {
+        valid_knots[i] = knots[i];
+        all_zero = all_zero && knots[i] == 0;
+        if (i > 0 && knots[i] < knots[i - 1]) {
+            valid = false;
+        }
+    }
+    valid = valid && (all_zero || (knots[0] == 0 && knots[knot_count - 1] == FULL_SCALE));
+    if (!valid || all_zero) {
+        knot_count = 2;
+        Linear(valid_knots, knot_count);
+    }
+
+    knot_count_ = knot_count;
+    percent_per_knot_ = 100 / (knot_count - 1);
+    total_step_count_ = total_step_count > 0 ? total_step_count : 0;
+    for (int i = 0; i < knot_count_; i++) {
+        steps_[i] = int32_t((int64_t(valid_knots[i]) * total_step_count_ + FULL_SCALE / 2) / FULL_SCALE);
+    }
+    for (int i = 0; i < knot_count_ - 1; i++) {
+        step_slopes_q16_[i] = (int64_t(steps_[i + 1] - steps_[i]) << 16) / percent_per_knot_;
+    }
+
+    reverse_scale_q32_ = total_step_count_ > 0 ? (uint64_t(REVERSE_BINS) << 32) / total_step_count_ : 0;
+    for (int j = 0; j <= REVERSE_BINS; j++) {
+        reverse_steps_[j] = int32_t(int64_t(total_step_count_) * j / REVERSE_BINS);
+        reverse_percents_q16_[j] = SearchPercentQ16(reverse_steps_[j]);
+    }
+    for (int j = 0; j < REVERSE_BINS; j++) {
+        int32_t steps = reverse_steps_[j + 1] - reverse_steps_[j];
+        int64_t percent_q16 = reverse_percents_q16_[j + 1] - reverse_percents_q16_[j];
+        reverse_slopes_q32_[j] = steps > 0 ? (percent_q16 << 16) / steps : 0;
+    }
+    return valid;
+}
+
+int PercentMap::StepFromPercent(int percent) const {
+    if (percent <= 0) {
+        return steps_[0];
+    }
+    if (percent >= 100) {
+        return steps_[knot_count_ - 1];
+    }
+    int knot = percent / percent_per_knot_;
+    int64_t offset = percent - knot * percent_per_knot_;
+    return steps_[knot] + int32_t((offset * step_slopes_q16_[knot]) >> 16);
+}
+
+int PercentMap::PercentFromStep(int step) const {
+    if (step <= 0) {
+        return 0;
+    }
+    if (step >= total_step_count_) {
+        return 100;
+    }
+    uint32_t bin = uint32_t((uint64_t(step) * reverse_scale_q32_) >> 32);
+    if (bin >= REVERSE_BINS) {
+        bin = REVERSE_BINS - 1;
+    }
+    int64_t percent_q16 = reverse_percents_q16_[bin] +
+                          ((int64_t(step - reverse_steps_[bin]) * reverse_slopes_q32_[bin]) >> 16);
+    int percent = int((percent_q16 + (1 << 15)) >> 16);
+    return percent < 0 ? 0 : (percent > 100 ? 100 : percent);
+}
+
+int32_t PercentMap::SearchPercentQ16(int step) const {
+    if (step <= steps_[0]) {
+        return 0;
+    }
+    for (int i = 0; i < knot_count_ - 1; i++) {
+        if (step <= steps_[i + 1] && steps_[i + 1] > steps_[i]) {
+            int64_t percent_q16 = int64_t(i * percent_per_knot_) << 16;
+            return int32_t(percent_q16 +
+                           (int64_t(step - steps_[i]) * (int64_t(percent_per_knot_) << 16)) / (steps_[i + 1] - steps_[i]));
+        }
+    }
+    return int32_t(100) << 16;
+}
+
+void PercentMap::Linear(uint16_t* knots, int knot_count) {
+    for (int i = 0; i < knot_count; i++) {
+        knots[i] = uint16_t((uint32_t(FULL_SCALE) * i + (knot_count - 1) / 2) / (knot_count - 1));
+    }
+}
+
+void PercentMap::FromWrapRatio(float wrap_ratio, uint16_t* knots, int knot_count) {
+    // the wrap radius grows linearly with the turns, i.e. the opening is
+    // quadratic in steps: p = (u + a * u^2) / (1 + a), a = (ratio - 1) / 2
+    float a = (wrap_ratio - 1.0f) / 2.0f;
+    for (int i = 0; i < knot_count; i++) {
+        float percent = float(i) / (knot_count - 1);
+        float fraction = percent;
+        if (std::fabs(a) > 1e-6f) {
+            fraction = (-1.0f + std::sqrt(1.0f + 4.0f * a * percent * (1.0f + a))) / (2.0f * a);
+        }
+        fraction = fraction < 0 ? 0 : (fraction > 1 ? 1 : fraction);
+        knots[i] = uint16_t(std::lround(fraction * FULL_SCALE));
+    }
+    knots[0] = 0;
+    knots[knot_count - 1] = FULL_SCALE;
+}
+
+int PercentMap::KnotFromPercent(int percent, int knot_count) {
+    if (knot_count < 2 || knot_count > MAX_KNOTS || (100 % (knot_count - 1)) != 0 || percent < 0 || percent > 100) {
+        return -1;
+    }
+    int percent_per_knot = 100 / (knot_count - 1);
+    return (percent % percent_per_knot) == 0 ? percent / percent_per_knot : -1;
+}
+
+bool PercentMap::ApplyMark(uint16_t* knots, int knot_count, uint32_t& marked, int percent, uint16_t step_fraction) {
+    // a step measured between knots is not where the knot is, so only marks
+    // at a knot are taken
+    int knot = KnotFromPercent(percent, knot_count);
+    if (knot <= 0 || knot >= knot_count - 1) {
+        // the ends are defined by the end stops
+        return false;
+    }
+    if (knots[knot_count - 1] == 0) {
+        Linear(knots, knot_count);
+    }
+    int lower = knot - 1;
+    while (lower > 0 && !(marked & (1UL << lower))) {
+        lower--;
+    }
+    int upper = knot + 1;
+    while (upper < knot_count - 1 && !(marked & (1UL << upper))) {
+        upper++;
+    }
+    if (step_fraction <= knots[lower] || step_fraction >= knots[upper]) {
+        return false;
+    }
+
+    // stretch both sides, keeping their shape relative to the fixed knots
+    int32_t old_value = knots[knot];
+    for (int i = lower + 1; i < knot; i++) {
+        int32_t span = old_value - knots[lower];
+        int32_t offset = (span > 0) ? int32_t(int64_t(knots[i] - knots[lower]) * (step_fraction - knots[lower]) / span)
+                                    : (step_fraction - knots[lower]) * (i - lower) / (knot - lower);
+        knots[i] = uint16_t(knots[lower] + offset);
+    }
+    for (int i = knot + 1; i < upper; i++) {
+        int32_t span = knots[upper] - old_value;
+        int32_t offset = (span > 0) ? int32_t(int64_t(knots[i] - old_value) * (knots[upper] - step_fraction) / span)
+                                    : (knots[upper] - step_fraction) * (i - knot) / (upper - knot);
+        knots[i] = uint16_t(step_fraction + offset);
+    }
+    knots[knot] = step_fraction;
+    marked |= 1UL << knot;
+    return true;
+}
@@ -0,0 +1,126 @@
+/**
+ * @file percent_map.h
+ * @author Mahimana Bhatt (mahimanabhatt@gmail.com)
+ * @brief Defines a nonlinear mapping between opening percentage and motor
+ * steps, pure C++ without any Arduino dependency
+ *
+ * On a roller blind the wrap diameter changes along the travel, so equal steps
+ * do not give equal opening. The mapping is described by knots, the step (as
+ * fraction of the total travel, 0-65535) at evenly spaced percentages, e.g. 21
+ * knots for every 5 percent. All zero knots stand for a linear mapping.
+ *
+ * Build() precomputes both directions for a given total step count, lookups
+ * are O(1) interpolations in fixed point without any division:
+ *
+ *   percent -> step : segment of the knots, interpolated with its slope
+ *   step -> percent : uniform grid over the steps (index by multiplying with
+ *                     the precomputed reciprocal), interpolated with its slope
+ *
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef _PERCENT_MAP_INCLUDE_GUARD
+#define _PERCENT_MAP_INCLUDE_GUARD
+
+#include <cstdint>
+
+class PercentMap {
+   public:
+    static const int MAX_KNOTS = 21;
+    static const uint16_t FULL_SCALE = 65535;
+
+    /**
+     * @brief Construct a new Percent Map object, linear over 0 steps until
+     * built
+     *
+     */
+    PercentMap();
+
+    /**
+     * @brief Precomputes the lookup tables
+     *
+     * @param knots: step fraction at evenly spaced percentages, monotonic, all
+     * zero for linear
+     * @param knot_count: number of knots, (knot_count - 1) must divide 100
+     * @param total_step_count: steps of the full travel
+     * @return true : if the knots were valid
+     * @return false : otherwise, the mapping is linear
+     */
+    bool Build(const uint16_t* knots, int knot_count, int total_step_count);
+
+    /**
+     * @brief Returns the step for a percentage (0-100)
+     *
+     */
+    int StepFromPercent(int percent) const;
+
+    /**
+     * @brief Returns the percentage (0-100, rounded) for a step, steps
+     * outside of the travel are clamped
+     *
+     */
+    int PercentFromStep(int step) const;
+
+    /**
+     * @brief Fills knots for a roller blind, the step fraction of the travel
+     * grows with the wrap diameter
+     *
+     * @param wrap_ratio: wrap diameter at 100% divided by the one at 0%, 1.0
+     * for linear
+     */
+    static void FromWrapRatio(float wrap_ratio, uint16_t* knots, int knot_count);
+
+    /**
+     * @brief Returns the knot at a percentage
+     *
+     * @return int: the knot, -1 if the percentage falls between knots
+     */
+    static int KnotFromPercent(int percent, int knot_count);
+
+    /**
+     * @brief Moves the knot at percent onto the given step fraction, the knots
+     * between it and the neighbouring marked knots (or the ends) are stretched
+     * along
+     *
+     * @param percent: percentage of an inner knot, the ends are defined by the
+     * end stops
+     * @param marked: bit mask of knots set by earlier marks, updated
+     * @return true : if the mark was applied
+     * @return false : if percent is not at an inner knot or the mark would
+     * break monotonicity with earlier marks
+     */
+    static bool ApplyMark(uint16_t* knots, int knot_count, uint32_t& marked, int percent, uint16_t step_fraction);
+
+   private:
+    static const int REVERSE_BINS = 64;
+
+    int knot_count_;
+    int percent_per_knot_;
+    int total_step_count_;
+    int32_t steps_[MAX_KNOTS];
+    int64_t step_slopes_q16_[MAX_KNOTS];  // steps per percent
+
+    uint64_t reverse_scale_q32_;  // REVERSE_BINS / total_step_count
+    int32_t reverse_steps_[REVERSE_BINS + 1];
+    int32_t reverse_percents_q16_[REVERSE_BINS + 1];
+    int64_t reverse_slopes_q32_[REVERSE_BINS];  // percent per step
+
+    /**
+     * @brief Fills knots for a linear mapping
+     *
+     */
+    static void Linear(uint16_t* knots, int knot_count);
+
+    /**
+     * @brief Returns the percentage in Q16 for a step by searching the knots,
+     * only used while building
+     *
+     */
+    int32_t SearchPercentQ16(int step) const;
+};
+
+#endif
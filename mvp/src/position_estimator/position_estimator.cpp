@@ -0,0 +1,92 @@
+/**
+ * @file position_estimator.cpp
+ * @author Dhiraj Deshmukh (deshmukhdhiraj15@gmail.com)
+ * @brief Contains algorithms for estimating the motor position from INDEX
+ * pulses, MSCNT and the commanded travel
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include "position_estimator.h"
+
+#include <cmath>
+#include <cstdlib>
+
+PositionEstimator::PositionEstimator(int microsteps)
+    : mscnt_per_microstep_(MSCNT_PER_CYCLE / (4 * microsteps)),
+      start_step_(0),
+      direction_sign_(1),
+      start_pulse_count_(0),
+      start_mscnt_(0),
+      fix_travel_mscnt_(0),
+      fix_commanded_travel_(0),
+      tracked_step_(0),
+      is_stalled_(false),
+      step_(0) {}
+
+void PositionEstimator::StartMove(int start_step, bool direction, int32_t pulse_count, uint16_t mscnt) {
+    start_step_ = start_step;
+    tracked_step_ = start_step;
+    is_stalled_ = false;
+    step_ = start_step;
+    direction_sign_ = direction ? 1 : -1;
+    start_pulse_count_ = pulse_count;
+    start_mscnt_ = mscnt % MSCNT_PER_CYCLE;
+    fix_travel_mscnt_ = 0;
+    fix_commanded_travel_ = 0;
+}
+
+int PositionEstimator::Update(int32_t pulse_count, uint16_t mscnt, float commanded_travel) {
+    // the interrupt counts pulses signed by direction, travel is always positive
+    int32_t pulses = std::abs(pulse_count - start_pulse_count_);
+    int32_t travel_mscnt = pulses * MSCNT_PER_CYCLE + (int32_t(mscnt % MSCNT_PER_CYCLE) - start_mscnt_);
+
+    // resolve the one cycle ambiguity between pulse count and MSCNT using the
+    // travel commanded since the last fix
+    int32_t predicted_mscnt =
+        fix_travel_mscnt_ + int32_t((commanded_travel - fix_commanded_travel_) * mscnt_per_microstep_);
+    while (travel_mscnt - predicted_mscnt > MSCNT_PER_CYCLE / 2) {
+        travel_mscnt -= MSCNT_PER_CYCLE;
+    }
+    while (predicted_mscnt - travel_mscnt > MSCNT_PER_CYCLE / 2) {
+        travel_mscnt += MSCNT_PER_CYCLE;
+    }
+
+    fix_travel_mscnt_ = travel_mscnt;
+    fix_commanded_travel_ = commanded_travel;
+    tracked_step_ = start_step_ + direction_sign_ * (travel_mscnt / mscnt_per_microstep_);
+    if (!is_stalled_) {
+        step_ = tracked_step_;
+    }
+    return step_;
+}
+
+int PositionEstimator::Predict(float commanded_travel) {
+    float travel = float(fix_travel_mscnt_) / mscnt_per_microstep_ + (commanded_travel - fix_commanded_travel_);
+    tracked_step_ = start_step_ + direction_sign_ * int(std::lround(travel));
+    if (!is_stalled_) {
+        step_ = tracked_step_;
+    }
+    return step_;
+}
+
+void PositionEstimator::SetStalled(bool stalled) {
+    if (is_stalled_ && !stalled) {
+        // the rotor kept turning
+        step_ = tracked_step_;
+    }
+    is_stalled_ = stalled;
+}
+
+void PositionEstimator::SetStep(int step) {
+    start_step_ += step - step_;
+    tracked_step_ += step - step_;
+    step_ = step;
+}
+
+int PositionEstimator::GetStep() const {
+    return step_;
+}
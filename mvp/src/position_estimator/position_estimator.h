@@ -0,0 +1,113 @@
+/**
+ * @file position_estimator.h
+ * @author Mahimana Bhatt (mahimanabhatt@gmail.com)
+ * @brief Defines a microstep accurate position estimator for TMC2209, pure C++
+ * without any Arduino dependency
+ *
+ * INDEX pulses only come once per electrical cycle (4 full steps), the
+ * driver's MSCNT register gives the position inside the cycle (0-1023). The
+ * travel since the start of a move is:
+ *
+ *   travel = index_pulses * 1024 + (MSCNT - MSCNT_at_start)   [MSCNT units]
+ *
+ * As the INDEX interrupt and the UART read of MSCNT are not atomic with
+ * respect to each other, the pulse count may be off by one cycle around the
+ * wrap of MSCNT. The commanded travel (from the motion profile) since the
+ * last fix resolves this ambiguity, and is also used for predicting the
+ * position in between two reads of MSCNT.
+ *
+ * VACTUAL is always written positive and direction is selected through the
+ * shaft bit, hence MSCNT always counts up during a move.
+ *
+ * MSCNT and INDEX follow the driver's sequencer, not the rotor, they keep
+ * counting while the rotor stands against an end stop. Once a stall is
+ * flagged the estimate holds the step it had, the fixes go on underneath so
+ * that a flag which clears again (a false stall) does not lose any travel.
+ *
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef _POSITION_ESTIMATOR_INCLUDE_GUARD
+#define _POSITION_ESTIMATOR_INCLUDE_GUARD
+
+#include <cstdint>
+
+class PositionEstimator {
+   public:
+    /**
+     * @brief Construct a new Position Estimator object
+     *
+     * @param microsteps: microstep resolution configured on the driver
+     */
+    explicit PositionEstimator(int microsteps);
+
+    /**
+     * @brief Latches the starting point of a move
+     *
+     * @param start_step: estimated step at the start of the move
+     * @param direction: true if the steps increase during the move
+     * @param pulse_count: INDEX pulse count at the start of the move
+     * @param mscnt: MSCNT register value at the start of the move
+     */
+    void StartMove(int start_step, bool direction, int32_t pulse_count, uint16_t mscnt);
+
+    /**
+     * @brief Fuses a fresh MSCNT reading with the INDEX pulse count
+     *
+     * @param pulse_count: INDEX pulse count (as counted by the interrupt)
+     * @param mscnt: MSCNT register value
+     * @param commanded_travel: travel commanded since the start of the move,
+     * in microsteps
+     * @return int : estimated step
+     */
+    int Update(int32_t pulse_count, uint16_t mscnt, float commanded_travel);
+
+    /**
+     * @brief Predicts the step from the last fix and the commanded travel,
+     * used in between two MSCNT reads
+     *
+     * @param commanded_travel: travel commanded since the start of the move,
+     * in microsteps
+     * @return int : estimated step
+     */
+    int Predict(float commanded_travel);
+
+    /**
+     * @brief Flags or clears a stall, the estimate holds while flagged
+     *
+     * @param stalled: true while DIAG or SG_RESULT indicates a stall
+     */
+    void SetStalled(bool stalled);
+
+    /**
+     * @brief Overrides the estimated step, e.g. when clamping to the end stops
+     *
+     */
+    void SetStep(int step);
+
+    /**
+     * @brief Returns the last estimated step
+     *
+     */
+    int GetStep() const;
+
+   private:
+    static const int MSCNT_PER_CYCLE = 1024;
+
+    const int mscnt_per_microstep_;
+    int start_step_;
+    int direction_sign_;
+    int32_t start_pulse_count_;
+    uint16_t start_mscnt_;
+    int32_t fix_travel_mscnt_;
+    float fix_commanded_travel_;
+    int tracked_step_;  // step by MSCNT and INDEX, whether stalled or not
+    bool is_stalled_;
+    int step_;
+};
+
+#endif
@@ -0,0 +1,132 @@
+/**
+ * @file power_manager.cpp
+ * @author Dhiraj Deshmukh (deshmukhdhiraj15@gmail.com)
+ * @brief Contains the idle power management between commands
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include "power_manager.h"
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <esp_pm.h>
+#include <esp_sleep.h>
+#include <sdkconfig.h>
+
+#include "../config/config.h"
+#include "../latency/latency.h"
+#include "../logging/logging.h"
+#include "../monotonic_clock/monotonic_clock.h"
+
+PowerManager::PowerManager(std::shared_ptr<Logging>& logging) : logger_(logging) {
+    using namespace CONFIG_SET;
+    // button pins are armed as level wake up sources by ManualInteraction
+    esp_sleep_enable_gpio_wakeup();
+    auto_light_sleep_ = EnableAutoLightSleep();
+    last_busy_ms_ = MonotonicClock::NowMs();
+    if (auto_light_sleep_) {
+        logger_->Log(LOG_TYPE::INFO, LOG_CLASS::POWER_MANAGER, LOG_FORMAT("Automatic light sleep enabled"));
+    } else {
+        logger_->Log(LOG_TYPE::INFO, LOG_CLASS::POWER_MANAGER, LOG_FORMAT("Light sleep not built in, idling by clock"));
+    }
+}
+
+PowerManager::~PowerManager() {
+    if (idle_) {
+        ExitIdle();
+    }
+#if CONFIG_PM_ENABLE
+    if (no_light_sleep_lock_) {
+        // other modes keep the CPU awake
+        esp_pm_config_esp32_t pm_config;
+        pm_config.max_freq_mhz = CONFIG_SET::POWER_ACTIVE_CPU_FREQ_MHZ;
+        pm_config.min_freq_mhz = CONFIG_SET::POWER_ACTIVE_CPU_FREQ_MHZ;
+        pm_config.light_sleep_enable = false;
+        esp_pm_configure(&pm_config);
+        esp_pm_lock_release(no_light_sleep_lock_);
+        esp_pm_lock_delete(no_light_sleep_lock_);
+    }
+#endif
+}
+
+bool PowerManager::EnableAutoLightSleep() {
+#if CONFIG_PM_ENABLE && CONFIG_FREERTOS_USE_TICKLESS_IDLE
+    using namespace CONFIG_SET;
+    if (esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "busy", &no_light_sleep_lock_) != ESP_OK) {
+        no_light_sleep_lock_ = nullptr;
+        return false;
+    }
+    // held while busy, taken before sleep is allowed at all
+    esp_pm_lock_acquire(no_light_sleep_lock_);
+    esp_pm_config_esp32_t pm_config;
+    // no frequency scaling, APB stays at 80 MHz so UART baud rates hold
+    pm_config.max_freq_mhz = POWER_ACTIVE_CPU_FREQ_MHZ;
+    pm_config.min_freq_mhz = POWER_ACTIVE_CPU_FREQ_MHZ;
+    pm_config.light_sleep_enable = true;
+    if (esp_pm_configure(&pm_config) != ESP_OK) {
+        esp_pm_lock_release(no_light_sleep_lock_);
+        esp_pm_lock_delete(no_light_sleep_lock_);
+        no_light_sleep_lock_ = nullptr;
+        return false;
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+void PowerManager::Update(bool busy) {
+    using namespace CONFIG_SET;
+    if (busy) {
+        last_busy_ms_ = MonotonicClock::NowMs();
+        if (idle_) {
+            ExitIdle();
+        }
+    } else if (!idle_ && (MonotonicClock::NowMs() - last_busy_ms_) >= POWER_IDLE_TIMEOUT_MS) {
+        EnterIdle();
+    }
+}
+
+bool PowerManager::IsIdle() const {
+    return idle_;
+}
+
+void PowerManager::EnterIdle() {
+    using namespace CONFIG_SET;
+    if (POWER_IDLE_MAX_MODEM_SLEEP) {
+        WiFi.setSleep(WIFI_PS_MAX_MODEM);
+    }
+#if CONFIG_PM_ENABLE
+    if (auto_light_sleep_) {
+        esp_pm_lock_release(no_light_sleep_lock_);
+    }
+#endif
+    if (!auto_light_sleep_) {
+        setCpuFrequencyMhz(POWER_IDLE_CPU_FREQ_MHZ);
+        Latency::SetCpuFrequencyMhz(POWER_IDLE_CPU_FREQ_MHZ);
+    }
+    idle_ = true;
+    logger_->Log(LOG_TYPE::INFO, LOG_CLASS::POWER_MANAGER, LOG_FORMAT("Entering idle"));
+}
+
+void PowerManager::ExitIdle() {
+    using namespace CONFIG_SET;
+    if (!auto_light_sleep_) {
+        setCpuFrequencyMhz(POWER_ACTIVE_CPU_FREQ_MHZ);
+        Latency::SetCpuFrequencyMhz(POWER_ACTIVE_CPU_FREQ_MHZ);
+    }
+#if CONFIG_PM_ENABLE
+    if (auto_light_sleep_) {
+        esp_pm_lock_acquire(no_light_sleep_lock_);
+    }
+#endif
+    if (POWER_IDLE_MAX_MODEM_SLEEP) {
+        WiFi.setSleep(WIFI_PS_MIN_MODEM);
+    }
+    idle_ = false;
+    logger_->Log(LOG_TYPE::INFO, LOG_CLASS::POWER_MANAGER, LOG_FORMAT("Leaving idle"));
+}
@@ -0,0 +1,99 @@
+/**
+ * @file power_manager.h
+ * @author Mahimana Bhatt (mahimanabhatt@gmail.com)
+ * @brief Defines the idle power management of the device between commands
+ *
+ * The device is busy while a command is handled and idles
+ * CONFIG_SET::POWER_IDLE_TIMEOUT_MS after the last one. While idle:
+ *
+ *   - WiFi modem sleeps between DTIM beacons (maximum modem sleep)
+ *   - the controller polls less often (CONFIG_SET::POWER_IDLE_POLL_INTERVAL_MS)
+ *     and blocks on its event queue in between, so the CPU light sleeps on
+ *     builds with automatic light sleep (power management and tickless idle
+ *     enabled in sdkconfig), WiFi stays associated through modem sleep
+ *   - otherwise the CPU is clocked down instead and only waits for interrupts
+ *
+ * Button levels (see ManualInteraction), WiFi beacons and the controller
+ * deadline wake the CPU up.
+ *
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef _POWER_MANAGER_INCLUDE_GUARD
+#define _POWER_MANAGER_INCLUDE_GUARD
+
+#include <Arduino.h>
+#include <esp_pm.h>
+#include <sdkconfig.h>
+
+#include <memory>
+
+#include "../config/config.h"
+#include "../logging/logging.h"
+
+class PowerManager {
+   public:
+    /**
+     * @brief Enables the wake up sources and automatic light sleep if
+     * available, starts busy
+     *
+     */
+    PowerManager(std::shared_ptr<Logging>& logging);
+
+    /**
+     * @brief Leaves idle, i.e. restores CPU clock and WiFi power save
+     *
+     */
+    ~PowerManager();
+
+    /**
+     * @brief Reports whether the device has work to do, idles
+     * CONFIG_SET::POWER_IDLE_TIMEOUT_MS after the last busy report and leaves
+     * idle on the next one
+     *
+     */
+    void Update(bool busy);
+
+    /**
+     * @brief Returns true if the device is idle
+     *
+     */
+    bool IsIdle() const;
+
+   private:
+    std::shared_ptr<Logging> logger_;
+    bool idle_ = false;
+    bool auto_light_sleep_ = false;
+    int64_t last_busy_ms_ = 0;
+#if CONFIG_PM_ENABLE
+    esp_pm_lock_handle_t no_light_sleep_lock_ = nullptr;
+#endif
+
+    /**
+     * @brief Configures automatic light sleep, held off until idle
+     *
+     * @return true : if the build supports it
+     * @return false : otherwise
+     */
+    bool EnableAutoLightSleep();
+
+    /**
+     * @brief Lowers the CPU clock (or allows light sleep) and lets WiFi modem
+     * sleep longer
+     *
+     */
+    void EnterIdle();
+
+    /**
+     * @brief Restores full CPU clock, holds off light sleep and restores the
+     * default WiFi modem sleep
+     *
+     */
+    void ExitIdle();
+};
+
+#endif
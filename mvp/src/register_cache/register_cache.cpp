@@ -0,0 +1,120 @@
+/**
+ * @file register_cache.cpp
+ * @author Dhiraj Deshmukh (deshmukhdhiraj15@gmail.com)
+ * @brief Contains the shadow register file with diff-only writes
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include "register_cache.h"
+
+RegisterCache::RegisterCache() : register_count_(0) {}
+
+bool RegisterCache::AddRegister(uint8_t address, uint32_t reset_value, bool readable) {
+    if (register_count_ >= MAX_REGISTERS || Find(address) != nullptr) {
+        return false;
+    }
+    REGISTER& reg = registers_[register_count_++];
+    reg.ADDRESS = address;
+    reg.STAGED = reset_value;
+    reg.WRITTEN = reset_value;
+    reg.SYNCED = false;
+    reg.READABLE = readable;
+    return true;
+}
+
+void RegisterCache::Set(uint8_t address, uint32_t value) {
+    REGISTER* reg = Find(address);
+    if (reg != nullptr) {
+        reg->STAGED = value;
+    }
+}
+
+void RegisterCache::SetField(const FIELD& field, uint32_t value) {
+    REGISTER* reg = Find(field.ADDRESS);
+    if (reg == nullptr) {
+        return;
+    }
+    uint32_t mask = ((field.WIDTH >= 32) ? 0xFFFFFFFF : ((1UL << field.WIDTH) - 1)) << field.SHIFT;
+    reg->STAGED = (reg->STAGED & ~mask) | ((value << field.SHIFT) & mask);
+}
+
+uint32_t RegisterCache::Get(uint8_t address) const {
+    const REGISTER* reg = Find(address);
+    return (reg != nullptr) ? reg->STAGED : 0;
+}
+
+uint32_t RegisterCache::GetField(const FIELD& field) const {
+    return Extract(field, Get(field.ADDRESS));
+}
+
+uint32_t RegisterCache::Extract(const FIELD& field, uint32_t value) {
+    uint32_t mask = (field.WIDTH >= 32) ? 0xFFFFFFFF : ((1UL << field.WIDTH) - 1);
+    return (value >> field.SHIFT) & mask;
+}
+
+bool RegisterCache::IsDirty() const {
+    for (int i = 0; i < register_count_; i++) {
+        if (!registers_[i].SYNCED || registers_[i].STAGED != registers_[i].WRITTEN) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int RegisterCache::Flush(const WRITE_FN& write) {
+    int written = 0;
+    for (int i = 0; i < register_count_; i++) {
+        REGISTER& reg = registers_[i];
+        if (reg.SYNCED && reg.STAGED == reg.WRITTEN) {
+            continue;
+        }
+        write(reg.ADDRESS, reg.STAGED);
+        reg.WRITTEN = reg.STAGED;
+        reg.SYNCED = true;
+        written++;
+    }
+    return written;
+}
+
+int RegisterCache::Verify(const READ_FN& read) {
+    int mismatches = 0;
+    for (int i = 0; i < register_count_; i++) {
+        REGISTER& reg = registers_[i];
+        if (!reg.READABLE || !reg.SYNCED) {
+            continue;
+        }
+        if (read(reg.ADDRESS) != reg.WRITTEN) {
+            reg.SYNCED = false;
+            mismatches++;
+        }
+    }
+    return mismatches;
+}
+
+void RegisterCache::Invalidate() {
+    for (int i = 0; i < register_count_; i++) {
+        registers_[i].SYNCED = false;
+    }
+}
+
+RegisterCache::REGISTER* RegisterCache::Find(uint8_t address) {
+    for (int i = 0; i < register_count_; i++) {
+        if (registers_[i].ADDRESS == address) {
+            return &registers_[i];
+        }
+    }
+    return nullptr;
+}
+
+const RegisterCache::REGISTER* RegisterCache::Find(uint8_t address) const {
+    for (int i = 0; i < register_count_; i++) {
+        if (registers_[i].ADDRESS == address) {
+            return &registers_[i];
+        }
+    }
+    return nullptr;
+}
@@ -0,0 +1,134 @@
+/**
+ * @file register_cache.h
+ * @author Mahimana Bhatt (mahimanabhatt@gmail.com)
+ * @brief Defines a shadow copy of a register file of a UART controlled chip,
+ * pure C++ without any Arduino dependency
+ *
+ * Field updates are merged into the staged value of their register, nothing is
+ * sent until Flush(), which writes only the registers whose staged value
+ * differs from the last value written to the chip, i.e. several field updates
+ * of one register cost one datagram and unchanged registers cost nothing.
+ *
+ * Registers start unsynced (the content of the chip is unknown), the first
+ * Flush() writes all of them. Readable registers can be verified against the
+ * last written value.
+ *
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef _REGISTER_CACHE_INCLUDE_GUARD
+#define _REGISTER_CACHE_INCLUDE_GUARD
+
+#include <cstdint>
+#include <functional>
+
+class RegisterCache {
+   public:
+    /**
+     * @brief Bit field inside a register
+     *
+     */
+    struct FIELD {
+        uint8_t ADDRESS;
+        uint8_t SHIFT;
+        uint8_t WIDTH;
+    };
+
+    using WRITE_FN = std::function<void(uint8_t address, uint32_t value)>;
+    using READ_FN = std::function<uint32_t(uint8_t address)>;
+
+    static const int MAX_REGISTERS = 16;
+
+    RegisterCache();
+
+    /**
+     * @brief Adds a register to the cache
+     *
+     * @param address: register address
+     * @param reset_value: initial staged value
+     * @param readable: true if the chip allows reading the register back
+     * @return true : if added
+     * @return false : if the cache is full or the register exists
+     */
+    bool AddRegister(uint8_t address, uint32_t reset_value, bool readable);
+
+    /**
+     * @brief Stages a complete register value
+     *
+     */
+    void Set(uint8_t address, uint32_t value);
+
+    /**
+     * @brief Stages a field, the other bits of the register are kept
+     *
+     */
+    void SetField(const FIELD& field, uint32_t value);
+
+    /**
+     * @brief Returns the staged value of a register
+     *
+     */
+    uint32_t Get(uint8_t address) const;
+
+    /**
+     * @brief Returns the staged value of a field
+     *
+     */
+    uint32_t GetField(const FIELD& field) const;
+
+    /**
+     * @brief Extracts a field from a register value, e.g. one read from the
+     * chip
+     *
+     */
+    static uint32_t Extract(const FIELD& field, uint32_t value);
+
+    /**
+     * @brief Returns true if any register needs to be written
+     *
+     */
+    bool IsDirty() const;
+
+    /**
+     * @brief Writes all changed or unsynced registers, in order of addition
+     *
+     * @return int : number of registers written
+     */
+    int Flush(const WRITE_FN& write);
+
+    /**
+     * @brief Reads back all readable registers and compares them to the last
+     * written value, mismatching registers are marked unsynced
+     *
+     * @return int : number of mismatching registers
+     */
+    int Verify(const READ_FN& read);
+
+    /**
+     * @brief Marks all registers unsynced, e.g. after the chip was reset or a
+     * write got lost, the next Flush() writes all of them
+     *
+     */
+    void Invalidate();
+
+   private:
+    struct REGISTER {
+        uint8_t ADDRESS = 0;
+        uint32_t STAGED = 0;
+        uint32_t WRITTEN = 0;
+        bool SYNCED = false;
+        bool READABLE = false;
+    };
+
+    REGISTER registers_[MAX_REGISTERS];
+    int register_count_;
+
+    REGISTER* Find(uint8_t address);
+    const REGISTER* Find(uint8_t address) const;
+};
+
+#endif
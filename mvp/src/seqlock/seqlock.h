@@ -0,0 +1,73 @@
+/**
+ * @file seqlock.h
+ * @author Mahimana Bhatt (mahimanabhatt@gmail.com)
+ * @brief Defines a single writer sequence lock, used for sharing small state
+ * blocks between interrupts and threads without any mutex
+ *
+ * The writer never blocks, it bumps the sequence to an odd value, copies the
+ * data and bumps the sequence back to an even value. Readers copy the data and
+ * retry if the sequence was odd or changed meanwhile, hence a reader always
+ * gets one consistent value even if the writer is an interrupt.
+ *
+ * Only ONE writer is allowed per instance (e.g. one ISR or one thread).
+ *
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef _SEQLOCK_INCLUDE_GUARD
+#define _SEQLOCK_INCLUDE_GUARD
+
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+template <typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock needs a trivially copyable type");
+
+   public:
+    SeqLock() : sequence_(0), data_() {}
+
+    explicit SeqLock(const T& value) : sequence_(0), data_(value) {}
+
+    /**
+     * @brief Publishes a new value, must only be called by the single writer,
+     * safe to call from an interrupt
+     *
+     */
+    void Write(const T& value) {
+        uint32_t sequence = sequence_.load(std::memory_order_relaxed);
+        sequence_.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        data_ = value;
+        std::atomic_thread_fence(std::memory_order_release);
+        sequence_.store(sequence + 2, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Returns the latest published value, the writer may call it
+     * as well to get back its own last value
+     *
+     */
+    T Read() const {
+        T value;
+        uint32_t start, end;
+        do {
+            start = sequence_.load(std::memory_order_acquire);
+            value = data_;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            end = sequence_.load(std::memory_order_relaxed);
+        } while ((start & 1) || start != end);
+        return value;
+    }
+
+   private:
+    std::atomic<uint32_t> sequence_;
+    T data_;
+};
+
+#endif
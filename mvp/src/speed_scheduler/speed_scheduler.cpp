@@ -0,0 +1,58 @@
+/**
+ * @file speed_scheduler.cpp
+ * @author Dhiraj Deshmukh (deshmukhdhiraj15@gmail.com)
+ * @brief Contains the adaptive cruise velocity scheduler
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include "speed_scheduler.h"
+
+#include <algorithm>
+
+SpeedScheduler::SpeedScheduler(const LIMITS& limits, int stall_level, int run_current)
+    : limits_(limits),
+      stall_level_(stall_level),
+      run_current_(run_current),
+      velocity_(limits.BASE_VELOCITY),
+      is_thermal_hold_(false),
+      thermal_hold_end_us_(0) {}
+
+float SpeedScheduler::Update(const DRIVER_LOAD& load, int64_t now_us) {
+    if (load.OVERTEMP || load.OVERTEMP_PREWARNING) {
+        if (load.OVERTEMP) {
+            // driver shuts its bridges off, restart at the bottom
+            velocity_ = limits_.MIN_VELOCITY;
+        } else {
+            BackOff();
+        }
+        is_thermal_hold_ = true;
+        thermal_hold_end_us_ = now_us + limits_.THERMAL_HOLD_US;
+        return velocity_;
+    }
+    if (is_thermal_hold_ && now_us >= thermal_hold_end_us_) {
+        is_thermal_hold_ = false;
+    }
+    if (!load.LOAD_VALID) {
+        return velocity_;
+    }
+    int sg_margin = int(load.SG_RESULT) - stall_level_;
+    if (sg_margin < limits_.SG_LOW_MARGIN) {
+        BackOff();
+    } else if (!is_thermal_hold_ && sg_margin > limits_.SG_HIGH_MARGIN &&
+               int(load.CS_ACTUAL) + limits_.CS_HEADROOM <= run_current_) {
+        velocity_ = std::min(limits_.MAX_VELOCITY, velocity_ + limits_.STEP_UP);
+    }
+    return velocity_;
+}
+
+float SpeedScheduler::GetVelocity() const {
+    return velocity_;
+}
+
+void SpeedScheduler::BackOff() {
+    velocity_ = std::max(limits_.MIN_VELOCITY, velocity_ * limits_.BACK_OFF);
+}
@@ -0,0 +1,90 @@
+/**
+ * @file speed_scheduler.h
+ * @author Mahimana Bhatt (mahimanabhatt@gmail.com)
+ * @brief Defines an adaptive cruise velocity scheduler driven by the load and
+ * temperature reported by TMC2209, pure C++ without any Arduino dependency
+ *
+ * The cruise velocity is raised additively while StallGuard reports plenty of
+ * margin above the stall level and CoolStep runs below the run current (light
+ * load), and is backed off multiplicatively as soon as the margin gets small
+ * or the driver warns about its temperature. After a temperature warning the
+ * velocity is held for a while before it is allowed to rise again, counted in
+ * time rather than updates, as the driver cools down between moves as well.
+ *
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef _SPEED_SCHEDULER_INCLUDE_GUARD
+#define _SPEED_SCHEDULER_INCLUDE_GUARD
+
+#include <cstdint>
+
+class SpeedScheduler {
+   public:
+    /**
+     * @brief Tuning of the scheduler, velocities in microsteps per second
+     *
+     */
+    struct LIMITS {
+        float MIN_VELOCITY;
+        float BASE_VELOCITY;
+        float MAX_VELOCITY;
+        float STEP_UP;       // added per update with headroom
+        float BACK_OFF;      // factor applied per update without headroom
+        int SG_LOW_MARGIN;   // SG_RESULT above stall level below which it backs off
+        int SG_HIGH_MARGIN;  // SG_RESULT above stall level above which it may raise
+        int CS_HEADROOM;     // CS_ACTUAL below IRUN required for raising
+        int64_t THERMAL_HOLD_US;  // time without raising after a temperature warning
+    };
+
+    /**
+     * @brief One reading of the driver
+     *
+     */
+    struct DRIVER_LOAD {
+        bool OVERTEMP = false;
+        bool OVERTEMP_PREWARNING = false;
+        bool LOAD_VALID = false;  // SG_RESULT and CS_ACTUAL are only meaningful while cruising
+        uint16_t SG_RESULT = 0;
+        uint8_t CS_ACTUAL = 0;
+    };
+
+    /**
+     * @brief Construct a new Speed Scheduler object, starts at base velocity
+     *
+     * @param stall_level: SG_RESULT at which the driver signals a stall, i.e.
+     * 2 * SGTHRS
+     * @param run_current: IRUN, current scale CoolStep regulates below
+     */
+    SpeedScheduler(const LIMITS& limits, int stall_level, int run_current);
+
+    /**
+     * @brief Adapts the velocity to a new reading
+     *
+     * @param now_us: time of the reading, on a monotonic clock
+     * @return float : scheduled cruise velocity
+     */
+    float Update(const DRIVER_LOAD& load, int64_t now_us);
+
+    /**
+     * @brief Returns the scheduled cruise velocity
+     *
+     */
+    float GetVelocity() const;
+
+   private:
+    LIMITS limits_;
+    int stall_level_;
+    int run_current_;
+    float velocity_;
+    bool is_thermal_hold_;
+    int64_t thermal_hold_end_us_;
+
+    void BackOff();
+};
+
+#endif
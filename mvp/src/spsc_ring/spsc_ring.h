@@ -0,0 +1,88 @@
+/**
+ * @file spsc_ring.h
+ * @author Mahimana Bhatt (mahimanabhatt@gmail.com)
+ * @brief Defines a fixed capacity single producer / single consumer ring,
+ * used for handing records from an interrupt to a thread without any mutex or
+ * allocation
+ *
+ * The producer copies the record into its slot and then publishes it by
+ * advancing the head, the consumer copies the record out and then frees the
+ * slot by advancing the tail. Neither side ever waits for the other, a push
+ * into a full ring drops the record and counts it. Everything is inline, so
+ * it ends up in the IRAM of an IRAM_ATTR interrupt.
+ *
+ * Only ONE producer and ONE consumer are allowed per instance, interrupts of
+ * the same core count as one producer since they never nest.
+ *
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef _SPSC_RING_INCLUDE_GUARD
+#define _SPSC_RING_INCLUDE_GUARD
+
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+template <typename T, uint32_t CAPACITY>
+class SpscRing {
+    static_assert(std::is_trivially_copyable<T>::value, "SpscRing needs a trivially copyable type");
+    static_assert(CAPACITY > 0 && (CAPACITY & (CAPACITY - 1)) == 0, "SpscRing capacity must be a power of two");
+
+   public:
+    SpscRing() : head_(0), tail_(0), dropped_count_(0), items_() {}
+
+    /**
+     * @brief Appends a record, must only be called by the single producer,
+     * safe to call from an interrupt
+     *
+     * @return true : if appended
+     * @return false : if the ring is full, the record is dropped and counted
+     */
+    bool Push(const T& item) {
+        uint32_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) >= CAPACITY) {
+            dropped_count_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        items_[head & (CAPACITY - 1)] = item;
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Takes the oldest record, must only be called by the single
+     * consumer
+     *
+     * @return true : if a record was taken
+     * @return false : if the ring is empty
+     */
+    bool Pop(T& item) {
+        uint32_t tail = tail_.load(std::memory_order_relaxed);
+        if (head_.load(std::memory_order_acquire) == tail) {
+            return false;
+        }
+        item = items_[tail & (CAPACITY - 1)];
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Returns the number of records dropped because the ring was full
+     *
+     */
+    uint32_t GetDroppedCount() const { return dropped_count_.load(std::memory_order_relaxed); }
+
+   private:
+    // free running, their difference is the fill level
+    std::atomic<uint32_t> head_;
+    std::atomic<uint32_t> tail_;
+    std::atomic<uint32_t> dropped_count_;
+    T items_[CAPACITY];
+};
+
+#endif
@@ -14,6 +14,9 @@
 
 #include <Preferences.h>
 
+#include <algorithm>
+#include <iterator>
+
 #include "../config/config.h"
 #include "../logging/logging.h"
 
@@ -50,8 +53,15 @@ bool Storage::SaveCalibParam(const CONFIG_SET::CALIB_PARAMS* calib_param) {
     size_t status_direc = preferences_.putBool(CONFIG_SET::KEY_DIRECTION.c_str(), calib_param->DIRECTION);
     size_t status_total_step =
         preferences_.putInt(CONFIG_SET::KEY_TOTAL_STEP_COUNT.c_str(), calib_param->TOTAL_STEP_COUNT);
+    size_t status_sg_threshold = preferences_.putInt(CONFIG_SET::KEY_SG_THRESHOLD.c_str(), calib_param->SG_THRESHOLD);
+    size_t status_sg_margin = preferences_.putInt(CONFIG_SET::KEY_SG_MARGIN.c_str(), calib_param->SG_MARGIN);
+    size_t status_percent_map = preferences_.putBytes(CONFIG_SET::KEY_PERCENT_MAP.c_str(), calib_param->PERCENT_MAP,
+                                                      sizeof(calib_param->PERCENT_MAP));
+    size_t status_percent_marks =
+        preferences_.putUInt(CONFIG_SET::KEY_PERCENT_MARKS.c_str(), calib_param->PERCENT_MARKS);
     preferences_.end();
-    if (status_direc == 0 || status_total_step == 0) {
+    if (status_direc == 0 || status_total_step == 0 || status_sg_threshold == 0 || status_sg_margin == 0 ||
+        status_percent_map == 0 || status_percent_marks == 0) {
         return false;
     }
     return true;
@@ -61,6 +71,19 @@ bool Storage::PopulateCalibParam(CONFIG_SET::CALIB_PARAMS* calib_param) {
     preferences_.begin(CONFIG_SET::STORAGE_NAMESPACE.c_str(), false);
     calib_param->TOTAL_STEP_COUNT = preferences_.getInt(CONFIG_SET::KEY_TOTAL_STEP_COUNT.c_str(), -1);
     calib_param->DIRECTION = preferences_.getBool(CONFIG_SET::KEY_DIRECTION.c_str(), false);
+    // units calibrated before StallGuard tuning fall back to the fleet default
+    calib_param->SG_THRESHOLD =
+        preferences_.getInt(CONFIG_SET::KEY_SG_THRESHOLD.c_str(), CONFIG_SET::MOTOR_DRIVER_SG_THRESH);
+    calib_param->SG_MARGIN = preferences_.getInt(CONFIG_SET::KEY_SG_MARGIN.c_str(), 0);
+    // a missing map or one stored with a different knot count falls back to linear
+    if (preferences_.getBytesLength(CONFIG_SET::KEY_PERCENT_MAP.c_str()) == sizeof(calib_param->PERCENT_MAP)) {
+        preferences_.getBytes(CONFIG_SET::KEY_PERCENT_MAP.c_str(), calib_param->PERCENT_MAP,
+                              sizeof(calib_param->PERCENT_MAP));
+        calib_param->PERCENT_MARKS = preferences_.getUInt(CONFIG_SET::KEY_PERCENT_MARKS.c_str(), 0);
+    } else {
+        std::fill(std::begin(calib_param->PERCENT_MAP), std::end(calib_param->PERCENT_MAP), 0);
+        calib_param->PERCENT_MARKS = 0;
+    }
     preferences_.end();
     if (calib_param->TOTAL_STEP_COUNT == -1) {
         return false;
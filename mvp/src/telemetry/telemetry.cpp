@@ -0,0 +1,54 @@
+/**
+ * @file telemetry.cpp
+ * @author Dhiraj Deshmukh (deshmukhdhiraj15@gmail.com)
+ * @brief Contains the move telemetry ring buffer and its binary export
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include "telemetry.h"
+
+#include <cstring>
+
+TelemetryRecorder::TelemetryRecorder() : head_(0), count_(0), overwritten_(0) {}
+
+void TelemetryRecorder::Record(const TELEMETRY_RECORD& record) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    records_[head_] = record;
+    head_ = (head_ + 1) % CAPACITY;
+    if (count_ < CAPACITY) {
+        count_++;
+    } else {
+        overwritten_++;
+    }
+}
+
+void TelemetryRecorder::Clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    head_ = 0;
+    count_ = 0;
+    overwritten_ = 0;
+}
+
+void TelemetryRecorder::Export(std::vector<uint8_t>& blob) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    TELEMETRY_HEADER header;
+    header.MAGIC = MAGIC;
+    header.VERSION = VERSION;
+    header.RECORD_SIZE = sizeof(TELEMETRY_RECORD);
+    header.RECORD_COUNT = count_;
+    header.OVERWRITTEN = overwritten_;
+
+    blob.resize(sizeof(header) + count_ * sizeof(TELEMETRY_RECORD));
+    std::memcpy(blob.data(), &header, sizeof(header));
+    // the ring is copied in at most two contiguous parts
+    int tail = (head_ + CAPACITY - count_) % CAPACITY;
+    int first_part = (tail + count_ <= CAPACITY) ? count_ : (CAPACITY - tail);
+    uint8_t* out = blob.data() + sizeof(header);
+    std::memcpy(out, &records_[tail], first_part * sizeof(TELEMETRY_RECORD));
+    std::memcpy(out + first_part * sizeof(TELEMETRY_RECORD), &records_[0],
+                (count_ - first_part) * sizeof(TELEMETRY_RECORD));
+}
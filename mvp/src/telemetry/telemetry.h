@@ -0,0 +1,99 @@
+/**
+ * @file telemetry.h
+ * @author Mahimana Bhatt (mahimanabhatt@gmail.com)
+ * @brief Defines a fixed size ring buffer recording the course of every move,
+ * pure C++ without any Arduino dependency
+ *
+ * The motor driver handler is the only writer, the web server task exports a
+ * copy. Recording is a copy of 16 bytes under an uncontended mutex and never
+ * allocates, when the ring is full the oldest records are overwritten.
+ *
+ * Export format (little endian):
+ *
+ *   TELEMETRY_HEADER                          16 bytes
+ *   TELEMETRY_RECORD[RECORD_COUNT]            16 bytes each, oldest first
+ *
+ * A move starts with a MOVE_START record and ends with one of the STOP_*
+ * records, all records of a move carry the same MOVE_ID.
+ *
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef _TELEMETRY_INCLUDE_GUARD
+#define _TELEMETRY_INCLUDE_GUARD
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+enum class TELEMETRY_EVENT : uint8_t {
+    SAMPLE,
+    MOVE_START,
+    STOP_DESTINATION,
+    STOP_STALL,
+    STOP_TIMEOUT,
+    STOP_CANCEL,
+    STOP_RETARGET,
+};
+
+struct TELEMETRY_RECORD {
+    uint32_t TIME_US;
+    int32_t STEP;
+    int16_t VELOCITY;  // microsteps / s, negative while the steps decrease
+    uint16_t SG_RESULT;
+    uint8_t CS_ACTUAL;
+    TELEMETRY_EVENT EVENT;
+    uint16_t MOVE_ID;
+};
+
+struct TELEMETRY_HEADER {
+    uint32_t MAGIC;
+    uint16_t VERSION;
+    uint16_t RECORD_SIZE;
+    uint32_t RECORD_COUNT;
+    uint32_t OVERWRITTEN;  // records lost to the ring wrapping around
+};
+
+static_assert(sizeof(TELEMETRY_RECORD) == 16, "telemetry record layout is part of the export format");
+static_assert(sizeof(TELEMETRY_HEADER) == 16, "telemetry header layout is part of the export format");
+
+class TelemetryRecorder {
+   public:
+    static const uint32_t MAGIC = 0x4D4C5454;  // "TTLM"
+    static const uint16_t VERSION = 1;
+    static const int CAPACITY = 512;
+
+    TelemetryRecorder();
+
+    /**
+     * @brief Appends a record, overwrites the oldest one if full
+     *
+     */
+    void Record(const TELEMETRY_RECORD& record);
+
+    /**
+     * @brief Drops all records
+     *
+     */
+    void Clear();
+
+    /**
+     * @brief Copies header and records, oldest first, into a binary blob
+     *
+     * @param blob: replaced by the export
+     */
+    void Export(std::vector<uint8_t>& blob);
+
+   private:
+    TELEMETRY_RECORD records_[CAPACITY];
+    int head_;
+    int count_;
+    uint32_t overwritten_;
+    std::mutex mutex_;
+};
+
+#endif